@@ -0,0 +1,243 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+#include "CpuProfiler.h"
+
+
+// Headless benchmark mode, enabled with --benchmark[=frames] on the command line (--benchmark-output=file.json picks
+// the report file, benchmark.json by default). The window is created hidden, without vsync, and the GLFW clock is
+// driven at a fixed 60 Hz step so everything animated from glfwGetTime() and deltaTime plays out identically on every
+// run. The camera follows a scripted loop around its start position. After a few warm-up frames every frame is timed
+// up to and including glFinish, and the report holds the frame-time distribution, draw calls and the load time.
+// Without a display, run it under Xvfb with LIBGL_ALWAYS_SOFTWARE=1 to get Mesa's llvmpipe; a GLFW built with OSMesa
+// (3.3 and newer) creates an OSMesa context instead and needs no display at all.
+class Benchmark
+{
+public:
+    /*  Options  */
+    GLboolean Enabled;
+    GLuint Frames;                      // Measured frames
+    GLuint WarmupFrames;                // Rendered first and not measured (driver shader compiles, texture uploads)
+    GLfloat TimeStep;                   // Seconds of scene time per frame
+    GLboolean ScriptedCamera;           // Turn off to leave the camera to something else, like an input replay
+    std::string Name;
+    std::string OutputPath;
+
+    /*  Functions  */
+    // Constructor, reads the options from the command line. Construct it first thing in main() so the load time
+    // covers the whole setup.
+    Benchmark(int argc, char* argv[], const std::string& name)
+        : Enabled(false), Frames(600), WarmupFrames(10), TimeStep(1.0f / 60.0f), ScriptedCamera(true), Name(name),
+          OutputPath("benchmark.json"), frame(0), drawCallFrames(0), drawCalls(0), cameraStored(false), loadMs(0.0),
+          loadStart(std::chrono::steady_clock::now())
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (std::strncmp(argv[i], "--benchmark-output=", 19) == 0)
+                this->OutputPath = argv[i] + 19;
+            else if (std::strcmp(argv[i], "--benchmark") == 0)
+                this->Enabled = true;
+            else if (std::strncmp(argv[i], "--benchmark=", 12) == 0)
+            {
+                this->Enabled = true;
+                this->Frames = std::max(1, std::atoi(argv[i] + 12));
+            }
+        }
+    }
+
+    // Call after the demo's own window hints
+    void WindowHints()
+    {
+        if (!this->Enabled)
+            return;
+        glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+#ifdef GLFW_OSMESA_CONTEXT_API
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
+    }
+
+    // Call first thing in the frame, before the frame time is read. Moves the camera along the scripted path.
+    void BeginFrame(Camera& camera)
+    {
+        if (!this->Enabled)
+            return;
+        if (!this->ScriptedCamera)
+        {
+            this->BeginFrame();
+            return;
+        }
+        if (!this->cameraStored)
+        {
+            this->startPosition = camera.Position;
+            this->startYaw = camera.Yaw;
+            this->startPitch = camera.Pitch;
+            this->cameraStored = true;
+        }
+
+        // One full loop over the measured frames: look left and right, up and down, while circling the start position
+        GLfloat t = 2.0f * 3.14159265f * (GLfloat)this->frame / (GLfloat)(this->WarmupFrames + this->Frames);
+        camera.Yaw = this->startYaw + 30.0f * std::sin(t);
+        camera.Pitch = this->startPitch + 10.0f * std::sin(2.0f * t);
+        camera.ProcessMouseMovement(0.0f, 0.0f);    // Recomputes the camera vectors from the angles
+        camera.Position = this->startPosition + camera.Right * (1.5f * std::sin(t)) + camera.Front * (1.0f - std::cos(t));
+        this->BeginFrame();
+    }
+
+    // For demos without a camera
+    void BeginFrame()
+    {
+        if (!this->Enabled)
+            return;
+        if (this->frame == 0)
+        {
+            this->loadMs = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - this->loadStart).count();
+            glfwSwapInterval(0);
+            const GLubyte* renderer = glGetString(GL_RENDERER);
+            const GLubyte* version = glGetString(GL_VERSION);
+            this->renderer = renderer ? (const char*)renderer : "";
+            this->version = version ? (const char*)version : "";
+        }
+        glfwSetTime(this->frame * (GLdouble)this->TimeStep);
+        this->frameStart = std::chrono::steady_clock::now();
+    }
+
+    // Call after swapping the buffers, with the frame's draw calls when the demo counts them. Writes the report and
+    // closes the window once all frames are done, or writes it early when the window is closing anyway.
+    void EndFrame(GLFWwindow* window, GLint frameDrawCalls = -1)
+    {
+        if (!this->Enabled)
+            return;
+        glFinish();
+        GLdouble ms = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - this->frameStart).count();
+        if (this->frame >= this->WarmupFrames)
+        {
+            this->frameTimes.push_back(ms);
+            if (frameDrawCalls >= 0)
+            {
+                this->drawCalls += frameDrawCalls;
+                this->drawCallFrames++;
+            }
+        }
+        this->frame++;
+        if (this->frame == this->WarmupFrames + this->Frames || glfwWindowShouldClose(window))
+        {
+            this->WriteReport();
+            glfwSetWindowShouldClose(window, GL_TRUE);
+        }
+    }
+
+    // Same with named per-frame counters, like RenderStats::Counters(); their averages go into the report and a
+    // "draw_calls" counter stands in for the draw call count
+    void EndFrame(GLFWwindow* window, const std::vector<std::pair<std::string, GLdouble> >& counters)
+    {
+        if (!this->Enabled)
+            return;
+        GLint frameDrawCalls = -1;
+        for (GLuint i = 0; i < counters.size(); i++)
+        {
+            if (counters[i].first == "draw_calls")
+                frameDrawCalls = (GLint)counters[i].second;
+            if (this->frame < this->WarmupFrames)
+                continue;
+            GLuint c = 0;
+            while (c < this->counters.size() && this->counters[c].first != counters[i].first)
+                c++;
+            if (c == this->counters.size())
+                this->counters.push_back(std::make_pair(counters[i].first, 0.0));
+            this->counters[c].second += counters[i].second;
+        }
+        this->EndFrame(window, frameDrawCalls);
+    }
+
+    bool WriteReport()
+    {
+        std::ofstream file(this->OutputPath.c_str());
+        if (!file)
+        {
+            std::cout << "ERROR::BENCHMARK:: Can't write " << this->OutputPath << std::endl;
+            return false;
+        }
+        std::vector<GLdouble> sorted(this->frameTimes);
+        std::sort(sorted.begin(), sorted.end());
+        GLdouble total = 0.0;
+        for (GLuint i = 0; i < sorted.size(); i++)
+            total += sorted[i];
+        GLdouble average = sorted.empty() ? 0.0 : total / sorted.size();
+
+        file << "{\n"
+             << "  \"demo\": \"" << CpuProfiler::EscapeJson(this->Name) << "\",\n"
+             << "  \"renderer\": \"" << CpuProfiler::EscapeJson(this->renderer) << "\",\n"
+             << "  \"gl_version\": \"" << CpuProfiler::EscapeJson(this->version) << "\",\n"
+             << "  \"frames\": " << sorted.size() << ",\n"
+             << "  \"warmup_frames\": " << this->WarmupFrames << ",\n"
+             << "  \"load_ms\": " << this->loadMs << ",\n"
+             << "  \"frame_ms\": {\n"
+             << "    \"min\": " << percentile(sorted, 0.0) << ",\n"
+             << "    \"avg\": " << average << ",\n"
+             << "    \"p50\": " << percentile(sorted, 0.5) << ",\n"
+             << "    \"p90\": " << percentile(sorted, 0.9) << ",\n"
+             << "    \"p95\": " << percentile(sorted, 0.95) << ",\n"
+             << "    \"p99\": " << percentile(sorted, 0.99) << ",\n"
+             << "    \"max\": " << percentile(sorted, 1.0) << "\n"
+             << "  },\n"
+             << "  \"fps_avg\": " << (average > 0.0 ? 1000.0 / average : 0.0) << ",\n"
+             << "  \"draw_calls_per_frame\": ";
+        if (this->drawCallFrames > 0)
+            file << (GLdouble)this->drawCalls / this->drawCallFrames;
+        else
+            file << "null";
+        if (!this->counters.empty())
+        {
+            file << ",\n  \"render_stats\": {";
+            for (GLuint i = 0; i < this->counters.size(); i++)
+                file << (i == 0 ? "\n" : ",\n") << "    \"" << CpuProfiler::EscapeJson(this->counters[i].first) << "\": "
+                     << (sorted.empty() ? 0.0 : this->counters[i].second / sorted.size());
+            file << "\n  }";
+        }
+        file << ",\n  \"frame_times_ms\": [";
+        for (GLuint i = 0; i < this->frameTimes.size(); i++)
+            file << (i == 0 ? "" : ", ") << this->frameTimes[i];
+        file << "]\n}\n";
+
+        std::cout << "Benchmark " << this->Name << ": " << average << " ms average, " << percentile(sorted, 0.99)
+                  << " ms p99 over " << sorted.size() << " frames, written to " << this->OutputPath << std::endl;
+        return true;
+    }
+
+private:
+    GLuint frame;
+    GLuint drawCallFrames;
+    unsigned long long drawCalls;
+    std::vector<GLdouble> frameTimes;
+    std::vector<std::pair<std::string, GLdouble> > counters;    // Sums over the measured frames
+    bool cameraStored;
+    glm::vec3 startPosition;
+    GLfloat startYaw, startPitch;
+    GLdouble loadMs;
+    std::string renderer, version;
+    std::chrono::steady_clock::time_point loadStart, frameStart;
+
+    // Nearest-rank percentile of sorted values
+    static GLdouble percentile(const std::vector<GLdouble>& sorted, GLdouble p)
+    {
+        if (sorted.empty())
+            return 0.0;
+        GLuint rank = (GLuint)std::ceil(p * sorted.size());
+        return sorted[rank > 0 ? rank - 1 : 0];
+    }
+};
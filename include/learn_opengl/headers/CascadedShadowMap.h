@@ -0,0 +1,157 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <cmath>
+#include <algorithm>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "Frustum.h"
+
+
+// Splits the camera frustum into depth slices and gives each slice its own orthographic light projection, rendered
+// into one layer of a depth texture array. Slices are fitted with a bounding sphere, so their size doesn't change
+// when the camera turns, and the projection is moved in whole texels, so static shadows don't shimmer while the
+// camera moves. The light's depth range comes from the scene bounds, so casters outside a slice still cast into it.
+class CascadedShadowMap
+{
+public:
+    /*  Cascade Data  */
+    GLuint CascadeCount;
+    GLuint Resolution;                          // Width and height of every cascade
+    GLfloat ShadowDistance;                     // Shadows end this far from the camera
+    GLfloat SplitLambda;                        // 0 = uniform splits, 1 = logarithmic splits
+    GLuint FBO;
+    GLuint DepthMaps;                           // GL_TEXTURE_2D_ARRAY with one layer per cascade
+    std::vector<GLfloat> SplitDepths;           // View-space depth where each cascade ends
+    std::vector<glm::mat4> LightSpaceMatrices;
+    std::vector<Frustum> LightFrustums;         // Per cascade, for culling its casters
+
+    /*  Functions  */
+    // Constructor
+    CascadedShadowMap(GLuint cascadeCount = 4, GLuint resolution = 512, GLfloat shadowDistance = 30.0f, GLfloat splitLambda = 0.75f)
+        : CascadeCount(cascadeCount), Resolution(resolution), ShadowDistance(shadowDistance), SplitLambda(splitLambda),
+          SplitDepths(cascadeCount), LightSpaceMatrices(cascadeCount), LightFrustums(cascadeCount)
+    {
+        glGenTextures(1, &this->DepthMaps);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, this->DepthMaps);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, cascadeCount, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        GLfloat borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
+        glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glGenFramebuffers(1, &this->FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->DepthMaps, 0, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Cascaded shadow map framebuffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Fits every cascade to its slice of the camera frustum. 'lightDir' points from the light into the scene.
+    void Update(const glm::mat4& view, const glm::mat4& projection, GLfloat nearPlane, GLfloat farPlane,
+                const glm::vec3& lightDir, const glm::vec3& sceneMin, const glm::vec3& sceneMax)
+    {
+        // World-space corners of the camera frustum, near corners first
+        glm::mat4 inverseViewProjection = glm::inverse(projection * view);
+        glm::vec3 corners[8];
+        for (GLuint i = 0; i < 8; i++)
+        {
+            glm::vec4 p = inverseViewProjection * glm::vec4(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f, 1.0f);
+            corners[i] = glm::vec3(p) / p.w;
+        }
+
+        // Practical split scheme: blend of logarithmic and uniform split depths
+        GLfloat shadowFar = std::min(this->ShadowDistance, farPlane);
+        for (GLuint i = 0; i < this->CascadeCount; i++)
+        {
+            GLfloat f = (GLfloat)(i + 1) / (GLfloat)this->CascadeCount;
+            GLfloat logarithmic = nearPlane * std::pow(shadowFar / nearPlane, f);
+            GLfloat uniform = nearPlane + (shadowFar - nearPlane) * f;
+            this->SplitDepths[i] = this->SplitLambda * logarithmic + (1.0f - this->SplitLambda) * uniform;
+        }
+
+        // A fixed light rotation (independent of the cascade position) keeps the texel grid stable
+        glm::vec3 up = std::fabs(lightDir.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), lightDir, up);
+
+        // Depth range of the whole scene along the light direction
+        GLfloat sceneNearZ = -1e30f, sceneFarZ = 1e30f;
+        for (GLuint i = 0; i < 8; i++)
+        {
+            glm::vec3 corner(i & 1 ? sceneMax.x : sceneMin.x, i & 2 ? sceneMax.y : sceneMin.y, i & 4 ? sceneMax.z : sceneMin.z);
+            GLfloat z = (lightRotation * glm::vec4(corner, 1.0f)).z;
+            sceneNearZ = std::max(sceneNearZ, z);
+            sceneFarZ = std::min(sceneFarZ, z);
+        }
+
+        GLfloat sliceNear = nearPlane;
+        for (GLuint i = 0; i < this->CascadeCount; i++)
+        {
+            // Corners of this slice, found along the frustum's edges (depth is linear along each edge)
+            GLfloat t0 = (sliceNear - nearPlane) / (farPlane - nearPlane);
+            GLfloat t1 = (this->SplitDepths[i] - nearPlane) / (farPlane - nearPlane);
+            glm::vec3 slice[8];
+            glm::vec3 center(0.0f);
+            for (GLuint j = 0; j < 4; j++)
+            {
+                slice[j] = corners[j] + (corners[j + 4] - corners[j]) * t0;
+                slice[j + 4] = corners[j] + (corners[j + 4] - corners[j]) * t1;
+                center += slice[j] + slice[j + 4];
+            }
+            center /= 8.0f;
+            GLfloat radius = 0.0f;
+            for (GLuint j = 0; j < 8; j++)
+                radius = std::max(radius, glm::length(slice[j] - center));
+            // Quantize the radius so floating point noise doesn't change the projection from frame to frame
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            // Move the projection center in whole shadow-map texels
+            glm::vec3 lightCenter(lightRotation * glm::vec4(center, 1.0f));
+            GLfloat texel = 2.0f * radius / (GLfloat)this->Resolution;
+            lightCenter.x = std::floor(lightCenter.x / texel) * texel;
+            lightCenter.y = std::floor(lightCenter.y / texel) * texel;
+
+            glm::mat4 lightProjection = glm::ortho(lightCenter.x - radius, lightCenter.x + radius,
+                                                   lightCenter.y - radius, lightCenter.y + radius,
+                                                   -sceneNearZ - 0.5f, -sceneFarZ + 0.5f);
+            this->LightSpaceMatrices[i] = lightProjection * lightRotation;
+            this->LightFrustums[i].Extract(this->LightSpaceMatrices[i]);
+            sliceNear = this->SplitDepths[i];
+        }
+    }
+
+    // Binds the layer of one cascade as depth target and sets the viewport to it
+    void BindCascade(GLuint cascade)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, this->DepthMaps, 0, cascade);
+        glViewport(0, 0, this->Resolution, this->Resolution);
+    }
+
+    // Sets cascadeCount, cascadeSplits[] and cascadeMatrices[] on the given (active) program
+    void SetUniforms(GLuint program)
+    {
+        glUniform1i(glGetUniformLocation(program, "cascadeCount"), this->CascadeCount);
+        for (GLuint i = 0; i < this->CascadeCount; i++)
+        {
+            std::stringstream index;
+            index << "[" << i << "]";
+            glUniform1f(glGetUniformLocation(program, ("cascadeSplits" + index.str()).c_str()), this->SplitDepths[i]);
+            glUniformMatrix4fv(glGetUniformLocation(program, ("cascadeMatrices" + index.str()).c_str()), 1, GL_FALSE, glm::value_ptr(this->LightSpaceMatrices[i]));
+        }
+    }
+};
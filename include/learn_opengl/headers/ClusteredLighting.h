@@ -0,0 +1,353 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "PointLight.h"
+#include "JobSystem.h"
+#include "CpuProfiler.h"
+
+// SIMD Includes, SSE2 which every x64 build has
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CLUSTERED_LIGHTING_SSE 1
+#include <emmintrin.h>
+#endif
+
+
+// Clustered forward shading. The view frustum is split into a grid of TilesX x TilesY screen tiles and Slices depth
+// slices (exponentially spaced, so clusters stay roughly cube shaped), and every frame each point light is assigned
+// to the clusters its influence sphere touches; the radius comes from the light's attenuation (PointLight::Radius).
+// The fragment shader looks up the cluster of its pixel and depth and only evaluates the lights listed there.
+//
+// The assignment runs on the CPU: the lights are bounded in cluster index space first, then the depth slices are
+// handed out to the JobSystem (every slice owns its clusters, so no locking) and each light is tested against a row
+// of clusters four at a time with SSE. The results go to the GPU as three buffer textures (core since GL 3.1):
+//   lightData     RGBA32F, 4 texels per light: position + radius, ambient + constant, diffuse + linear,
+//                 specular + quadratic
+//   clusterGrid   RG32UI, per cluster the offset and count of its lights in lightIndices
+//   lightIndices  R16UI, light indices
+// Clusters hold at most MaxLightsPerCluster lights, which bounds the per-fragment cost however many lights there are.
+// Requires a symmetric perspective projection, like glm::perspective.
+class ClusteredLighting
+{
+public:
+    static const GLuint MaxLights = 65535;  // Light indices are 16 bit
+
+    /*  Options  */
+    GLuint TilesX, TilesY, Slices;
+    GLuint MaxLightsPerCluster;
+    GLfloat Threshold;                      // Contribution below which a light is cut off, see PointLight::Radius
+
+    /*  Lights  */
+    std::vector<PointLight> Lights;
+
+    /*  Statistics of the last Update  */
+    GLuint VisibleLights;                   // Lights that touch at least the view frustum's bounds
+    GLuint LightIndices;                    // Entries in all cluster lists together
+    GLuint MaxClusterLights;                // Longest cluster list
+    GLuint OverflowedClusters;              // Clusters that hit MaxLightsPerCluster
+    GLdouble AssignMs;                      // CPU time of the assignment
+
+    /*  Functions  */
+    // Constructor, needs a current GL context. Without a job system the assignment runs on the calling thread.
+    ClusteredLighting(JobSystem* jobs = NULL, GLuint tilesX = 16, GLuint tilesY = 9, GLuint slices = 24)
+        : TilesX(tilesX), TilesY(tilesY), Slices(slices), MaxLightsPerCluster(128), Threshold(1.0f / 256.0f),
+          VisibleLights(0), LightIndices(0), MaxClusterLights(0), OverflowedClusters(0), AssignMs(0.0), jobs(jobs),
+          near(0.0f), far(0.0f), p00(0.0f), p11(0.0f)
+    {
+        GLint maxTexels = 65536;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        this->maxIndices = (GLuint)maxTexels;
+        const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+        glGenBuffers(3, this->buffers);
+        glGenTextures(3, this->textures);
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, this->buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+            glBindTexture(GL_TEXTURE_BUFFER, this->textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], this->buffers[i]);
+        }
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ~ClusteredLighting() { this->Release(); }
+
+    // Deletes the cluster buffers and their textures; Update and Bind can't be called afterwards. Call it while the
+    // context is still current when the lighting outlives it.
+    void Release()
+    {
+        if (this->textures[0] != 0)
+            glDeleteTextures(3, this->textures);
+        if (this->buffers[0] != 0)
+            glDeleteBuffers(3, this->buffers);
+        for (GLuint i = 0; i < 3; i++)
+            this->textures[i] = this->buffers[i] = 0;
+    }
+
+    // Assigns the lights to the clusters of this view and uploads the result. 'near' and 'far' must be the planes
+    // the projection was built with.
+    void Update(const glm::mat4& view, const glm::mat4& projection, GLfloat near, GLfloat far)
+    {
+        CPU_PROFILE_ZONE("Clustered light assignment");
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        if (this->Lights.size() > MaxLights)
+            this->Lights.resize(MaxLights);
+        if (near != this->near || far != this->far || projection[0][0] != this->p00 || projection[1][1] != this->p11
+            || this->TilesX * this->Slices != this->sliceMinX.size() || this->TilesY * this->Slices != this->sliceMinY.size())
+            this->buildClusters(projection, near, far);
+
+        this->boundLights(view);
+        GLuint clusterCount = this->TilesX * this->TilesY * this->Slices;
+        this->clusterLights.resize(clusterCount);
+        if (this->jobs)
+            this->jobs->ParallelFor(this->Slices, 1, [this](GLuint begin, GLuint end)
+            {
+                for (GLuint slice = begin; slice < end; slice++)
+                    this->assignSlice(slice);
+            });
+        else
+            for (GLuint slice = 0; slice < this->Slices; slice++)
+                this->assignSlice(slice);
+
+        // Concatenate the cluster lists
+        this->grid.resize(2 * clusterCount);
+        this->indices.clear();
+        this->MaxClusterLights = this->OverflowedClusters = 0;
+        for (GLuint c = 0; c < clusterCount; c++)
+        {
+            const std::vector<GLushort>& list = this->clusterLights[c];
+            GLuint count = std::min((GLuint)list.size(), this->maxIndices - (GLuint)this->indices.size());
+            this->grid[2 * c] = (GLuint)this->indices.size();
+            this->grid[2 * c + 1] = count;
+            this->indices.insert(this->indices.end(), list.begin(), list.begin() + count);
+            this->MaxClusterLights = std::max(this->MaxClusterLights, count);
+            if (list.size() >= this->MaxLightsPerCluster)
+                this->OverflowedClusters++;
+        }
+        this->LightIndices = (GLuint)this->indices.size();
+        this->upload();
+        this->AssignMs = std::chrono::duration<GLdouble, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // Binds the three buffer textures to texture units firstUnit..firstUnit+2 and sets the shader's cluster uniforms;
+    // call after Update, with the program in use. Leaves texture unit 0 active.
+    void Bind(GLuint program, GLuint firstUnit, GLuint width, GLuint height)
+    {
+        const GLchar* names[3] = { "lightData", "clusterGrid", "lightIndices" };
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+            glBindTexture(GL_TEXTURE_BUFFER, this->textures[i]);
+            glUniform1i(glGetUniformLocation(program, names[i]), firstUnit + i);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        glUniform3i(glGetUniformLocation(program, "clusterCount"), this->TilesX, this->TilesY, this->Slices);
+        glUniform2f(glGetUniformLocation(program, "tileSize"), (GLfloat)width / this->TilesX, (GLfloat)height / this->TilesY);
+        // slice = log(depth) * scale + bias
+        GLfloat scale = this->Slices / std::log(this->far / this->near);
+        glUniform2f(glGetUniformLocation(program, "sliceScaleBias"), scale, -std::log(this->near) * scale);
+    }
+
+    void PrintStats(std::ostream& out = std::cout) const
+    {
+        GLuint clusterCount = this->TilesX * this->TilesY * this->Slices;
+        out << "Clustered lighting: " << this->VisibleLights << " of " << this->Lights.size() << " lights visible, "
+            << this->LightIndices << " light indices over " << clusterCount << " clusters ("
+            << (GLfloat)this->LightIndices / clusterCount << " per cluster, at most " << this->MaxClusterLights << ", "
+            << this->OverflowedClusters << " clusters full), assigned in " << this->AssignMs << " ms" << std::endl;
+    }
+
+private:
+    // A light bounded in view space and in cluster index space
+    struct BoundedLight
+    {
+        GLushort Index;
+        GLfloat X, Y, Z, RadiusSquared;
+        GLuint FirstSlice, LastSlice, FirstX, LastX, FirstY, LastY;
+    };
+
+    JobSystem* jobs;
+    GLfloat near, far, p00, p11;
+    GLuint maxIndices;
+    GLuint buffers[3], textures[3];
+    // View-space cluster bounds. X only depends on the slice and the column, Y on the slice and the row, Z on the
+    // slice, so the bounds are kept per slice and column/row rather than per cluster.
+    std::vector<GLfloat> sliceMinX, sliceMaxX, sliceMinY, sliceMaxY, sliceNear, sliceFar;
+    std::vector<BoundedLight> bounded;
+    std::vector< std::vector<GLushort> > clusterLights;
+    std::vector<GLuint> grid;
+    std::vector<GLushort> indices;
+    std::vector<GLfloat> lightData;
+
+    GLfloat sliceDepth(GLuint slice) const
+    {
+        return this->near * std::pow(this->far / this->near, (GLfloat)slice / this->Slices);
+    }
+
+    GLuint sliceOf(GLfloat depth) const
+    {
+        GLfloat slice = std::log(depth / this->near) / std::log(this->far / this->near) * this->Slices;
+        return (GLuint)std::min(std::max(slice, 0.0f), (GLfloat)this->Slices - 1.0f);
+    }
+
+    // Index of the tile that normalized device coordinate 'ndc' falls in
+    static GLuint tileOf(GLfloat ndc, GLuint tiles)
+    {
+        GLfloat tile = (ndc * 0.5f + 0.5f) * tiles;
+        return (GLuint)std::min(std::max(tile, 0.0f), (GLfloat)tiles - 1.0f);
+    }
+
+    void buildClusters(const glm::mat4& projection, GLfloat near, GLfloat far)
+    {
+        this->near = near;
+        this->far = far;
+        this->p00 = projection[0][0];
+        this->p11 = projection[1][1];
+        this->sliceMinX.resize(this->Slices * this->TilesX);
+        this->sliceMaxX.resize(this->Slices * this->TilesX);
+        this->sliceMinY.resize(this->Slices * this->TilesY);
+        this->sliceMaxY.resize(this->Slices * this->TilesY);
+        this->sliceNear.resize(this->Slices);
+        this->sliceFar.resize(this->Slices);
+        for (GLuint s = 0; s < this->Slices; s++)
+        {
+            GLfloat dn = this->sliceDepth(s), df = this->sliceDepth(s + 1);
+            this->sliceNear[s] = dn;
+            this->sliceFar[s] = df;
+            // A tile's edge at depth d lies at ndc * d / p (x and y view-space), so the bounds are spanned by both depths
+            for (GLuint x = 0; x < this->TilesX; x++)
+            {
+                GLfloat x0 = -1.0f + 2.0f * x / this->TilesX, x1 = -1.0f + 2.0f * (x + 1) / this->TilesX;
+                this->sliceMinX[s * this->TilesX + x] = std::min(x0 * dn, x0 * df) / this->p00;
+                this->sliceMaxX[s * this->TilesX + x] = std::max(x1 * dn, x1 * df) / this->p00;
+            }
+            for (GLuint y = 0; y < this->TilesY; y++)
+            {
+                GLfloat y0 = -1.0f + 2.0f * y / this->TilesY, y1 = -1.0f + 2.0f * (y + 1) / this->TilesY;
+                this->sliceMinY[s * this->TilesY + y] = std::min(y0 * dn, y0 * df) / this->p11;
+                this->sliceMaxY[s * this->TilesY + y] = std::max(y1 * dn, y1 * df) / this->p11;
+            }
+        }
+    }
+
+    // Moves the lights to view space and bounds them by slices and tiles; drops the ones outside the frustum
+    void boundLights(const glm::mat4& view)
+    {
+        this->bounded.clear();
+        this->lightData.resize(16 * this->Lights.size());
+        for (GLuint i = 0; i < this->Lights.size(); i++)
+        {
+            const PointLight& light = this->Lights[i];
+            GLfloat radius = light.Radius(this->Threshold);
+            light.Pack(&this->lightData[16 * i], radius);
+
+            glm::vec3 p = glm::vec3(view * glm::vec4(light.Position, 1.0f));
+            GLfloat depth = -p.z;
+            if (radius <= 0.0f || depth + radius < this->near || depth - radius > this->far)
+                continue;
+            BoundedLight b;
+            b.Index = (GLushort)i;
+            b.X = p.x;
+            b.Y = p.y;
+            b.Z = p.z;
+            b.RadiusSquared = radius * radius;
+            b.FirstSlice = this->sliceOf(std::max(depth - radius, this->near));
+            b.LastSlice = this->sliceOf(std::min(depth + radius, this->far));
+            if (depth - radius <= this->near)
+            {
+                // The sphere reaches the camera plane, it may cover any tile
+                b.FirstX = b.FirstY = 0;
+                b.LastX = this->TilesX - 1;
+                b.LastY = this->TilesY - 1;
+            }
+            else
+            {
+                // Screen bounds of the sphere's bounding box: its nearest and farthest depth bound every corner
+                GLfloat dn = depth - radius, df = depth + radius;
+                GLfloat minX = this->p00 * std::min((p.x - radius) / dn, (p.x - radius) / df);
+                GLfloat maxX = this->p00 * std::max((p.x + radius) / dn, (p.x + radius) / df);
+                GLfloat minY = this->p11 * std::min((p.y - radius) / dn, (p.y - radius) / df);
+                GLfloat maxY = this->p11 * std::max((p.y + radius) / dn, (p.y + radius) / df);
+                if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+                    continue;
+                b.FirstX = tileOf(minX, this->TilesX);
+                b.LastX = tileOf(maxX, this->TilesX);
+                b.FirstY = tileOf(minY, this->TilesY);
+                b.LastY = tileOf(maxY, this->TilesY);
+            }
+            this->bounded.push_back(b);
+        }
+        this->VisibleLights = (GLuint)this->bounded.size();
+    }
+
+    // Sphere against cluster box tests for every light overlapping the slice
+    void assignSlice(GLuint slice)
+    {
+        for (GLuint y = 0; y < this->TilesY; y++)
+            for (GLuint x = 0; x < this->TilesX; x++)
+                this->clusterLights[(slice * this->TilesY + y) * this->TilesX + x].clear();
+
+        const GLfloat* minX = &this->sliceMinX[slice * this->TilesX];
+        const GLfloat* maxX = &this->sliceMaxX[slice * this->TilesX];
+        GLfloat minZ = -this->sliceFar[slice], maxZ = -this->sliceNear[slice];
+        for (GLuint i = 0; i < this->bounded.size(); i++)
+        {
+            const BoundedLight& light = this->bounded[i];
+            if (slice < light.FirstSlice || slice > light.LastSlice)
+                continue;
+            GLfloat dz = std::max(minZ - light.Z, 0.0f) + std::max(light.Z - maxZ, 0.0f);
+            for (GLuint y = light.FirstY; y <= light.LastY; y++)
+            {
+                GLfloat minY = this->sliceMinY[slice * this->TilesY + y], maxY = this->sliceMaxY[slice * this->TilesY + y];
+                GLfloat dy = std::max(minY - light.Y, 0.0f) + std::max(light.Y - maxY, 0.0f);
+                // Squared distance left over for x, the rest of the row shares y and z
+                GLfloat remaining = light.RadiusSquared - dy * dy - dz * dz;
+                if (remaining < 0.0f)
+                    continue;
+                std::vector<GLushort>* row = &this->clusterLights[(slice * this->TilesY + y) * this->TilesX];
+                GLuint x = light.FirstX;
+#if CLUSTERED_LIGHTING_SSE
+                const __m128 cx = _mm_set1_ps(light.X), r2 = _mm_set1_ps(remaining), zero = _mm_setzero_ps();
+                for (; x + 4 <= light.LastX + 1; x += 4)
+                {
+                    __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(minX + x), cx), zero),
+                                           _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(maxX + x)), zero));
+                    GLint hits = _mm_movemask_ps(_mm_cmple_ps(_mm_mul_ps(dx, dx), r2));
+                    for (GLuint k = 0; hits != 0; k++, hits >>= 1)
+                        if ((hits & 1) && row[x + k].size() < this->MaxLightsPerCluster)
+                            row[x + k].push_back(light.Index);
+                }
+#endif
+                // Remaining columns (or all of them without SIMD support)
+                for (; x <= light.LastX; x++)
+                {
+                    GLfloat dx = std::max(minX[x] - light.X, 0.0f) + std::max(light.X - maxX[x], 0.0f);
+                    if (dx * dx <= remaining && row[x].size() < this->MaxLightsPerCluster)
+                        row[x].push_back(light.Index);
+                }
+            }
+        }
+    }
+
+    void upload()
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, this->buffers[0]);
+        glBufferData(GL_TEXTURE_BUFFER, std::max((size_t)16, this->lightData.size() * sizeof(GLfloat)),
+                     this->lightData.empty() ? NULL : &this->lightData[0], GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, this->buffers[1]);
+        glBufferData(GL_TEXTURE_BUFFER, this->grid.size() * sizeof(GLuint), &this->grid[0], GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, this->buffers[2]);
+        glBufferData(GL_TEXTURE_BUFFER, std::max((size_t)16, this->indices.size() * sizeof(GLushort)),
+                     this->indices.empty() ? NULL : &this->indices[0], GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+};
@@ -0,0 +1,319 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <string>
+#include <map>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+
+// GL Includes
+#include <GL/glew.h>
+
+// Timestamps come from the time stamp counter on x86 (a few cycles to read) and from std::chrono::steady_clock
+// elsewhere, or when CPU_PROFILER_STEADY_CLOCK is defined. Counter ticks are converted to time against steady_clock.
+#if !defined(CPU_PROFILER_STEADY_CLOCK) && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))
+#define CPU_PROFILER_RDTSC 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+
+// Scoped CPU zones. CPU_PROFILE_ZONE("name") times the rest of the enclosing scope; CPU_PROFILE_FRAME() closes a
+// frame on the main thread. Each thread writes its finished zones into its own ring buffer without locks or
+// allocations, so zones are cheap enough to leave in hot code. The rings are read on the main thread: at every frame
+// for the per-frame summary, and on demand for a Chrome trace_event file (chrome://tracing or ui.perfetto.dev).
+// Define LEARN_OPENGL_NO_CPU_PROFILER to compile every zone out; the profiler then simply records nothing.
+// Zone names must be string literals (or otherwise outlive the profiler), only their pointer is stored.
+class CpuProfiler
+{
+public:
+    static const GLuint RingSize = 1 << 15;    // Zones kept per thread (a power of two)
+
+    struct Zone
+    {
+        const char* Name;
+        unsigned long long Start, End;          // Ticks
+        GLuint Depth;                           // Zones open around it on the same thread
+    };
+
+    struct ZoneSummary
+    {
+        std::string Name;
+        GLuint Calls;
+        GLdouble TotalMs;                       // Inclusive of nested zones, summed over all threads
+        GLdouble MaxMs;
+        ZoneSummary() : Calls(0), TotalMs(0.0), MaxMs(0.0) { }
+    };
+
+    /*  Options  */
+    std::atomic<bool> Enabled;
+
+    /*  Statistics  */
+    GLuint Frames;
+
+    /*  Functions  */
+    static CpuProfiler& Instance()
+    {
+        static CpuProfiler profiler;
+        return profiler;
+    }
+
+    static unsigned long long Now()
+    {
+#if CPU_PROFILER_RDTSC
+        return __rdtsc();
+#else
+        return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // Names the calling thread in the trace
+    void SetThreadName(const std::string& name)
+    {
+        ThreadBuffer& buffer = this->threadBuffer();
+        std::lock_guard<std::mutex> guard(this->lock);
+        buffer.Name = name;
+    }
+
+    // Called by CpuProfileZone: opening returns the zone's nesting depth
+    GLuint EnterZone()
+    {
+        return this->threadBuffer().Depth++;
+    }
+
+    void LeaveZone(const char* name, unsigned long long start, GLuint depth)
+    {
+        unsigned long long end = Now();
+        ThreadBuffer& buffer = this->threadBuffer();
+        unsigned long long head = buffer.Head.load(std::memory_order_relaxed);
+        Zone& zone = buffer.Zones[head & (RingSize - 1)];
+        zone.Name = name;
+        zone.Start = start;
+        zone.End = end;
+        zone.Depth = depth;
+        // Publishes the slot to the reader
+        buffer.Head.store(head + 1, std::memory_order_release);
+        buffer.Depth--;
+    }
+
+    // Ends a frame: summarises the zones every thread finished since the previous call. Call on the main thread.
+    void EndFrame()
+    {
+        unsigned long long now = Now();
+        this->calibrate();
+        std::map<const char*, ZoneSummary> zones;
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            for (GLuint i = 0; i < this->buffers.size(); i++)
+            {
+                ThreadBuffer& buffer = *this->buffers[i];
+                std::vector<Zone> finished;
+                buffer.Summarized = this->read(buffer, buffer.Summarized, finished);
+                for (GLuint j = 0; j < finished.size(); j++)
+                {
+                    ZoneSummary& summary = zones[finished[j].Name];
+                    GLdouble ms = this->toMicroseconds(finished[j].End - finished[j].Start) / 1000.0;
+                    summary.Name = finished[j].Name;
+                    summary.Calls++;
+                    summary.TotalMs += ms;
+                    summary.MaxMs = std::max(summary.MaxMs, ms);
+                }
+            }
+            this->frameEnds[this->Frames % RingSize] = now;
+        }
+        this->lastFrame.clear();
+        for (std::map<const char*, ZoneSummary>::iterator it = zones.begin(); it != zones.end(); ++it)
+            this->lastFrame.push_back(it->second);
+        std::sort(this->lastFrame.begin(), this->lastFrame.end(),
+            [](const ZoneSummary& a, const ZoneSummary& b) { return a.TotalMs > b.TotalMs; });
+        this->Frames++;
+    }
+
+    // Zones finished during the last frame, most expensive first
+    const std::vector<ZoneSummary>& LastFrame() const
+    {
+        return this->lastFrame;
+    }
+
+    void PrintFrameSummary(std::ostream& out = std::cout) const
+    {
+        out << "CPU zones of frame " << this->Frames << ":" << std::endl;
+        for (GLuint i = 0; i < this->lastFrame.size(); i++)
+            out << "  " << this->lastFrame[i].Name << ": " << this->lastFrame[i].TotalMs << " ms in "
+                << this->lastFrame[i].Calls << (this->lastFrame[i].Calls == 1 ? " call" : " calls") << " (max "
+                << this->lastFrame[i].MaxMs << " ms)" << std::endl;
+    }
+
+    // Writes every zone still in the rings, plus the frame boundaries, as Chrome trace_event JSON
+    bool WriteChromeTrace(const std::string& path)
+    {
+        std::ofstream file(path.c_str());
+        if (!file)
+        {
+            std::cout << "ERROR::CPU_PROFILER:: Can't write " << path << std::endl;
+            return false;
+        }
+        this->calibrate();
+        file << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+        bool first = true;
+        std::lock_guard<std::mutex> guard(this->lock);
+        for (GLuint i = 0; i < this->buffers.size(); i++)
+        {
+            ThreadBuffer& buffer = *this->buffers[i];
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i + 1
+                 << ",\"args\":{\"name\":\"" << EscapeJson(buffer.Name) << "\"}}";
+            first = false;
+            std::vector<Zone> zones;
+            unsigned long long oldest = buffer.Head.load(std::memory_order_acquire);
+            oldest = oldest > RingSize ? oldest - RingSize : 0;
+            this->read(buffer, oldest, zones);
+            for (GLuint j = 0; j < zones.size(); j++)
+                file << ",\n{\"name\":\"" << EscapeJson(zones[j].Name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << i + 1
+                     << ",\"ts\":" << this->toMicroseconds(zones[j].Start - this->epoch)
+                     << ",\"dur\":" << this->toMicroseconds(zones[j].End - zones[j].Start) << "}";
+        }
+        GLuint frames = this->Frames > RingSize ? (GLuint)RingSize : this->Frames;
+        for (GLuint i = this->Frames - frames; i < this->Frames; i++)
+        {
+            file << (first ? "" : ",\n") << "{\"name\":\"Frame " << i << "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":1,\"ts\":"
+                 << this->toMicroseconds(this->frameEnds[i % RingSize] - this->epoch) << "}";
+            first = false;
+        }
+        file << "\n]}\n";
+        return true;
+    }
+
+    // Escapes quotes and backslashes for a JSON string
+    static std::string EscapeJson(const std::string& text)
+    {
+        std::string escaped;
+        for (GLuint i = 0; i < text.size(); i++)
+        {
+            if (text[i] == '"' || text[i] == '\\')
+                escaped += '\\';
+            escaped += text[i];
+        }
+        return escaped;
+    }
+
+private:
+    struct ThreadBuffer
+    {
+        std::vector<Zone> Zones;
+        std::atomic<unsigned long long> Head;   // Zones ever written; only the owning thread stores it
+        unsigned long long Summarized;          // Zones already counted in a frame summary
+        GLuint Depth;                           // Open zones, only touched by the owning thread
+        std::string Name;
+        ThreadBuffer() : Zones(RingSize), Head(0), Summarized(0), Depth(0) { }
+    };
+
+    std::mutex lock;                            // Guards the list of buffers and the thread names
+    std::vector< std::unique_ptr<ThreadBuffer> > buffers;
+    std::vector<unsigned long long> frameEnds;
+    std::vector<ZoneSummary> lastFrame;
+    unsigned long long epoch;
+    std::chrono::steady_clock::time_point epochTime;
+    GLdouble ticksPerMicrosecond;
+
+    CpuProfiler() : Enabled(true), Frames(0), frameEnds(RingSize), epoch(Now()), epochTime(std::chrono::steady_clock::now()),
+        ticksPerMicrosecond(1000.0)
+    {
+    }
+
+    // The calling thread's ring, registered on first use. Buffers outlive their threads so the trace keeps them.
+    ThreadBuffer& threadBuffer()
+    {
+        static thread_local ThreadBuffer* buffer = NULL;
+        if (!buffer)
+        {
+            std::lock_guard<std::mutex> guard(this->lock);
+            this->buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+            buffer = this->buffers.back().get();
+            buffer->Name = this->buffers.size() == 1 ? "Main thread" : "Thread " + std::to_string(this->buffers.size() - 1);
+        }
+        return *buffer;
+    }
+
+    // Copies the zones written since 'from' and returns the new read position. Slots the writer may have lapped
+    // while they were copied are dropped.
+    unsigned long long read(ThreadBuffer& buffer, unsigned long long from, std::vector<Zone>& zones)
+    {
+        unsigned long long head = buffer.Head.load(std::memory_order_acquire);
+        if (head - from > RingSize)
+            from = head - RingSize;
+        for (unsigned long long i = from; i < head; i++)
+            zones.push_back(buffer.Zones[i & (RingSize - 1)]);
+        unsigned long long lapped = buffer.Head.load(std::memory_order_acquire);
+        if (lapped - from > RingSize)
+        {
+            GLuint overwritten = (GLuint)std::min<unsigned long long>(lapped - RingSize - from, zones.size());
+            zones.erase(zones.begin(), zones.begin() + overwritten);
+        }
+        return head;
+    }
+
+    // Measures the counter frequency over the profiler's lifetime so far (steady_clock ticks are nanoseconds)
+    void calibrate()
+    {
+#if CPU_PROFILER_RDTSC
+        GLdouble elapsedUs = std::chrono::duration<GLdouble, std::micro>(std::chrono::steady_clock::now() - this->epochTime).count();
+        unsigned long long ticks = Now() - this->epoch;
+        if (elapsedUs > 0.0 && ticks > 0)
+            this->ticksPerMicrosecond = ticks / elapsedUs;
+#endif
+    }
+
+    GLdouble toMicroseconds(unsigned long long ticks) const
+    {
+        return ticks / this->ticksPerMicrosecond;
+    }
+};
+
+
+// Times its own lifetime as one zone
+class CpuProfileZone
+{
+public:
+    CpuProfileZone(const char* name) : name(NULL)
+    {
+        CpuProfiler& profiler = CpuProfiler::Instance();
+        if (!profiler.Enabled.load(std::memory_order_relaxed))
+            return;
+        this->name = name;
+        this->depth = profiler.EnterZone();
+        this->start = CpuProfiler::Now();
+    }
+
+    ~CpuProfileZone()
+    {
+        if (this->name)
+            CpuProfiler::Instance().LeaveZone(this->name, this->start, this->depth);
+    }
+
+private:
+    const char* name;
+    unsigned long long start;
+    GLuint depth;
+};
+
+
+#define CPU_PROFILE_CONCAT_(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_(a, b)
+#ifndef LEARN_OPENGL_NO_CPU_PROFILER
+#define CPU_PROFILE_ZONE(name) CpuProfileZone CPU_PROFILE_CONCAT(cpuProfileZone, __LINE__)(name)
+#define CPU_PROFILE_FRAME() CpuProfiler::Instance().EndFrame()
+#define CPU_PROFILE_THREAD(name) CpuProfiler::Instance().SetThreadName(name)
+#else
+#define CPU_PROFILE_ZONE(name)
+#define CPU_PROFILE_FRAME()
+#define CPU_PROFILE_THREAD(name)
+#endif
@@ -0,0 +1,505 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <cmath>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "PointLight.h"
+#include "Frustum.h"
+
+
+// Deferred shading: the scene is drawn once into a G-buffer, then every light shades only the pixels its volume
+// covers, so the cost scales with lit pixels instead of geometry x lights.
+//
+// G-buffer (16 bytes per pixel), written by the scene's geometry shader between Begin/EndGeometryPass:
+//   location 0  RGBA8    albedo, specular intensity
+//   location 1  RG16F    world-space normal, octahedral encoded
+//   location 2  R32F     linear view-space depth (0 where nothing was drawn); positions are rebuilt from it
+// plus a depth-stencil buffer that is only used for testing, never sampled.
+//
+// The light program is the scene's own Phong shader working on the G-buffer. Its vertex shader transforms
+// location 0 by 'volume'; the class sets these uniforms on it:
+//   gAlbedoSpec, gNormal, gDepth      G-buffer samplers (texture units 0-2, use texelFetch at gl_FragCoord)
+//   inverseView, projectionScale      world position = inverseView * vec4(ndc.xy / projectionScale * depth, -depth, 1)
+//   screenSize
+//   lightType                         0 directional, 1 point, 2 spot
+//   pointLight.position/ambient/diffuse/specular/constant/linear/quadratic
+// Directional and spot light colours are left to the caller (dirLight.* and spotLight.* like the forward shaders).
+//
+// The directional light is a full-screen pass that the depth test limits to covered pixels. Point lights are
+// spheres and the spotlight a cone, sized from the attenuation. With UseStencilVolumes each volume first marks the
+// pixels whose surface lies inside it in the stencil buffer (back faces behind the surface minus front faces
+// behind it), then shades only those; otherwise the back faces are drawn with a single greater-equal depth test,
+// which skips pixels behind the volume but still shades the ones in front of it.
+// EndLighting composites the result, with depth, into the framebuffer that was bound at BeginGeometryPass so
+// forward geometry (lamps, transparents) can be drawn on top.
+class DeferredShading
+{
+public:
+    /*  Options  */
+    GLboolean UseStencilVolumes;
+    GLfloat Threshold;          // Light contribution at the edge of a volume, see PointLight::Radius
+
+    /*  Statistics of the last frame  */
+    GLuint LightVolumes;        // Volumes drawn
+    GLuint CulledLights;        // Point lights outside the view frustum
+
+    /*  Functions  */
+    // Constructor, the size must match the viewport the scene renders with
+    DeferredShading(GLuint width, GLuint height)
+        : UseStencilVolumes(true), Threshold(1.0f / 256.0f), LightVolumes(0), CulledLights(0), width(width),
+          height(height), previousFramebuffer(0), program(0)
+    {
+        const GLenum formats[4] = { GL_RGBA8, GL_RG16F, GL_R32F, GL_RGBA16F };
+        const GLenum types[4] = { GL_UNSIGNED_BYTE, GL_FLOAT, GL_FLOAT, GL_FLOAT };
+        const GLenum layouts[4] = { GL_RGBA, GL_RG, GL_RED, GL_RGBA };
+        glGenTextures(4, this->textures);
+        for (GLuint i = 0; i < 4; i++)
+        {
+            glBindTexture(GL_TEXTURE_2D, this->textures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, formats[i], width, height, 0, layouts[i], types[i], NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glGenRenderbuffers(1, &this->depthStencil);
+        glBindRenderbuffer(GL_RENDERBUFFER, this->depthStencil);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        // The G-buffer and the light accumulation target share the depth-stencil buffer
+        GLint framebuffer = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        glGenFramebuffers(1, &this->gBuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->gBuffer);
+        for (GLuint i = 0; i < 3; i++)
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, this->textures[i], 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depthStencil);
+        const GLenum drawBuffers[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+        glDrawBuffers(3, drawBuffers);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: G-buffer is not complete!" << std::endl;
+        glGenFramebuffers(1, &this->accumulation);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->accumulation);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->textures[3], 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depthStencil);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Light accumulation framebuffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+        this->buildVolumes();
+        this->stencilProgram = createProgram(
+            "#version 330 core\n"
+            "layout (location = 0) in vec3 position;\n"
+            "uniform mat4 volume;\n"
+            "void main() { gl_Position = volume * vec4(position, 1.0); }\n",
+            "#version 330 core\n"
+            "void main() {}\n");
+        this->compositeProgram = createProgram(
+            "#version 330 core\n"
+            "void main()\n"
+            "{\n"
+            "    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+            "    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+            "}\n",
+            "#version 330 core\n"
+            "out vec4 color;\n"
+            "uniform sampler2D lighting;\n"
+            "uniform sampler2D gDepth;\n"
+            "uniform vec2 depthScaleBias;\n"
+            "void main()\n"
+            "{\n"
+            "    ivec2 pixel = ivec2(gl_FragCoord.xy);\n"
+            "    float depth = texelFetch(gDepth, pixel, 0).r;\n"
+            "    if (depth == 0.0)\n"
+            "        discard;\n"
+            "    color = vec4(texelFetch(lighting, pixel, 0).rgb, 1.0);\n"
+            "    // Back to window depth with the projection's z row, so later draws depth test against the scene\n"
+            "    gl_FragDepth = (depthScaleBias.x - depthScaleBias.y / depth) * 0.5 + 0.5;\n"
+            "}\n");
+    }
+
+    ~DeferredShading() { this->Release(); }
+
+    // Deletes the framebuffers, their attachments, the light volumes and the programs; no pass can run afterwards.
+    // Call it while the context is still current when the renderer outlives it.
+    void Release()
+    {
+        if (this->gBuffer != 0)
+            glDeleteFramebuffers(1, &this->gBuffer);
+        if (this->accumulation != 0)
+            glDeleteFramebuffers(1, &this->accumulation);
+        if (this->depthStencil != 0)
+            glDeleteRenderbuffers(1, &this->depthStencil);
+        if (this->textures[0] != 0)
+            glDeleteTextures(4, this->textures);
+        if (this->volumeVBO != 0)
+            glDeleteBuffers(1, &this->volumeVBO);
+        if (this->volumeVAO != 0)
+            glDeleteVertexArrays(1, &this->volumeVAO);
+        if (this->stencilProgram != 0)
+            glDeleteProgram(this->stencilProgram);
+        if (this->compositeProgram != 0)
+            glDeleteProgram(this->compositeProgram);
+        this->gBuffer = this->accumulation = this->depthStencil = 0;
+        for (GLuint i = 0; i < 4; i++)
+            this->textures[i] = 0;
+        this->volumeVBO = this->volumeVAO = 0;
+        this->stencilProgram = this->compositeProgram = 0;
+    }
+
+    // Redirects drawing into the G-buffer and clears it; draw the opaque scene with the geometry shader next
+    void BeginGeometryPass()
+    {
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &this->previousFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->gBuffer);
+        const GLfloat zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (GLint i = 0; i < 3; i++)
+            glClearBufferfv(GL_COLOR, i, zero);
+        glStencilMask(0xFF);
+        glClearBufferfi(GL_DEPTH_STENCIL, 0, 1.0f, 0);
+        this->LightVolumes = this->CulledLights = 0;
+    }
+
+    void EndGeometryPass()
+    {
+    }
+
+    // Starts accumulating lights with 'program' (see above), which is left in use
+    void BeginLighting(GLuint program, const glm::mat4& view, const glm::mat4& projection)
+    {
+        this->program = program;
+        this->viewProjection = projection * view;
+        this->frustum.Extract(this->viewProjection);
+        this->projection = projection;
+
+        // Save the state the light passes touch
+        glGetIntegerv(GL_CURRENT_PROGRAM, &this->saved.Program);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &this->saved.VertexArray);
+        this->saved.DepthTest = glIsEnabled(GL_DEPTH_TEST);
+        this->saved.Blend = glIsEnabled(GL_BLEND);
+        this->saved.CullFace = glIsEnabled(GL_CULL_FACE);
+        this->saved.StencilTest = glIsEnabled(GL_STENCIL_TEST);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &this->saved.BlendSrc);
+        glGetIntegerv(GL_BLEND_DST_RGB, &this->saved.BlendDst);
+        glGetIntegerv(GL_DEPTH_FUNC, &this->saved.DepthFunc);
+        glGetIntegerv(GL_CULL_FACE_MODE, &this->saved.CullFaceMode);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, this->accumulation);
+        const GLfloat zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, zero);
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D, this->textures[i]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "gAlbedoSpec"), 0);
+        glUniform1i(glGetUniformLocation(program, "gNormal"), 1);
+        glUniform1i(glGetUniformLocation(program, "gDepth"), 2);
+        glUniformMatrix4fv(glGetUniformLocation(program, "inverseView"), 1, GL_FALSE, glm::value_ptr(glm::inverse(view)));
+        glUniform2f(glGetUniformLocation(program, "projectionScale"), projection[0][0], projection[1][1]);
+        glUniform2f(glGetUniformLocation(program, "screenSize"), (GLfloat)this->width, (GLfloat)this->height);
+        const GLchar* names[9] = { "volume", "lightType", "pointLight.position", "pointLight.ambient", "pointLight.diffuse",
+                                   "pointLight.specular", "pointLight.constant", "pointLight.linear", "pointLight.quadratic" };
+        for (GLuint i = 0; i < 9; i++)
+            this->locations[i] = glGetUniformLocation(program, names[i]);
+        this->volumeLocation = glGetUniformLocation(this->stencilProgram, "volume");
+
+        // Volumes never write depth; depth clamping keeps volumes that reach past the near or far plane closed
+        glDepthMask(GL_FALSE);
+        glStencilMask(0xFF);
+        glEnable(GL_DEPTH_CLAMP);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glBindVertexArray(this->volumeVAO);
+    }
+
+    // Full-screen pass for the directional light (and anything else every pixel receives, like ambient light).
+    // It is drawn at the far plane with a greater depth test, so only pixels with geometry are shaded.
+    void DrawDirectionalLight()
+    {
+        glDisable(GL_STENCIL_TEST);
+        glDisable(GL_CULL_FACE);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_GREATER);
+        glUniform1i(this->locations[1], 0);
+        glUniformMatrix4fv(this->locations[0], 1, GL_FALSE, glm::value_ptr(glm::mat4()));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        this->LightVolumes++;
+    }
+
+    // One sphere per point light, skipping lights outside the view frustum
+    void DrawPointLights(const std::vector<PointLight>& lights)
+    {
+        glUniform1i(this->locations[1], 1);
+        for (GLuint i = 0; i < lights.size(); i++)
+        {
+            const PointLight& light = lights[i];
+            GLfloat radius = light.Radius(this->Threshold);
+            if (radius <= 0.0f || !this->frustum.IntersectsSphere(light.Position, radius))
+            {
+                this->CulledLights++;
+                continue;
+            }
+            glUniform3fv(this->locations[2], 1, glm::value_ptr(light.Position));
+            glUniform3fv(this->locations[3], 1, glm::value_ptr(light.Ambient));
+            glUniform3fv(this->locations[4], 1, glm::value_ptr(light.Diffuse));
+            glUniform3fv(this->locations[5], 1, glm::value_ptr(light.Specular));
+            glUniform1f(this->locations[6], light.Constant);
+            glUniform1f(this->locations[7], light.Linear);
+            glUniform1f(this->locations[8], light.Quadratic);
+            glm::mat4 model = glm::translate(glm::mat4(), light.Position);
+            model = glm::scale(model, glm::vec3(radius * this->sphereScale));
+            this->drawVolume(this->viewProjection * model, this->sphereFirst, this->sphereCount);
+        }
+    }
+
+    // A cone from the spotlight's position along its direction, as long as its attenuation reaches and opening to
+    // the outer cut-off (its cosine, like the shaders); very wide spotlights fall back to a sphere. Only the light's
+    // position, colours and attenuation are used for the size, the shader takes its uniforms from spotLight.*.
+    void DrawSpotLight(const PointLight& light, const glm::vec3& direction, GLfloat outerCutOff)
+    {
+        glUniform1i(this->locations[1], 2);
+        const glm::vec3& position = light.Position;
+        GLfloat range = light.Radius(this->Threshold);
+        if (range <= 0.0f || !this->frustum.IntersectsSphere(position, range))
+        {
+            this->CulledLights++;
+            return;
+        }
+        glm::mat4 model;
+        if (outerCutOff > 0.5f)
+        {
+            // Apex at the light, base at -Z in the cone's space; rotate -Z onto the direction
+            glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            GLfloat baseRadius = range * std::sqrt(1.0f - outerCutOff * outerCutOff) / outerCutOff;
+            model = glm::inverse(glm::lookAt(position, position + direction, up));
+            model = glm::scale(model, glm::vec3(baseRadius * this->coneScale, baseRadius * this->coneScale, range));
+            this->drawVolume(this->viewProjection * model, this->coneFirst, this->coneCount);
+        }
+        else
+        {
+            model = glm::scale(glm::translate(model, position), glm::vec3(range * this->sphereScale));
+            this->drawVolume(this->viewProjection * model, this->sphereFirst, this->sphereCount);
+        }
+    }
+
+    // Composites the lit scene and its depth into the framebuffer bound at BeginGeometryPass and restores the state
+    void EndLighting()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, this->previousFramebuffer);
+        glDisable(GL_STENCIL_TEST);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_BLEND);
+        glDisable(GL_DEPTH_CLAMP);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_ALWAYS);
+        glDepthMask(GL_TRUE);
+        glUseProgram(this->compositeProgram);
+        glUniform1i(glGetUniformLocation(this->compositeProgram, "lighting"), 0);
+        glUniform1i(glGetUniformLocation(this->compositeProgram, "gDepth"), 2);
+        // window depth from view depth d: ndc z = (-P22 * d + P32) / d = -P22 + P32 / d
+        glUniform2f(glGetUniformLocation(this->compositeProgram, "depthScaleBias"), -this->projection[2][2], -this->projection[3][2]);
+        glBindTexture(GL_TEXTURE_2D, this->textures[3]);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        // Restore
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        glActiveTexture(GL_TEXTURE0);
+        glBindVertexArray(this->saved.VertexArray);
+        glUseProgram(this->saved.Program);
+        glDepthFunc(this->saved.DepthFunc);
+        if (!this->saved.DepthTest)
+            glDisable(GL_DEPTH_TEST);
+        if (this->saved.Blend)
+            glEnable(GL_BLEND);
+        if (this->saved.CullFace)
+            glEnable(GL_CULL_FACE);
+        if (this->saved.StencilTest)
+            glEnable(GL_STENCIL_TEST);
+        glCullFace(this->saved.CullFaceMode);
+        glBlendFunc(this->saved.BlendSrc, this->saved.BlendDst);
+        glStencilFunc(GL_ALWAYS, 0, 0xFF);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    }
+
+    void PrintStats(std::ostream& out = std::cout) const
+    {
+        out << "Deferred shading: " << this->LightVolumes << " light passes, " << this->CulledLights
+            << " lights outside the view" << (this->UseStencilVolumes ? " (stencil volumes)" : " (depth tested volumes)")
+            << std::endl;
+    }
+
+private:
+    struct SavedState
+    {
+        GLint Program, VertexArray, BlendSrc, BlendDst, DepthFunc, CullFaceMode;
+        GLboolean DepthTest, Blend, CullFace, StencilTest;
+    };
+
+    GLuint width, height;
+    GLuint gBuffer, accumulation, depthStencil;
+    GLuint textures[4];             // Albedo/specular, normal, depth, accumulated light
+    GLint previousFramebuffer;
+    GLuint stencilProgram, compositeProgram, program;
+    GLuint volumeVAO, volumeVBO;
+    GLint sphereFirst, sphereCount, coneFirst, coneCount;
+    GLfloat sphereScale, coneScale; // Grow the tessellated volumes so they contain the true sphere and cone
+    GLint locations[9];
+    GLint volumeLocation;
+    glm::mat4 viewProjection, projection;
+    Frustum frustum;
+    SavedState saved;
+
+    void drawVolume(const glm::mat4& transform, GLint first, GLint count)
+    {
+        if (this->UseStencilVolumes)
+        {
+            // Mark the pixels whose surface lies inside the volume: back faces behind the surface count up, front
+            // faces behind it count down
+            glUseProgram(this->stencilProgram);
+            glUniformMatrix4fv(this->volumeLocation, 1, GL_FALSE, glm::value_ptr(transform));
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_LESS);
+            glDisable(GL_CULL_FACE);
+            glEnable(GL_STENCIL_TEST);
+            glStencilFunc(GL_ALWAYS, 0, 0xFF);
+            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+            glDrawArrays(GL_TRIANGLES, first, count);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+            // Shade the marked pixels through the back faces (they cover the whole volume even with the camera
+            // inside it), clearing the marks for the next light
+            glUseProgram(this->program);
+            glUniformMatrix4fv(this->locations[0], 1, GL_FALSE, glm::value_ptr(transform));
+            glDisable(GL_DEPTH_TEST);
+            glEnable(GL_CULL_FACE);
+            glCullFace(GL_FRONT);
+            glStencilFunc(GL_NOTEQUAL, 0, 0xFF);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_ZERO);
+            glDrawArrays(GL_TRIANGLES, first, count);
+        }
+        else
+        {
+            // Back faces behind the surface: skips the pixels behind the volume, shades the ones in front of it
+            glUniformMatrix4fv(this->locations[0], 1, GL_FALSE, glm::value_ptr(transform));
+            glDisable(GL_STENCIL_TEST);
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_GEQUAL);
+            glEnable(GL_CULL_FACE);
+            glCullFace(GL_FRONT);
+            glDrawArrays(GL_TRIANGLES, first, count);
+        }
+        this->LightVolumes++;
+    }
+
+    // Full-screen triangle at the far plane, a unit sphere and a unit cone (apex at the origin, base at z = -1) in
+    // one buffer, as counter-clockwise triangles seen from outside
+    void buildVolumes()
+    {
+        const GLuint slices = 16, stacks = 8;
+        const GLfloat pi = 3.14159265f;
+        std::vector<glm::vec3> vertices;
+        vertices.push_back(glm::vec3(-1.0f, -1.0f, 1.0f));
+        vertices.push_back(glm::vec3(3.0f, -1.0f, 1.0f));
+        vertices.push_back(glm::vec3(-1.0f, 3.0f, 1.0f));
+
+        this->sphereFirst = (GLint)vertices.size();
+        for (GLuint stack = 0; stack < stacks; stack++)
+        {
+            GLfloat phi0 = pi * stack / stacks, phi1 = pi * (stack + 1) / stacks;
+            for (GLuint slice = 0; slice < slices; slice++)
+            {
+                GLfloat theta0 = 2.0f * pi * slice / slices, theta1 = 2.0f * pi * (slice + 1) / slices;
+                glm::vec3 a = spherePoint(phi0, theta0), b = spherePoint(phi1, theta0);
+                glm::vec3 c = spherePoint(phi1, theta1), d = spherePoint(phi0, theta1);
+                if (stack > 0)
+                {
+                    vertices.push_back(a);
+                    vertices.push_back(d);
+                    vertices.push_back(b);
+                }
+                if (stack < stacks - 1)
+                {
+                    vertices.push_back(d);
+                    vertices.push_back(c);
+                    vertices.push_back(b);
+                }
+            }
+        }
+        this->sphereCount = (GLint)vertices.size() - this->sphereFirst;
+        // The flat faces sit inside the sphere by at most these factors across and along the rings
+        this->sphereScale = 1.0f / (std::cos(pi / slices) * std::cos(pi / (2.0f * stacks)));
+
+        this->coneFirst = (GLint)vertices.size();
+        glm::vec3 apex(0.0f), baseCenter(0.0f, 0.0f, -1.0f);
+        for (GLuint slice = 0; slice < slices; slice++)
+        {
+            GLfloat theta0 = 2.0f * pi * slice / slices, theta1 = 2.0f * pi * (slice + 1) / slices;
+            glm::vec3 a(std::cos(theta0), std::sin(theta0), -1.0f), b(std::cos(theta1), std::sin(theta1), -1.0f);
+            vertices.push_back(apex);
+            vertices.push_back(a);
+            vertices.push_back(b);
+            vertices.push_back(baseCenter);
+            vertices.push_back(b);
+            vertices.push_back(a);
+        }
+        this->coneCount = (GLint)vertices.size() - this->coneFirst;
+        this->coneScale = 1.0f / std::cos(pi / slices);
+
+        glGenVertexArrays(1, &this->volumeVAO);
+        glGenBuffers(1, &this->volumeVBO);
+        glBindVertexArray(this->volumeVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->volumeVBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), &vertices[0], GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+        glEnableVertexAttribArray(0);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    static glm::vec3 spherePoint(GLfloat phi, GLfloat theta)
+    {
+        return glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+    }
+
+    static GLuint createProgram(const GLchar* vertexSource, const GLchar* fragmentSource)
+    {
+        GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vertexSource, NULL);
+        glCompileShader(vertex);
+        GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fragmentSource, NULL);
+        glCompileShader(fragment);
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glLinkProgram(program);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[512];
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return program;
+    }
+};
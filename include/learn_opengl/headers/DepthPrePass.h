@@ -0,0 +1,127 @@
+#pragma once
+// Std. Includes
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+
+
+// Optional depth-only pre-pass. The opaque geometry is first drawn with a cheap shader and colour writes off, then
+// drawn again with the real shader, depth writes off and GL_EQUAL, so the expensive fragment shader only runs for
+// the surface that ends up visible in each pixel. The vertex shaders of both passes must compute gl_Position with
+// the same expression (and declare it invariant) for the depths to compare equal.
+// Occlusion queries count the fragments that pass the depth test in each pass. They are read back once the GPU has
+// finished with them, without stalling, so the numbers lag a frame or two behind.
+class DepthPrePass
+{
+public:
+    GLboolean Enabled;
+
+    /*  Statistics of the last measured frame  */
+    GLuint DepthFragments;      // Fragments that passed the depth test in the pre-pass (0 while disabled)
+    GLuint ShadedFragments;     // Fragments that passed the depth test in the colour pass and were shaded
+
+    /*  Functions  */
+    // Constructor, takes the size of the render target to relate fragment counts to pixels
+    DepthPrePass(GLuint width, GLuint height)
+        : Enabled(false), DepthFragments(0), ShadedFragments(0), pixels(width * height),
+          pending(false), pendingWithPrePass(false), measuring(false), measuredWithPrePass(false), lastWithPrePass(false)
+    {
+        glGenQueries(2, this->queries);
+    }
+
+    // Call every frame, enabled or not. Collects the previous measurement and, when enabled, sets up the depth-only
+    // state. Returns whether the caller should draw the pre-pass (followed by EndDepthPass).
+    bool BeginDepthPass()
+    {
+        this->collect();
+        // Occlusion queries can't nest, so nothing is measured while another one (e.g. the overdraw view's) is running
+        GLint activeQuery = 0;
+        glGetQueryiv(GL_SAMPLES_PASSED, GL_CURRENT_QUERY, &activeQuery);
+        this->measuring = !this->pending && activeQuery == 0;
+        this->measuredWithPrePass = this->Enabled;
+        if (!this->Enabled)
+            return false;
+
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+        if (this->measuring)
+            glBeginQuery(GL_SAMPLES_PASSED, this->queries[0]);
+        return true;
+    }
+
+    void EndDepthPass()
+    {
+        if (this->measuring)
+            glEndQuery(GL_SAMPLES_PASSED);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+
+    // Sets up the colour pass: only the fragments that match the pre-pass depth exactly are shaded
+    void BeginColourPass()
+    {
+        if (this->measuredWithPrePass)
+        {
+            glDepthMask(GL_FALSE);
+            glDepthFunc(GL_EQUAL);
+        }
+        if (this->measuring)
+            glBeginQuery(GL_SAMPLES_PASSED, this->queries[1]);
+    }
+
+    // Restores the default depth state (GL_LESS with depth writes)
+    void EndColourPass()
+    {
+        if (this->measuring)
+        {
+            glEndQuery(GL_SAMPLES_PASSED);
+            this->pending = true;
+            this->pendingWithPrePass = this->measuredWithPrePass;
+        }
+        glDepthMask(GL_TRUE);
+        glDepthFunc(GL_LESS);
+    }
+
+    // Shaded fragments per pixel of the render target; 1.0 means every pixel was shaded exactly once
+    GLfloat Overdraw() const
+    {
+        return (GLfloat)this->ShadedFragments / (GLfloat)this->pixels;
+    }
+
+    void PrintStats(std::ostream& out = std::cout) const
+    {
+        out << "Depth pre-pass " << (this->lastWithPrePass ? "on" : "off") << ": " << this->ShadedFragments
+            << " shaded fragments (" << this->Overdraw() << " per pixel)";
+        if (this->lastWithPrePass)
+            out << ", " << this->DepthFragments << " passed the pre-pass ("
+                << (GLfloat)this->DepthFragments / (GLfloat)this->pixels << " per pixel without it)";
+        out << std::endl;
+    }
+
+private:
+    GLuint queries[2];          // Pre-pass and colour pass
+    GLuint pixels;
+    bool pending;               // Queries were issued and haven't been read back yet
+    bool pendingWithPrePass;
+    bool measuring;             // Queries are being issued this frame
+    bool measuredWithPrePass;
+    bool lastWithPrePass;       // The statistics above were measured with the pre-pass
+
+    void collect()
+    {
+        if (!this->pending)
+            return;
+        GLint available = 0;
+        glGetQueryObjectiv(this->queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return;
+        glGetQueryObjectuiv(this->queries[1], GL_QUERY_RESULT, &this->ShadedFragments);
+        if (this->pendingWithPrePass)
+            glGetQueryObjectuiv(this->queries[0], GL_QUERY_RESULT, &this->DepthFragments);
+        else
+            this->DepthFragments = 0;
+        this->lastWithPrePass = this->pendingWithPrePass;
+        this->pending = false;
+    }
+};
@@ -0,0 +1,65 @@
+#pragma once
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+
+// View frustum as six planes (left, right, bottom, top, near, far) extracted from a view-projection matrix.
+// Plane normals point inwards, so a point is inside when dot(plane.xyz, p) + plane.w >= 0 for every plane.
+class Frustum
+{
+public:
+    glm::vec4 Planes[6];
+
+    // Constructors
+    Frustum()
+    {
+    }
+
+    Frustum(const glm::mat4& viewProjection)
+    {
+        this->Extract(viewProjection);
+    }
+
+    // Extracts and normalizes the planes (Gribb & Hartmann). glm is column-major so row i is (m[0][i], m[1][i], m[2][i], m[3][i]).
+    void Extract(const glm::mat4& m)
+    {
+        glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+        this->Planes[0] = row3 + row0;
+        this->Planes[1] = row3 - row0;
+        this->Planes[2] = row3 + row1;
+        this->Planes[3] = row3 - row1;
+        this->Planes[4] = row3 + row2;
+        this->Planes[5] = row3 - row2;
+        for (GLuint i = 0; i < 6; i++)
+            this->Planes[i] /= glm::length(glm::vec3(this->Planes[i]));
+    }
+
+    bool IntersectsSphere(const glm::vec3& center, GLfloat radius) const
+    {
+        for (GLuint i = 0; i < 6; i++)
+        {
+            if (glm::dot(glm::vec3(this->Planes[i]), center) + this->Planes[i].w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    // Axis aligned box test using the box corner furthest along each plane normal
+    bool IntersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const
+    {
+        for (GLuint i = 0; i < 6; i++)
+        {
+            const glm::vec4& p = this->Planes[i];
+            glm::vec3 positive(p.x >= 0.0f ? boxMax.x : boxMin.x,
+                               p.y >= 0.0f ? boxMax.y : boxMin.y,
+                               p.z >= 0.0f ? boxMax.z : boxMin.z);
+            if (glm::dot(glm::vec3(p), positive) + p.w < 0.0f)
+                return false;
+        }
+        return true;
+    }
+};
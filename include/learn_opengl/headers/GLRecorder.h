@@ -0,0 +1,530 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <map>
+#include <iostream>
+#include <fstream>
+
+// GL Includes
+#include <GL/glew.h>
+
+
+// The entry points loaded by GLEW: return type, name without "gl", parameters, arguments, the counting expression
+// (its value goes into the log) and the result when there's no context
+#define GL_RECORDER_GLEW_FUNCTIONS(F) \
+    F(void, DrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei primcount), (mode, first, count, primcount), r.draw(mode, count, primcount), 0) \
+    F(void, DrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei primcount), (mode, count, type, indices, primcount), r.draw(mode, count, primcount), 0) \
+    F(void, DrawElementsBaseVertex, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLint basevertex), (mode, count, type, indices, basevertex), r.draw(mode, count, 1), 0) \
+    F(void, DrawRangeElements, (GLenum mode, GLuint start, GLuint end, GLsizei count, GLenum type, const void* indices), (mode, start, end, count, type, indices), r.draw(mode, count, 1), 0) \
+    F(void, BindVertexArray, (GLuint array), (array), r.bindVertexArray(array), 0) \
+    F(void, BindBuffer, (GLenum target, GLuint buffer), (target, buffer), r.bindBuffer(target, buffer), 0) \
+    F(void, BindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer), r.bindBuffer(target, buffer), 0) \
+    F(void, BindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size), r.bindBuffer(target, buffer), 0) \
+    F(void, UseProgram, (GLuint program), (program), r.bind(r.Current.ProgramBinds, r.program, program), 0) \
+    F(void, BindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer), r.bindFramebuffer(target, framebuffer), 0) \
+    F(void, BlitFramebuffer, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter), (srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter), mask, 0) \
+    F(void, ActiveTexture, (GLenum texture), (texture), r.activeTexture(texture), 0) \
+    F(void, BindSampler, (GLuint unit, GLuint sampler), (unit, sampler), r.state(), 0) \
+    F(void, BindImageTexture, (GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format), (unit, texture, level, layered, layer, access, format), texture, 0) \
+    F(void, DispatchCompute, (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z), (num_groups_x, num_groups_y, num_groups_z), (GLint64)num_groups_x * num_groups_y * num_groups_z, 0) \
+    F(void, MemoryBarrier, (GLbitfield barriers), (barriers), barriers, 0) \
+    F(void, BufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), (target, size, data, usage), r.bufferUpload(size), 0) \
+    F(void, BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), (target, offset, size, data), r.bufferUpload(size), 0) \
+    F(void*, MapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), (target, offset, length, access), r.bufferUpload(length), NULL) \
+    F(GLboolean, UnmapBuffer, (GLenum target), (target), 0, GL_TRUE) \
+    F(void, Uniform1i, (GLint location, GLint v0), (location, v0), r.uniform(location, 4), 0) \
+    F(void, Uniform1f, (GLint location, GLfloat v0), (location, v0), r.uniform(location, 4), 0) \
+    F(void, Uniform2f, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1), r.uniform(location, 8), 0) \
+    F(void, Uniform3f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2), r.uniform(location, 12), 0) \
+    F(void, Uniform4f, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3), r.uniform(location, 16), 0) \
+    F(void, Uniform3i, (GLint location, GLint v0, GLint v1, GLint v2), (location, v0, v1, v2), r.uniform(location, 12), 0) \
+    F(void, Uniform2i, (GLint location, GLint v0, GLint v1), (location, v0, v1), r.uniform(location, 8), 0) \
+    F(void, Uniform4i, (GLint location, GLint v0, GLint v1, GLint v2, GLint v3), (location, v0, v1, v2, v3), r.uniform(location, 16), 0) \
+    F(void, Uniform1iv, (GLint location, GLsizei count, const GLint* value), (location, count, value), r.uniform(location, 4 * count), 0) \
+    F(void, Uniform1fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), r.uniform(location, 4 * count), 0) \
+    F(void, Uniform2fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), r.uniform(location, 8 * count), 0) \
+    F(void, Uniform3fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), r.uniform(location, 12 * count), 0) \
+    F(void, Uniform4fv, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), r.uniform(location, 16 * count), 0) \
+    F(void, UniformMatrix3fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value), r.uniform(location, 36 * count), 0) \
+    F(void, UniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), (location, count, transpose, value), r.uniform(location, 64 * count), 0) \
+    F(GLint, GetUniformLocation, (GLuint program, const GLchar* name), (program, name), program, r.location(name)) \
+    F(void, GetUniformfv, (GLuint program, GLint location, GLfloat* params), (program, location, params), location, r.fill(params, 0.0f)) \
+    F(GLuint, GetUniformBlockIndex, (GLuint program, const GLchar* uniformBlockName), (program, uniformBlockName), program, r.location(uniformBlockName)) \
+    F(void, UniformBlockBinding, (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding), (program, uniformBlockIndex, uniformBlockBinding), uniformBlockBinding, 0) \
+    F(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer), (index, size, type, normalized, stride, pointer), index, 0) \
+    F(void, VertexAttribIPointer, (GLuint index, GLint size, GLenum type, GLsizei stride, const void* pointer), (index, size, type, stride, pointer), index, 0) \
+    F(void, EnableVertexAttribArray, (GLuint index), (index), index, 0) \
+    F(void, DisableVertexAttribArray, (GLuint index), (index), index, 0) \
+    F(void, VertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor), index, 0) \
+    F(void, GenVertexArrays, (GLsizei n, GLuint* arrays), (n, arrays), n, r.newNames(n, arrays)) \
+    F(void, GenBuffers, (GLsizei n, GLuint* buffers), (n, buffers), n, r.newNames(n, buffers)) \
+    F(void, GenFramebuffers, (GLsizei n, GLuint* framebuffers), (n, framebuffers), n, r.newNames(n, framebuffers)) \
+    F(void, GenRenderbuffers, (GLsizei n, GLuint* renderbuffers), (n, renderbuffers), n, r.newNames(n, renderbuffers)) \
+    F(void, GenQueries, (GLsizei n, GLuint* ids), (n, ids), n, r.newNames(n, ids)) \
+    F(void, GenSamplers, (GLsizei count, GLuint* samplers), (count, samplers), count, r.newNames(count, samplers)) \
+    F(void, DeleteVertexArrays, (GLsizei n, const GLuint* arrays), (n, arrays), n, 0) \
+    F(void, DeleteBuffers, (GLsizei n, const GLuint* buffers), (n, buffers), n, 0) \
+    F(void, DeleteFramebuffers, (GLsizei n, const GLuint* framebuffers), (n, framebuffers), n, 0) \
+    F(void, DeleteRenderbuffers, (GLsizei n, const GLuint* renderbuffers), (n, renderbuffers), n, 0) \
+    F(void, DeleteSamplers, (GLsizei count, const GLuint* samplers), (count, samplers), count, 0) \
+    F(void, DeleteQueries, (GLsizei n, const GLuint* ids), (n, ids), n, 0) \
+    F(GLuint, CreateShader, (GLenum type), (type), type, r.newName()) \
+    F(void, ShaderSource, (GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length), (shader, count, string, length), shader, 0) \
+    F(void, CompileShader, (GLuint shader), (shader), shader, 0) \
+    F(void, GetShaderiv, (GLuint shader, GLenum pname, GLint* param), (shader, pname, param), shader, r.fill(param, (GLint)GL_TRUE)) \
+    F(void, GetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (shader, bufSize, length, infoLog), shader, r.fill(infoLog, '\0')) \
+    F(void, DeleteShader, (GLuint shader), (shader), shader, 0) \
+    F(GLuint, CreateProgram, (), (), 0, r.newName()) \
+    F(void, AttachShader, (GLuint program, GLuint shader), (program, shader), program, 0) \
+    F(void, LinkProgram, (GLuint program), (program), program, 0) \
+    F(void, GetProgramiv, (GLuint program, GLenum pname, GLint* param), (program, pname, param), program, r.fill(param, (GLint)GL_TRUE)) \
+    F(void, GetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog), (program, bufSize, length, infoLog), program, r.fill(infoLog, '\0')) \
+    F(void, DeleteProgram, (GLuint program), (program), program, 0) \
+    F(void, FramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level), texture, 0) \
+    F(void, FramebufferTextureLayer, (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer), (target, attachment, texture, level, layer), texture, 0) \
+    F(void, FramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer), renderbuffer, 0) \
+    F(GLenum, CheckFramebufferStatus, (GLenum target), (target), target, GL_FRAMEBUFFER_COMPLETE) \
+    F(void, BindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer), renderbuffer, 0) \
+    F(void, RenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height), internalformat, 0) \
+    F(void, RenderbufferStorageMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height), (target, samples, internalformat, width, height), internalformat, 0) \
+    F(void, TexImage2DMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height, GLboolean fixedsamplelocations), (target, samples, internalformat, width, height, fixedsamplelocations), r.textureUpload(), 0) \
+    F(void, DrawBuffers, (GLsizei n, const GLenum* bufs), (n, bufs), r.state(), 0) \
+    F(void, ClearBufferfv, (GLenum buffer, GLint drawBuffer, const GLfloat* value), (buffer, drawBuffer, value), r.clear(), 0) \
+    F(void, ClearBufferfi, (GLenum buffer, GLint drawBuffer, GLfloat depth, GLint stencil), (buffer, drawBuffer, depth, stencil), r.clear(), 0) \
+    F(void, ClearBufferiv, (GLenum buffer, GLint drawBuffer, const GLint* value), (buffer, drawBuffer, value), r.clear(), 0) \
+    F(void, GenerateMipmap, (GLenum target), (target), target, 0) \
+    F(void, TexImage3D, (GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels), (target, level, internalFormat, width, height, depth, border, format, type, pixels), r.textureUpload(), 0) \
+    F(void, TexBuffer, (GLenum target, GLenum internalformat, GLuint buffer), (target, internalformat, buffer), r.state(), 0) \
+    F(void, SamplerParameteri, (GLuint sampler, GLenum pname, GLint param), (sampler, pname, param), r.state(), 0) \
+    F(void, SamplerParameterfv, (GLuint sampler, GLenum pname, const GLfloat* params), (sampler, pname, params), r.state(), 0) \
+    F(void, StencilOpSeparate, (GLenum face, GLenum sfail, GLenum dpfail, GLenum dppass), (face, sfail, dpfail, dppass), r.state(), 0) \
+    F(void, StencilFuncSeparate, (GLenum face, GLenum func, GLint ref, GLuint mask), (face, func, ref, mask), r.state(), 0) \
+    F(void, BlendFuncSeparate, (GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha), (sfactorRGB, dfactorRGB, sfactorAlpha, dfactorAlpha), r.state(), 0) \
+    F(void, BlendEquation, (GLenum mode), (mode), r.state(), 0) \
+    F(void, QueryCounter, (GLuint id, GLenum target), (id, target), id, 0) \
+    F(void, BeginQuery, (GLenum target, GLuint id), (target, id), id, 0) \
+    F(void, EndQuery, (GLenum target), (target), target, 0) \
+    F(void, GetQueryiv, (GLenum target, GLenum pname, GLint* params), (target, pname, params), target, r.fill(params, 0)) \
+    F(void, GetQueryObjectiv, (GLuint id, GLenum pname, GLint* params), (id, pname, params), id, r.fill(params, (GLint)(pname == GL_QUERY_RESULT_AVAILABLE))) \
+    F(void, GetQueryObjectuiv, (GLuint id, GLenum pname, GLuint* params), (id, pname, params), id, r.fill(params, (GLuint)(pname == GL_QUERY_RESULT_AVAILABLE))) \
+    F(void, GetInteger64v, (GLenum pname, GLint64* params), (pname, params), pname, r.fill(params, (GLint64)0)) \
+    F(void, GetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64* params), (id, pname, params), id, r.fill(params, (GLuint64)(pname == GL_QUERY_RESULT_AVAILABLE))) \
+    F(GLsync, FenceSync, (GLenum condition, GLbitfield flags), (condition, flags), condition, (GLsync)NULL) \
+    F(GLenum, ClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), (sync, flags, timeout), 0, GL_ALREADY_SIGNALED) \
+    F(void, DeleteSync, (GLsync sync), (sync), 0, 0)
+
+// The GL 1.1 entry points, interposed at compile time with LEARN_OPENGL_GL_RECORDER
+#define GL_RECORDER_CORE_FUNCTIONS(F) \
+    F(void, DrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count), r.draw(mode, count, 1), 0) \
+    F(void, DrawElements, (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices), r.draw(mode, count, 1), 0) \
+    F(void, BindTexture, (GLenum target, GLuint texture), (target, texture), r.bindTexture(target, texture), 0) \
+    F(void, GenTextures, (GLsizei n, GLuint* textures), (n, textures), n, r.newNames(n, textures)) \
+    F(void, DeleteTextures, (GLsizei n, const GLuint* textures), (n, textures), n, 0) \
+    F(void, TexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void* pixels), (target, level, internalformat, width, height, border, format, type, pixels), r.textureUpload(), 0) \
+    F(void, TexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels), r.textureUpload(), 0) \
+    F(void, TexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param), r.state(), 0) \
+    F(void, TexParameterfv, (GLenum target, GLenum pname, const GLfloat* params), (target, pname, params), r.state(), 0) \
+    F(void, Clear, (GLbitfield mask), (mask), r.clear(), 0) \
+    F(void, ClearColor, (GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha), (red, green, blue, alpha), r.state(), 0) \
+    F(void, ClearStencil, (GLint s), (s), r.state(), 0) \
+    F(void, Enable, (GLenum cap), (cap), r.state(), 0) \
+    F(void, Disable, (GLenum cap), (cap), r.state(), 0) \
+    F(void, DepthFunc, (GLenum func), (func), r.state(), 0) \
+    F(void, DepthMask, (GLboolean flag), (flag), r.state(), 0) \
+    F(void, ColorMask, (GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha), (red, green, blue, alpha), r.state(), 0) \
+    F(void, BlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor), r.state(), 0) \
+    F(void, CullFace, (GLenum mode), (mode), r.state(), 0) \
+    F(void, PolygonMode, (GLenum face, GLenum mode), (face, mode), r.state(), 0) \
+    F(void, StencilFunc, (GLenum func, GLint ref, GLuint mask), (func, ref, mask), r.state(), 0) \
+    F(void, StencilOp, (GLenum fail, GLenum zfail, GLenum zpass), (fail, zfail, zpass), r.state(), 0) \
+    F(void, StencilMask, (GLuint mask), (mask), r.state(), 0) \
+    F(void, Viewport, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), r.state(), 0) \
+    F(void, Scissor, (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height), r.state(), 0) \
+    F(void, DrawBuffer, (GLenum mode), (mode), r.state(), 0) \
+    F(void, ReadBuffer, (GLenum mode), (mode), r.state(), 0) \
+    F(void, PixelStorei, (GLenum pname, GLint param), (pname, param), r.state(), 0) \
+    F(void, ReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels), (x, y, width, height, format, type, pixels), 0, 0) \
+    F(void, GetIntegerv, (GLenum pname, GLint* params), (pname, params), pname, r.getIntegerv(pname, params)) \
+    F(const GLubyte*, GetString, (GLenum name), (name), name, (const GLubyte*)"GLRecorder") \
+    F(GLenum, GetError, (), (), 0, GL_NO_ERROR) \
+    F(GLboolean, IsEnabled, (GLenum cap), (cap), cap, GL_FALSE) \
+    F(void, Finish, (), (), 0, 0) \
+    F(void, Flush, (), (), 0, 0)
+
+
+// Records the GL calls of the application into a command log and per-frame counters (draw calls, binds, uniform
+// uploads, buffer bytes, ...) by putting itself in between the application and the driver.
+//
+// Everything GLEW loads at run time (GL 1.2 and newer: VAOs, buffers, shaders, uniforms, framebuffers, ...) is reached
+// through GLEW's function pointers, and Install() swaps those for recording wrappers. The GL 1.1 entry points
+// (glDrawArrays, glDrawElements, glBindTexture, glTexImage2D, glEnable, ...) are exported by the GL library itself and
+// can only be interposed at compile time: define LEARN_OPENGL_GL_RECORDER for the whole target and include this
+// header before any other header that calls GL, and those calls are routed through the recorder as well.
+//
+// With Install(true), after glewInit, every call is forwarded to the real context. Install(false) needs no context
+// (nor a GPU) at all: the calls are only recorded, glGen* and glCreate* hand out fresh names, shader compiles and
+// program links succeed and glGetUniformLocation returns a location per uniform name. That's enough to load a Model
+// and draw it, so tests can check e.g. how many binds Model::Draw issues.
+//
+//     GLRecorder& recorder = GLRecorder::Instance();
+//     recorder.Install(false);
+//     Shader shader("model.vs", "model.frag");
+//     Model nanosuit("nanosuit.obj");
+//     recorder.EndFrame();                        // Loading counts as a frame of its own
+//     nanosuit.Draw(shader);
+//     recorder.EndFrame();
+//     assert(recorder.LastFrame.TextureBinds <= 2 * recorder.LastFrame.DrawCalls);
+//
+// Every GLEW entry point the demos and headers call is in the table, so with Install(false) each of them records the
+// call and returns its stub result instead of going through a null pointer. A new one has to be added to
+// GL_RECORDER_GLEW_FUNCTIONS before it's used in the recording-only mode.
+class GLRecorder
+{
+public:
+    /*  Per-frame counters  */
+    struct FrameStats
+    {
+        GLuint Calls;                   // Every recorded GL call
+        GLuint DrawCalls;
+        GLuint Instances;               // Summed over the draw calls, 1 per non-instanced draw
+        GLuint64 Vertices;              // Vertices (or indices) submitted, times instances
+        GLuint64 Triangles;             // Of the triangle, strip and fan draws, times instances
+        GLuint VertexArrayBinds;
+        GLuint BufferBinds;
+        GLuint TextureBinds;
+        GLuint ProgramBinds;
+        GLuint FramebufferBinds;
+        GLuint RedundantBinds;          // Binds of the object that was bound already
+        GLuint UniformUploads;
+        GLuint64 UniformBytes;
+        GLuint64 BufferBytes;           // Uploaded with glBufferData and glBufferSubData
+        GLuint TextureUploads;
+        GLuint StateChanges;            // Enable/disable, depth, blend, stencil, viewport and other fixed-function state
+        GLuint Clears;
+
+        FrameStats()
+            : Calls(0), DrawCalls(0), Instances(0), Vertices(0), Triangles(0), VertexArrayBinds(0), BufferBinds(0), TextureBinds(0),
+              ProgramBinds(0), FramebufferBinds(0), RedundantBinds(0), UniformUploads(0), UniformBytes(0), BufferBytes(0),
+              TextureUploads(0), StateChanges(0), Clears(0)
+        { }
+    };
+
+    // One entry of the command log. Value is the call's most telling argument: the object name for binds, the
+    // vertex count for draws, the byte count for buffer uploads, the location for uniforms.
+    struct Command
+    {
+        const char* Name;
+        GLuint Frame;
+        GLint64 Value;
+    };
+
+    /*  Options  */
+    GLboolean LogCommands;              // Append every call to Log; the counters are kept either way
+    GLuint LogCapacity;                 // Commands logged at most, later ones are dropped
+
+    /*  State  */
+    FrameStats Current;                 // Counters of the frame in progress
+    FrameStats LastFrame;               // Counters of the last finished frame
+    GLuint Frame;
+    std::vector<Command> Log;
+
+    /*  Functions  */
+    static GLRecorder& Instance()
+    {
+        static GLRecorder recorder;
+        return recorder;
+    }
+
+    // Puts the recorder in GLEW's function table. With 'forward' the calls go on to the current context, so call it
+    // after glewInit; without it there doesn't need to be a context at all.
+    void Install(bool forward = true)
+    {
+        if (this->installed)
+            return;
+#define GL_RECORDER_INSTALL(ret, name, params, args, record, stub) \
+        real##name() = __glew##name; \
+        __glew##name = &GLRecorder::name;
+        GL_RECORDER_GLEW_FUNCTIONS(GL_RECORDER_INSTALL)
+#undef GL_RECORDER_INSTALL
+        this->forward = forward;
+        this->installed = true;
+        this->resetBindings();
+    }
+
+    // Puts GLEW's own pointers back
+    void Uninstall()
+    {
+        if (!this->installed)
+            return;
+#define GL_RECORDER_UNINSTALL(ret, name, params, args, record, stub) \
+        __glew##name = real##name();
+        GL_RECORDER_GLEW_FUNCTIONS(GL_RECORDER_UNINSTALL)
+#undef GL_RECORDER_UNINSTALL
+        this->installed = false;
+        this->forward = true;
+    }
+
+    bool Installed() const
+    {
+        return this->installed;
+    }
+
+    // Call at the end of every frame, after swapping the buffers
+    void EndFrame()
+    {
+        this->LastFrame = this->Current;
+        this->Current = FrameStats();
+        this->Frame++;
+    }
+
+    void PrintStats(std::ostream& out = std::cout) const
+    {
+        const FrameStats& s = this->LastFrame;
+        out << "GL calls of frame " << (this->Frame > 0 ? this->Frame - 1 : 0) << ": " << s.Calls << " calls, "
+            << s.DrawCalls << " draws (" << s.Instances << " instances, " << s.Vertices << " vertices, " << s.Triangles
+            << " triangles)" << std::endl
+            << "  binds: " << s.VertexArrayBinds << " vertex array, " << s.BufferBinds << " buffer, " << s.TextureBinds
+            << " texture, " << s.ProgramBinds << " program, " << s.FramebufferBinds << " framebuffer ("
+            << s.RedundantBinds << " redundant)" << std::endl
+            << "  uploads: " << s.UniformUploads << " uniforms (" << s.UniformBytes << " bytes), " << s.BufferBytes << " buffer bytes, "
+            << s.TextureUploads << " textures; " << s.StateChanges << " state changes, " << s.Clears << " clears"
+            << std::endl;
+    }
+
+    // Writes the command log, one call per line
+    bool WriteLog(const std::string& path) const
+    {
+        std::ofstream file(path.c_str());
+        if (!file)
+        {
+            std::cout << "ERROR::GL_RECORDER:: Can't write " << path << std::endl;
+            return false;
+        }
+        for (GLuint i = 0; i < this->Log.size(); i++)
+            file << this->Log[i].Frame << " " << this->Log[i].Name << " " << this->Log[i].Value << "\n";
+        return true;
+    }
+
+private:
+    static const GLuint Unknown = 0xFFFFFFFFu;  // Binding not seen yet
+
+    bool installed;
+    bool forward;
+    GLuint nextName;                            // Object names handed out without a context
+    std::map<std::string, GLint> locations;     // Uniform locations handed out without a context
+    GLuint vertexArray, program, drawFramebuffer, readFramebuffer, activeUnit;
+    std::map<GLenum, GLuint> buffers;           // By target
+    std::map<GLuint64, GLuint> textures;        // By texture unit and target
+
+    GLRecorder()
+        : LogCommands(false), LogCapacity(1 << 20), Frame(0), installed(false), forward(true), nextName(1)
+    {
+        this->resetBindings();
+    }
+
+    void resetBindings()
+    {
+        this->vertexArray = this->program = this->drawFramebuffer = this->readFramebuffer = Unknown;
+        this->activeUnit = 0;
+        this->buffers.clear();
+        this->textures.clear();
+    }
+
+    void log(const char* name, GLint64 value)
+    {
+        this->Current.Calls++;
+        if (this->LogCommands && this->Log.size() < this->LogCapacity)
+        {
+            Command command = { name, this->Frame, value };
+            this->Log.push_back(command);
+        }
+    }
+
+    /*  Counting, returns the value to log  */
+    GLint64 draw(GLenum mode, GLsizei count, GLsizei instances)
+    {
+        this->Current.DrawCalls++;
+        this->Current.Instances += instances;
+        this->Current.Vertices += (GLuint64)count * instances;
+        if (mode == GL_TRIANGLES)
+            this->Current.Triangles += (GLuint64)(count / 3) * instances;
+        else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count > 2)
+            this->Current.Triangles += (GLuint64)(count - 2) * instances;
+        return count;
+    }
+
+    GLint64 bind(GLuint& counter, GLuint& bound, GLuint name)
+    {
+        counter++;
+        if (bound == name)
+            this->Current.RedundantBinds++;
+        bound = name;
+        return name;
+    }
+
+    GLint64 bindVertexArray(GLuint array)
+    {
+        // The element array binding is part of the vertex array
+        this->buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+        return this->bind(this->Current.VertexArrayBinds, this->vertexArray, array);
+    }
+
+    GLint64 bindBuffer(GLenum target, GLuint buffer)
+    {
+        std::map<GLenum, GLuint>::iterator bound = this->buffers.insert(std::make_pair(target, (GLuint)Unknown)).first;
+        return this->bind(this->Current.BufferBinds, bound->second, buffer);
+    }
+
+    GLint64 bindTexture(GLenum target, GLuint texture)
+    {
+        GLuint64 key = ((GLuint64)this->activeUnit << 32) | target;
+        std::map<GLuint64, GLuint>::iterator bound = this->textures.insert(std::make_pair(key, (GLuint)Unknown)).first;
+        return this->bind(this->Current.TextureBinds, bound->second, texture);
+    }
+
+    GLint64 bindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        if (target == GL_READ_FRAMEBUFFER)
+            return this->bind(this->Current.FramebufferBinds, this->readFramebuffer, framebuffer);
+        if (target == GL_FRAMEBUFFER)
+            this->readFramebuffer = framebuffer;
+        return this->bind(this->Current.FramebufferBinds, this->drawFramebuffer, framebuffer);
+    }
+
+    GLint64 activeTexture(GLenum unit)
+    {
+        this->activeUnit = unit - GL_TEXTURE0;
+        this->Current.StateChanges++;
+        return unit;
+    }
+
+    GLint64 uniform(GLint location, GLsizei bytes)
+    {
+        this->Current.UniformUploads++;
+        this->Current.UniformBytes += bytes;
+        return location;
+    }
+
+    GLint64 bufferUpload(GLsizeiptr size)
+    {
+        this->Current.BufferBytes += size;
+        return size;
+    }
+
+    GLint64 textureUpload()
+    {
+        this->Current.TextureUploads++;
+        return 0;
+    }
+
+    GLint64 state()
+    {
+        this->Current.StateChanges++;
+        return 0;
+    }
+
+    GLint64 clear()
+    {
+        this->Current.Clears++;
+        return 0;
+    }
+
+    /*  Stand-ins for the results of a context  */
+    GLuint newName()
+    {
+        return this->nextName++;
+    }
+
+    void newNames(GLsizei n, GLuint* names)
+    {
+        for (GLsizei i = 0; i < n; i++)
+            names[i] = this->nextName++;
+    }
+
+    GLint location(const GLchar* name)
+    {
+        return this->locations.insert(std::make_pair(std::string(name), (GLint)this->locations.size())).first->second;
+    }
+
+    template <typename T> static void fill(T* params, T value)
+    {
+        params[0] = value;
+    }
+
+    static void getIntegerv(GLenum pname, GLint* params)
+    {
+        GLuint count = (pname == GL_VIEWPORT || pname == GL_SCISSOR_BOX) ? 4 : 1;
+        for (GLuint i = 0; i < count; i++)
+            params[i] = 0;
+    }
+
+    /*  The wrappers  */
+    // The real entry points GLEW loaded, saved by Install
+#define GL_RECORDER_REAL(ret, name, params, args, record, stub) \
+    static decltype(__glew##name)& real##name() \
+    { \
+        static decltype(__glew##name) real = NULL; \
+        return real; \
+    }
+    GL_RECORDER_GLEW_FUNCTIONS(GL_RECORDER_REAL)
+#undef GL_RECORDER_REAL
+
+#define GL_RECORDER_WRAPPER(ret, name, params, args, record, stub, real) \
+    static ret GLAPIENTRY name params \
+    { \
+        GLRecorder& r = Instance(); \
+        r.log("gl" #name, (GLint64)(record)); \
+        if (r.forward) \
+            return real args; \
+        return (ret)(stub); \
+    }
+#define GL_RECORDER_GLEW_WRAPPER(ret, name, params, args, record, stub) \
+    GL_RECORDER_WRAPPER(ret, name, params, args, record, stub, real##name())
+#define GL_RECORDER_CORE_WRAPPER(ret, name, params, args, record, stub) \
+    GL_RECORDER_WRAPPER(ret, name, params, args, record, stub, ::gl##name)
+public:
+    GL_RECORDER_GLEW_FUNCTIONS(GL_RECORDER_GLEW_WRAPPER)
+    GL_RECORDER_CORE_FUNCTIONS(GL_RECORDER_CORE_WRAPPER)
+#undef GL_RECORDER_CORE_WRAPPER
+#undef GL_RECORDER_GLEW_WRAPPER
+#undef GL_RECORDER_WRAPPER
+};
+
+#ifdef LEARN_OPENGL_GL_RECORDER
+#define glDrawArrays GLRecorder::DrawArrays
+#define glDrawElements GLRecorder::DrawElements
+#define glBindTexture GLRecorder::BindTexture
+#define glGenTextures GLRecorder::GenTextures
+#define glDeleteTextures GLRecorder::DeleteTextures
+#define glTexImage2D GLRecorder::TexImage2D
+#define glTexSubImage2D GLRecorder::TexSubImage2D
+#define glTexParameteri GLRecorder::TexParameteri
+#define glTexParameterfv GLRecorder::TexParameterfv
+#define glClear GLRecorder::Clear
+#define glClearColor GLRecorder::ClearColor
+#define glClearStencil GLRecorder::ClearStencil
+#define glEnable GLRecorder::Enable
+#define glDisable GLRecorder::Disable
+#define glDepthFunc GLRecorder::DepthFunc
+#define glDepthMask GLRecorder::DepthMask
+#define glColorMask GLRecorder::ColorMask
+#define glBlendFunc GLRecorder::BlendFunc
+#define glCullFace GLRecorder::CullFace
+#define glPolygonMode GLRecorder::PolygonMode
+#define glStencilFunc GLRecorder::StencilFunc
+#define glStencilOp GLRecorder::StencilOp
+#define glStencilMask GLRecorder::StencilMask
+#define glViewport GLRecorder::Viewport
+#define glScissor GLRecorder::Scissor
+#define glDrawBuffer GLRecorder::DrawBuffer
+#define glReadBuffer GLRecorder::ReadBuffer
+#define glPixelStorei GLRecorder::PixelStorei
+#define glReadPixels GLRecorder::ReadPixels
+#define glGetIntegerv GLRecorder::GetIntegerv
+#define glGetString GLRecorder::GetString
+#define glGetError GLRecorder::GetError
+#define glIsEnabled GLRecorder::IsEnabled
+#define glFinish GLRecorder::Finish
+#define glFlush GLRecorder::Flush
+#endif
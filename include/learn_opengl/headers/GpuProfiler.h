@@ -0,0 +1,324 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+
+// GL Includes
+#include <GL/glew.h>
+
+
+// Measures the GPU time of named render passes with GL_TIME_ELAPSED queries. The queries of a frame go into one slot
+// of a small ring and are read back FrameLatency frames later, once the GPU has finished with them, so measuring
+// never stalls the pipeline; a frame whose slot is still busy is simply not measured.
+// Passes can't nest (only one GL_TIME_ELAPSED query can be active) but may be issued any number of times per frame;
+// every occurrence is a separate sample. The last WindowSize samples of each pass give a rolling min/avg/p99.
+// Software renderers (Mesa's llvmpipe and softpipe, SwiftShader) accept timer queries but leave the fragment work of
+// draws out of them, so there, or without timer queries at all, passes are timed on the CPU instead: glFinish before
+// and after each pass. That stalls every pass, which costs nothing extra on a renderer that runs on the CPU anyway.
+class GpuProfiler
+{
+public:
+    static const GLuint FrameLatency = 4;   // Frames in flight before a slot's queries are reused
+
+    struct Sample
+    {
+        GLuint Frame;
+        GLdouble Milliseconds;
+    };
+
+    struct PassStats
+    {
+        std::string Name;
+        GLuint Samples;
+        GLdouble Min, Average, P99, Max;    // In milliseconds, over the rolling window
+    };
+
+    /*  Options  */
+    GLboolean Enabled;
+    GLuint WindowSize;                      // Samples kept per pass
+    GLboolean CpuTiming;                    // Time passes between glFinish calls; on by default for software renderers
+
+    /*  Statistics  */
+    GLuint FramesMeasured;
+    GLuint FramesSkipped;                   // The slot's queries weren't available yet
+
+    /*  Functions  */
+    // Constructor, needs a current GL context
+    GpuProfiler(GLuint windowSize = 240)
+        : Enabled(true), WindowSize(windowSize), CpuTiming(false), FramesMeasured(0), FramesSkipped(0), supported(false),
+          frame(0), measuring(false), passOpen(false), cpuPass(0), cpuSamples(0)
+    {
+        // A driver reports zero counter bits when it doesn't actually implement timer queries
+        GLint bits = 0;
+        glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+        this->supported = bits > 0;
+        const GLchar* renderer = (const GLchar*)glGetString(GL_RENDERER);
+        std::string name = renderer ? renderer : "";
+        this->CpuTiming = !this->supported || name.find("llvmpipe") != std::string::npos ||
+                          name.find("softpipe") != std::string::npos || name.find("SwiftShader") != std::string::npos ||
+                          name.find("Software Rasterizer") != std::string::npos;
+        if (this->CpuTiming)
+            std::cout << "GPU profiler: " << (this->supported ? name + " leaves draws out of timer queries" : "no timer queries")
+                      << ", timing passes on the CPU with glFinish" << std::endl;
+    }
+
+    ~GpuProfiler() { this->Release(); }
+
+    // Deletes the queries and drops the frames still in flight. Call it while the context is still current when the
+    // profiler outlives it.
+    void Release()
+    {
+        for (GLuint i = 0; i < FrameLatency; i++)
+        {
+            Slot& slot = this->slots[i];
+            if (!slot.Queries.empty())
+                glDeleteQueries((GLsizei)slot.Queries.size(), &slot.Queries[0]);
+            slot.Queries.clear();
+            slot.Passes.clear();
+            slot.Used = 0;
+            slot.Pending = false;
+        }
+    }
+
+    // Call at the start of every frame. Collects the slots the GPU has finished with.
+    void BeginFrame()
+    {
+        this->collect();
+        Slot& slot = this->slots[this->frame % FrameLatency];
+        if (this->CpuTiming)
+        {
+            this->measuring = this->Enabled;
+            this->cpuSamples = 0;
+            return;
+        }
+        this->measuring = this->Enabled && this->supported && !slot.Pending;
+        if (this->Enabled && this->supported && slot.Pending)
+            this->FramesSkipped++;
+        if (this->measuring)
+        {
+            slot.Used = 0;
+            slot.Frame = this->frame;
+        }
+    }
+
+    // Starts timing a pass; passes are told apart by name
+    void BeginPass(const std::string& name)
+    {
+        if (!this->measuring)
+            return;
+        if (this->passOpen)
+        {
+            std::cout << "ERROR::GPU_PROFILER:: Pass '" << name << "' started inside another pass" << std::endl;
+            return;
+        }
+        if (this->CpuTiming)
+        {
+            // Whatever was issued before the pass must not count towards it
+            glFinish();
+            this->cpuPass = this->passIndex(name);
+            this->cpuStart = std::chrono::high_resolution_clock::now();
+            this->passOpen = true;
+            return;
+        }
+        Slot& slot = this->slots[this->frame % FrameLatency];
+        if (slot.Used == slot.Queries.size())
+        {
+            GLuint query;
+            glGenQueries(1, &query);
+            slot.Queries.push_back(query);
+            slot.Passes.push_back(0);
+        }
+        slot.Passes[slot.Used] = this->passIndex(name);
+        glBeginQuery(GL_TIME_ELAPSED, slot.Queries[slot.Used]);
+        slot.Used++;
+        this->passOpen = true;
+    }
+
+    void EndPass()
+    {
+        if (!this->passOpen)
+            return;
+        this->passOpen = false;
+        if (this->CpuTiming)
+        {
+            glFinish();
+            Sample sample = { this->frame, std::chrono::duration<GLdouble, std::milli>(std::chrono::high_resolution_clock::now() - this->cpuStart).count() };
+            this->addSample(this->passes[this->cpuPass], sample);
+            this->cpuSamples++;
+            return;
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+
+    // Call at the end of every frame, after the last pass
+    void EndFrame()
+    {
+        this->EndPass();
+        Slot& slot = this->slots[this->frame % FrameLatency];
+        if (this->measuring && this->CpuTiming && this->cpuSamples > 0)
+            this->FramesMeasured++;
+        else if (this->measuring && slot.Used > 0)
+            slot.Pending = true;
+        this->measuring = false;
+        this->frame++;
+    }
+
+    // Rolling statistics of every pass seen so far, in the order the passes first appeared
+    std::vector<PassStats> Stats() const
+    {
+        std::vector<PassStats> stats;
+        for (GLuint i = 0; i < this->passes.size(); i++)
+        {
+            const Pass& pass = this->passes[i];
+            PassStats s = { pass.Name, (GLuint)pass.Samples.size(), 0.0, 0.0, 0.0, 0.0 };
+            if (!pass.Samples.empty())
+            {
+                std::vector<GLdouble> sorted;
+                for (GLuint j = 0; j < pass.Samples.size(); j++)
+                    sorted.push_back(pass.Samples[j].Milliseconds);
+                std::sort(sorted.begin(), sorted.end());
+                GLdouble sum = 0.0;
+                for (GLuint j = 0; j < sorted.size(); j++)
+                    sum += sorted[j];
+                s.Min = sorted.front();
+                s.Max = sorted.back();
+                s.Average = sum / sorted.size();
+                s.P99 = sorted[(GLuint)std::ceil(0.99 * sorted.size()) - 1];
+            }
+            stats.push_back(s);
+        }
+        return stats;
+    }
+
+    void PrintStats(std::ostream& out = std::cout) const
+    {
+        std::vector<PassStats> stats = this->Stats();
+        out << "GPU time per pass (ms, last " << this->WindowSize << " samples; " << this->FramesMeasured
+            << " frames measured, " << this->FramesSkipped << " skipped" << (this->CpuTiming ? "; CPU-timed with glFinish" : "")
+            << "):" << std::endl;
+        for (GLuint i = 0; i < stats.size(); i++)
+            out << "  " << stats[i].Name << ": min " << stats[i].Min << ", avg " << stats[i].Average << ", p99 "
+                << stats[i].P99 << ", max " << stats[i].Max << " (" << stats[i].Samples << " samples)" << std::endl;
+    }
+
+    // Writes one line per pass with its rolling statistics
+    bool ExportCSV(const std::string& path) const
+    {
+        std::ofstream file(path.c_str());
+        if (!file)
+        {
+            std::cout << "ERROR::GPU_PROFILER:: Can't write " << path << std::endl;
+            return false;
+        }
+        std::vector<PassStats> stats = this->Stats();
+        file << "pass,samples,min_ms,avg_ms,p99_ms,max_ms\n";
+        for (GLuint i = 0; i < stats.size(); i++)
+            file << "\"" << stats[i].Name << "\"," << stats[i].Samples << "," << stats[i].Min << "," << stats[i].Average
+                 << "," << stats[i].P99 << "," << stats[i].Max << "\n";
+        return true;
+    }
+
+    // Writes every sample in the rolling windows, one line per frame and pass occurrence
+    bool ExportSamplesCSV(const std::string& path) const
+    {
+        std::ofstream file(path.c_str());
+        if (!file)
+        {
+            std::cout << "ERROR::GPU_PROFILER:: Can't write " << path << std::endl;
+            return false;
+        }
+        file << "frame,pass,gpu_ms\n";
+        for (GLuint i = 0; i < this->passes.size(); i++)
+            for (GLuint j = 0; j < this->passes[i].Samples.size(); j++)
+                file << this->passes[i].Samples[j].Frame << ",\"" << this->passes[i].Name << "\","
+                     << this->passes[i].Samples[j].Milliseconds << "\n";
+        return true;
+    }
+
+    void ResetStats()
+    {
+        for (GLuint i = 0; i < this->passes.size(); i++)
+        {
+            this->passes[i].Samples.clear();
+            this->passes[i].Next = 0;
+        }
+        this->FramesMeasured = this->FramesSkipped = 0;
+    }
+
+private:
+    struct Slot
+    {
+        std::vector<GLuint> Queries;        // Grows to the most passes issued in one frame
+        std::vector<GLuint> Passes;         // Index of the pass each query timed
+        GLuint Used;
+        GLuint Frame;
+        bool Pending;                       // Issued and not read back yet
+        Slot() : Used(0), Frame(0), Pending(false) { }
+    };
+
+    struct Pass
+    {
+        std::string Name;
+        std::vector<Sample> Samples;        // Ring of the last WindowSize samples
+        GLuint Next;
+    };
+
+    bool supported;
+    GLuint frame;
+    bool measuring;                         // This frame's slot was free
+    bool passOpen;
+    Slot slots[FrameLatency];
+    GLuint cpuPass, cpuSamples;             // CpuTiming: the open pass, and the samples taken this frame
+    std::chrono::high_resolution_clock::time_point cpuStart;
+    std::vector<Pass> passes;
+
+    GLuint passIndex(const std::string& name)
+    {
+        for (GLuint i = 0; i < this->passes.size(); i++)
+            if (this->passes[i].Name == name)
+                return i;
+        Pass pass;
+        pass.Name = name;
+        pass.Next = 0;
+        this->passes.push_back(pass);
+        return (GLuint)this->passes.size() - 1;
+    }
+
+    // Queries finish in order, so a slot is done once its last query is
+    void collect()
+    {
+        for (GLuint i = 0; i < FrameLatency; i++)
+        {
+            Slot& slot = this->slots[i];
+            if (!slot.Pending)
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(slot.Queries[slot.Used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+            for (GLuint j = 0; j < slot.Used; j++)
+            {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(slot.Queries[j], GL_QUERY_RESULT, &elapsed);
+                Sample sample = { slot.Frame, elapsed / 1000000.0 };
+                this->addSample(this->passes[slot.Passes[j]], sample);
+            }
+            slot.Pending = false;
+            this->FramesMeasured++;
+        }
+    }
+
+    void addSample(Pass& pass, const Sample& sample)
+    {
+        if (pass.Samples.size() < this->WindowSize)
+            pass.Samples.push_back(sample);
+        else
+            pass.Samples[pass.Next] = sample;
+        pass.Next = (pass.Next + 1) % this->WindowSize;
+    }
+};
@@ -0,0 +1,247 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+
+// GL Includes
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+
+// Records the input of a session to a binary journal and plays it back, so a run can be repeated exactly.
+// --record=file.bin writes every frame's delta time plus the key, cursor and scroll events handled in it;
+// --replay=file.bin feeds them back through the demo's own callbacks (and so through Keyboard/Mouse handling on the
+// Camera) and replaces the wall-clock frame time with the recorded one. The simulation then steps through the same
+// deltas with the same input however fast the replaying machine is, and the window closes after the last frame.
+// Live input is ignored during a replay, except ESC.
+//
+// File layout (little-endian): "LOGJ", uint32 version, then records that each start with a type byte:
+//   Frame  float32 delta                                 starts a frame, the events after it belong to it
+//   Key    float32 time, int16 key, int16 scancode, uint8 action, uint8 mods
+//   Cursor float32 time, float64 x, float64 y
+//   Scroll float32 time, float64 xoffset, float64 yoffset
+// Event times are seconds since the start of the recording.
+class InputJournal
+{
+public:
+    enum Mode { OFF, RECORDING, REPLAYING };
+
+    /*  State  */
+    Mode State;
+    std::string Path;
+    GLuint Frames;                      // Frames recorded or replayed so far
+
+    /*  Functions  */
+    // Constructor, reads --record=path or --replay=path from the command line
+    InputJournal(int argc, char* argv[])
+        : State(OFF), Frames(0), window(NULL), keyCallback(NULL), cursorCallback(NULL), scrollCallback(NULL),
+          time(0.0), recordStart(0.0), position(0)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            if (std::strncmp(argv[i], "--record=", 9) == 0)
+            {
+                this->State = RECORDING;
+                this->Path = argv[i] + 9;
+            }
+            else if (std::strncmp(argv[i], "--replay=", 9) == 0)
+            {
+                this->State = REPLAYING;
+                this->Path = argv[i] + 9;
+            }
+        }
+        if (this->State == RECORDING)
+        {
+            this->file.open(this->Path.c_str(), std::ios::binary);
+            if (!this->file)
+            {
+                std::cout << "ERROR::INPUT_JOURNAL:: Can't write " << this->Path << std::endl;
+                this->State = OFF;
+                return;
+            }
+            this->file.write("LOGJ", 4);
+            this->write((GLuint)Version);
+        }
+        else if (this->State == REPLAYING)
+        {
+            std::ifstream in(this->Path.c_str(), std::ios::binary);
+            this->data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            GLuint version = 0;
+            if (this->data.size() >= 8)
+                std::memcpy(&version, &this->data[4], 4);
+            if (this->data.size() < 8 || std::memcmp(&this->data[0], "LOGJ", 4) != 0 || version != Version)
+            {
+                std::cout << "ERROR::INPUT_JOURNAL:: " << this->Path << " is not an input journal" << std::endl;
+                this->State = OFF;
+                return;
+            }
+            this->position = 8;
+        }
+    }
+
+    bool Replaying() const
+    {
+        return this->State == REPLAYING;
+    }
+
+    // Call after the demo has set its input callbacks; the journal puts itself in between
+    void Attach(GLFWwindow* window)
+    {
+        if (this->State == OFF)
+            return;
+        this->window = window;
+        this->recordStart = glfwGetTime();
+        glfwSetWindowUserPointer(window, this);
+        this->keyCallback = glfwSetKeyCallback(window, onKey);
+        this->cursorCallback = glfwSetCursorPosCallback(window, onCursor);
+        this->scrollCallback = glfwSetScrollCallback(window, onScroll);
+    }
+
+    // Call once per frame, after the frame time is computed and before the events are polled. While recording it
+    // starts a new frame in the journal; while replaying it dispatches the frame's events and replaces 'deltaTime'.
+    void BeginFrame(GLfloat& deltaTime)
+    {
+        if (this->State == RECORDING)
+        {
+            this->time += deltaTime;
+            this->file.put(FRAME);
+            this->write(deltaTime);
+            this->Frames++;
+        }
+        else if (this->State == REPLAYING)
+        {
+            if (this->position + 1 + sizeof(GLfloat) > this->data.size() || this->data[this->position] != FRAME)
+            {
+                std::cout << "Replay of " << this->Path << " finished after " << this->Frames << " frames" << std::endl;
+                glfwSetWindowShouldClose(this->window, GL_TRUE);
+                this->State = OFF;
+                return;
+            }
+            // Frame record first, then its events up to the next frame
+            this->position++;
+            this->read(deltaTime);
+            this->time += deltaTime;
+            glfwSetTime(this->time);
+            while (this->position < this->data.size() && this->data[this->position] != FRAME)
+                this->dispatch();
+            this->Frames++;
+        }
+    }
+
+private:
+    enum Record { FRAME, KEY, CURSOR, SCROLL };
+    static const GLuint Version = 1;
+
+    GLFWwindow* window;
+    GLFWkeyfun keyCallback;
+    GLFWcursorposfun cursorCallback;
+    GLFWscrollfun scrollCallback;
+    GLdouble time;                      // Sum of the frame deltas so far
+    GLdouble recordStart;
+    std::ofstream file;
+    std::vector<char> data;             // The whole journal while replaying
+    size_t position;
+
+    template <typename T> void write(T value)
+    {
+        this->file.write((const char*)&value, sizeof(T));
+    }
+
+    template <typename T> void read(T& value)
+    {
+        std::memcpy(&value, &this->data[this->position], sizeof(T));
+        this->position += sizeof(T);
+    }
+
+    // Replays one event record; truncated journals stop the replay at the last complete frame
+    void dispatch()
+    {
+        static const size_t sizes[] = { 0, 4 + 2 + 2 + 1 + 1, 4 + 8 + 8, 4 + 8 + 8 };
+        GLubyte type = (GLubyte)this->data[this->position];
+        if (type > SCROLL || this->position + 1 + sizes[type] > this->data.size())
+        {
+            this->position = this->data.size();
+            return;
+        }
+        this->position++;
+        GLfloat timestamp;
+        this->read(timestamp);
+        if (type == KEY)
+        {
+            GLshort key, scancode;
+            GLubyte action, mods;
+            this->read(key); this->read(scancode); this->read(action); this->read(mods);
+            if (this->keyCallback)
+                this->keyCallback(this->window, key, scancode, action, mods);
+        }
+        else if (type == CURSOR)
+        {
+            GLdouble x, y;
+            this->read(x); this->read(y);
+            if (this->cursorCallback)
+                this->cursorCallback(this->window, x, y);
+        }
+        else
+        {
+            GLdouble x, y;
+            this->read(x); this->read(y);
+            if (this->scrollCallback)
+                this->scrollCallback(this->window, x, y);
+        }
+    }
+
+    GLfloat eventTime() const
+    {
+        return (GLfloat)(glfwGetTime() - this->recordStart);
+    }
+
+    static void onKey(GLFWwindow* window, int key, int scancode, int action, int mods)
+    {
+        InputJournal& journal = *(InputJournal*)glfwGetWindowUserPointer(window);
+        if (journal.State == REPLAYING && key != GLFW_KEY_ESCAPE)
+            return;
+        if (journal.State == RECORDING)
+        {
+            journal.file.put(KEY);
+            journal.write(journal.eventTime());
+            journal.write((GLshort)key); journal.write((GLshort)scancode);
+            journal.write((GLubyte)action); journal.write((GLubyte)mods);
+        }
+        if (journal.keyCallback)
+            journal.keyCallback(window, key, scancode, action, mods);
+    }
+
+    static void onCursor(GLFWwindow* window, double x, double y)
+    {
+        InputJournal& journal = *(InputJournal*)glfwGetWindowUserPointer(window);
+        if (journal.State == REPLAYING)
+            return;
+        if (journal.State == RECORDING)
+        {
+            journal.file.put(CURSOR);
+            journal.write(journal.eventTime());
+            journal.write(x); journal.write(y);
+        }
+        if (journal.cursorCallback)
+            journal.cursorCallback(window, x, y);
+    }
+
+    static void onScroll(GLFWwindow* window, double xoffset, double yoffset)
+    {
+        InputJournal& journal = *(InputJournal*)glfwGetWindowUserPointer(window);
+        if (journal.State == REPLAYING)
+            return;
+        if (journal.State == RECORDING)
+        {
+            journal.file.put(SCROLL);
+            journal.write(journal.eventTime());
+            journal.write(xoffset); journal.write(yoffset);
+        }
+        if (journal.scrollCallback)
+            journal.scrollCallback(window, xoffset, yoffset);
+    }
+};
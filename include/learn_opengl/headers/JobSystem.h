@@ -0,0 +1,375 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Frustum.h"
+#include "CpuProfiler.h"
+
+
+class JobSystem;
+
+// Counts outstanding jobs. Jobs queued with RunAfter() on a counter start once it drops to zero.
+class JobCounter
+{
+public:
+    std::atomic<GLint> Pending;
+
+    JobCounter() : Pending(0)
+    {
+    }
+
+    bool IsDone() const
+    {
+        return this->Pending.load() == 0;
+    }
+
+private:
+    friend class JobSystem;
+    std::mutex lock;
+    std::vector< std::pair< std::function<void()>, JobCounter* > > continuations;
+};
+
+
+// Work-stealing job scheduler. Every thread (the calling/main thread is index 0, workers are 1..N) owns a deque:
+// the owner pushes and pops at the back, idle threads steal from the front of the other deques.
+// The main thread helps execute jobs while it waits, so it is never idle and can go back to submitting GL calls.
+class JobSystem
+{
+public:
+    struct WorkerStats
+    {
+        std::atomic<long long> BusyNs;
+        std::atomic<GLuint> Jobs;
+        std::atomic<GLuint> Steals;
+        WorkerStats() : BusyNs(0), Jobs(0), Steals(0) {}
+    };
+
+    /*  Functions  */
+    // Constructor, spawns 'workerCount' threads next to the calling thread (defaults to one per remaining core)
+    JobSystem(GLint workerCount = -1) : running(true), queued(0)
+    {
+        if (workerCount < 0)
+            workerCount = std::max(1, (GLint)std::thread::hardware_concurrency() - 1);
+        for (GLint i = 0; i <= workerCount; i++)
+        {
+            this->queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+            this->stats.push_back(std::unique_ptr<WorkerStats>(new WorkerStats()));
+        }
+        threadIndex() = 0;
+        for (GLint i = 1; i <= workerCount; i++)
+            this->workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+        this->statsStart = std::chrono::high_resolution_clock::now();
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> guard(this->sleepLock);
+            this->running = false;
+        }
+        this->wake.notify_all();
+        for (GLuint i = 0; i < this->workers.size(); i++)
+            this->workers[i].join();
+    }
+
+    GLuint ThreadCount() const
+    {
+        return (GLuint)this->queues.size();
+    }
+
+    // Queues a job. When a counter is given it is incremented now and decremented once the job has run.
+    void Run(std::function<void()> task, JobCounter* counter = NULL)
+    {
+        if (counter)
+            counter->Pending++;
+        this->push(Job(task, counter));
+    }
+
+    // Queues a job that only starts once 'dependency' has no pending jobs left
+    void RunAfter(JobCounter& dependency, std::function<void()> task, JobCounter* counter = NULL)
+    {
+        if (counter)
+            counter->Pending++;
+        {
+            std::lock_guard<std::mutex> guard(dependency.lock);
+            if (!dependency.IsDone())
+            {
+                dependency.continuations.push_back(std::make_pair(task, counter));
+                return;
+            }
+        }
+        this->push(Job(task, counter));
+    }
+
+    // Executes queued jobs on the calling thread until the counter reaches zero
+    void Wait(JobCounter& counter)
+    {
+        while (!counter.IsDone())
+        {
+            if (!this->tryRunOne(this->self()))
+                std::this_thread::yield();
+        }
+        // The job that brought the counter to zero may still hold its lock; once we have had it, no thread touches
+        // the counter any more and the caller may destroy it
+        std::lock_guard<std::mutex> guard(counter.lock);
+    }
+
+    // Splits [0, count) into chunks of 'grain' elements, runs 'body(begin, end)' for every chunk across all threads and waits
+    void ParallelFor(GLuint count, GLuint grain, std::function<void(GLuint, GLuint)> body)
+    {
+        if (grain == 0)
+            grain = 1;
+        JobCounter counter;
+        for (GLuint begin = 0; begin < count; begin += grain)
+        {
+            GLuint end = std::min(count, begin + grain);
+            this->Run([body, begin, end]() { body(begin, end); }, &counter);
+        }
+        this->Wait(counter);
+    }
+
+    /*  Instrumentation  */
+    void ResetStats()
+    {
+        for (GLuint i = 0; i < this->stats.size(); i++)
+        {
+            this->stats[i]->BusyNs = 0;
+            this->stats[i]->Jobs = 0;
+            this->stats[i]->Steals = 0;
+        }
+        this->statsStart = std::chrono::high_resolution_clock::now();
+    }
+
+    // Prints per-thread utilisation (time spent executing jobs / wall time since the last reset)
+    void PrintStats(std::ostream& out = std::cout)
+    {
+        double wallNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - this->statsStart).count();
+        out << "JobSystem utilisation over " << std::fixed << std::setprecision(1) << wallNs / 1.0e6 << " ms" << std::endl;
+        for (GLuint i = 0; i < this->stats.size(); i++)
+        {
+            out << "  " << (i == 0 ? "main    " : "worker ") << (i == 0 ? "" : std::to_string(i))
+                << ": " << std::setw(5) << std::setprecision(1) << (wallNs > 0.0 ? 100.0 * this->stats[i]->BusyNs / wallNs : 0.0) << "% busy, "
+                << this->stats[i]->Jobs << " jobs, " << this->stats[i]->Steals << " stolen" << std::endl;
+        }
+    }
+
+    const WorkerStats& GetStats(GLuint thread) const
+    {
+        return *this->stats[thread];
+    }
+
+    // CPU-only scaling test: culls and depth-sorts a large instance field with 1..N threads and prints the speedup
+    static void Benchmark(std::ostream& out = std::cout, GLuint instanceCount = 200000, GLuint frames = 20)
+    {
+        std::vector<glm::vec3> positions(instanceCount);
+        std::vector<GLfloat> angles(instanceCount), scales(instanceCount);
+        for (GLuint i = 0; i < instanceCount; i++)
+        {
+            positions[i] = glm::vec3(rand() % 200 - 100, rand() % 20 - 10, rand() % 200 - 100);
+            angles[i] = (GLfloat)(rand() % 360);
+            scales[i] = (rand() % 20) / 100.0f + 0.05f;
+        }
+        std::vector<glm::mat4> models(instanceCount);
+        std::vector<GLfloat> depths(instanceCount);
+
+        // 1, 2, 4, ... threads and finally every core
+        GLuint maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<GLuint> threadCounts;
+        for (GLuint threads = 1; threads < maxThreads; threads *= 2)
+            threadCounts.push_back(threads);
+        threadCounts.push_back(maxThreads);
+
+        double baseline = 0.0;
+        out << "JobSystem scaling (" << instanceCount << " instances, " << frames << " frames)" << std::endl;
+        for (GLuint t = 0; t < threadCounts.size(); t++)
+        {
+            GLuint threads = threadCounts[t];
+            JobSystem jobs((GLint)threads - 1);
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            for (GLuint frame = 0; frame < frames; frame++)
+            {
+                glm::vec3 eye(sin(frame * 0.1f) * 50.0f, 10.0f, cos(frame * 0.1f) * 50.0f);
+                glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+                Frustum frustum(glm::perspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f) * view);
+
+                // Update + cull: build every matrix and store the view depth of visible instances
+                jobs.ParallelFor(instanceCount, 2048, [&](GLuint begin, GLuint end)
+                {
+                    for (GLuint i = begin; i < end; i++)
+                    {
+                        glm::mat4 model = glm::translate(glm::mat4(), positions[i]);
+                        model = glm::rotate(model, angles[i] + frame * 0.01f, glm::vec3(0.4f, 0.6f, 0.8f));
+                        model = glm::scale(model, glm::vec3(scales[i]));
+                        models[i] = model;
+                        glm::vec3 center(model[3]);
+                        depths[i] = frustum.IntersectsSphere(center, scales[i]) ? -(view * glm::vec4(center, 1.0f)).z : -1.0f;
+                    }
+                });
+                // Sort: each chunk sorts its visible depths
+                jobs.ParallelFor(instanceCount, 16384, [&](GLuint begin, GLuint end)
+                {
+                    std::sort(depths.begin() + begin, depths.begin() + end);
+                });
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+            if (threads == 1)
+                baseline = ms;
+            out << "  " << std::setw(2) << threads << " threads: " << std::fixed << std::setprecision(2) << ms << " ms/frame (x"
+                << std::setprecision(2) << baseline / ms << ")" << std::endl;
+            jobs.PrintStats(out);
+        }
+    }
+
+private:
+    struct Job
+    {
+        std::function<void()> Task;
+        JobCounter* Counter;
+        Job() : Counter(NULL) {}
+        Job(std::function<void()> task, JobCounter* counter) : Task(task), Counter(counter) {}
+    };
+
+    struct WorkQueue
+    {
+        std::mutex lock;
+        std::deque<Job> jobs;
+    };
+
+    /*  Scheduler Data  */
+    std::vector< std::unique_ptr<WorkQueue> > queues;
+    std::vector< std::unique_ptr<WorkerStats> > stats;
+    std::vector<std::thread> workers;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    bool running;
+    GLint queued;               // Jobs in all deques, under sleepLock; can dip below zero while a push is in flight
+    std::chrono::high_resolution_clock::time_point statsStart;
+
+    /*  Functions    */
+    // Index of the calling thread's deque (0 for any thread that isn't a worker)
+    static GLint& threadIndex()
+    {
+        static thread_local GLint index = 0;
+        return index;
+    }
+
+    // The calling thread's deque index within this scheduler
+    GLint self() const
+    {
+        GLint index = threadIndex();
+        return index < (GLint)this->queues.size() ? index : 0;
+    }
+
+    void push(const Job& job)
+    {
+        WorkQueue& queue = *this->queues[this->self()];
+        {
+            std::lock_guard<std::mutex> guard(queue.lock);
+            queue.jobs.push_back(job);
+        }
+        {
+            std::lock_guard<std::mutex> guard(this->sleepLock);
+            this->queued++;
+        }
+        this->wake.notify_one();
+    }
+
+    // Pops from the thread's own deque, or steals from another one. Returns false when there was nothing to run.
+    bool tryRunOne(GLint self)
+    {
+        Job job;
+        bool found = false;
+        bool stolen = false;
+        {
+            WorkQueue& own = *this->queues[self];
+            std::lock_guard<std::mutex> guard(own.lock);
+            if (!own.jobs.empty())
+            {
+                job = own.jobs.back();
+                own.jobs.pop_back();
+                found = true;
+            }
+        }
+        GLuint count = (GLuint)this->queues.size();
+        for (GLuint offset = 1; !found && offset < count; offset++)
+        {
+            WorkQueue& victim = *this->queues[(self + offset) % count];
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (!victim.jobs.empty())
+            {
+                job = victim.jobs.front();
+                victim.jobs.pop_front();
+                found = stolen = true;
+            }
+        }
+        if (!found)
+            return false;
+        {
+            std::lock_guard<std::mutex> guard(this->sleepLock);
+            this->queued--;
+        }
+
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        {
+            CPU_PROFILE_ZONE("Job");
+            job.Task();
+        }
+        WorkerStats& stat = *this->stats[self];
+        stat.BusyNs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start).count();
+        stat.Jobs++;
+        if (stolen)
+            stat.Steals++;
+        if (job.Counter)
+            this->finish(*job.Counter);
+        return true;
+    }
+
+    // Decrements the counter and releases the jobs that were waiting on it. Both happen under the counter's lock,
+    // so that a waiter (see Wait) can't see zero and destroy the counter while this thread still uses it.
+    void finish(JobCounter& counter)
+    {
+        std::vector< std::pair< std::function<void()>, JobCounter* > > ready;
+        {
+            std::lock_guard<std::mutex> guard(counter.lock);
+            if (--counter.Pending > 0)
+                return;
+            ready.swap(counter.continuations);
+        }
+        for (GLuint i = 0; i < ready.size(); i++)
+            this->push(Job(ready[i].first, ready[i].second));
+    }
+
+    void workerLoop(GLint index)
+    {
+        threadIndex() = index;
+        CPU_PROFILE_THREAD("Worker " + std::to_string(index));
+        while (true)
+        {
+            if (this->tryRunOne(index))
+                continue;
+            // Sleep until there's a job. One pushed between the failed steal and here has already raised 'queued',
+            // so the wait returns at once instead of missing its notification.
+            std::unique_lock<std::mutex> guard(this->sleepLock);
+            this->wake.wait(guard, [this]() { return !this->running || this->queued > 0; });
+            if (!this->running)
+                return;
+        }
+    }
+};
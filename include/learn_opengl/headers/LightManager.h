@@ -0,0 +1,176 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "PointLight.h"
+
+
+// Per-draw point light selection for forward shaders. Every light gets a finite radius from its attenuation and
+// Threshold (PointLight::Radius); before each draw, SetDrawLights picks the lights whose sphere touches the object's
+// bounding box and uploads just their indices, so a fragment only evaluates the lights that can reach it.
+// When more lights touch an object than the shader takes, the ones contributing most at the box are kept.
+//
+// The lights themselves are uploaded once per frame by Update into a buffer texture, in the same layout as
+// ClusteredLighting (four RGBA32F texels per light, see PointLight::Pack). The shader declares:
+//   uniform samplerBuffer lightData;
+//   uniform int pointLightCount;
+//   uniform int pointLightIndices[MaxLightsPerDraw];
+class LightManager
+{
+public:
+    /*  Options  */
+    GLfloat Threshold;          // Contribution below which a light is cut off
+    GLuint MaxLightsPerDraw;    // Size of the shader's pointLightIndices array
+
+    /*  Lights  */
+    std::vector<PointLight> Lights;
+    std::vector<GLint> Selected;    // Indices picked by the last Select
+
+    /*  Statistics since the last ResetStats  */
+    GLuint Draws;
+    GLuint SelectedLights;      // Summed over the draws
+    GLuint MostLights;          // Most lights touching one draw, before truncation
+    GLuint TruncatedDraws;      // Draws that had more lights than MaxLightsPerDraw
+
+    /*  Functions  */
+    // Constructor, needs a current GL context
+    LightManager(GLuint maxLightsPerDraw = 16)
+        : Threshold(1.0f / 256.0f), MaxLightsPerDraw(maxLightsPerDraw), Draws(0), SelectedLights(0), MostLights(0),
+          TruncatedDraws(0), program(0)
+    {
+        glGenBuffers(1, &this->buffer);
+        glGenTextures(1, &this->texture);
+        glBindBuffer(GL_TEXTURE_BUFFER, this->buffer);
+        glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW);
+        glBindTexture(GL_TEXTURE_BUFFER, this->texture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, this->buffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ~LightManager() { this->Release(); }
+
+    // Deletes the light buffer and its texture; the lights can't be uploaded afterwards. Call it while the context is
+    // still current when the manager outlives it.
+    void Release()
+    {
+        if (this->texture != 0)
+            glDeleteTextures(1, &this->texture);
+        if (this->buffer != 0)
+            glDeleteBuffers(1, &this->buffer);
+        this->texture = this->buffer = 0;
+    }
+
+    // Computes the radii and uploads the lights; call once per frame after changing Lights
+    void Update()
+    {
+        this->radii.resize(this->Lights.size());
+        this->lightData.resize(16 * std::max((size_t)1, this->Lights.size()));
+        for (GLuint i = 0; i < this->Lights.size(); i++)
+        {
+            this->radii[i] = this->Lights[i].Radius(this->Threshold);
+            this->Lights[i].Pack(&this->lightData[16 * i], this->radii[i]);
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, this->buffer);
+        glBufferData(GL_TEXTURE_BUFFER, this->lightData.size() * sizeof(GLfloat), &this->lightData[0], GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // Binds the light buffer to texture unit 'unit' for 'program', which must be in use; leaves unit 0 active
+    void Bind(GLuint program, GLuint unit)
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_BUFFER, this->texture);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(glGetUniformLocation(program, "lightData"), unit);
+        this->useProgram(program);
+    }
+
+    // Selects the lights reaching the world-space box and uploads their indices to 'program' (in use)
+    GLuint SetDrawLights(GLuint program, const glm::vec3& boxMin, const glm::vec3& boxMax)
+    {
+        GLuint count = this->Select(boxMin, boxMax);
+        this->useProgram(program);
+        glUniform1i(this->countLocation, count);
+        if (count > 0)
+            glUniform1iv(this->indicesLocation, count, &this->Selected[0]);
+        return count;
+    }
+
+    // Fills Selected with the lights whose sphere touches the box, at most MaxLightsPerDraw of them
+    GLuint Select(const glm::vec3& boxMin, const glm::vec3& boxMax)
+    {
+        this->Selected.clear();
+        this->scores.clear();
+        for (GLuint i = 0; i < this->radii.size(); i++)
+        {
+            const glm::vec3& position = this->Lights[i].Position;
+            glm::vec3 closest = glm::clamp(position, boxMin, boxMax);
+            GLfloat distanceSquared = glm::dot(position - closest, position - closest);
+            if (distanceSquared > this->radii[i] * this->radii[i])
+                continue;
+            this->Selected.push_back((GLint)i);
+            this->scores.push_back(std::make_pair(this->strength(this->Lights[i], std::sqrt(distanceSquared)), (GLint)i));
+        }
+        GLuint touching = (GLuint)this->Selected.size();
+        if (touching > this->MaxLightsPerDraw)
+        {
+            // Keep the strongest at the box's closest point
+            std::partial_sort(this->scores.begin(), this->scores.begin() + this->MaxLightsPerDraw, this->scores.end(),
+                              std::greater< std::pair<GLfloat, GLint> >());
+            this->Selected.resize(this->MaxLightsPerDraw);
+            for (GLuint i = 0; i < this->MaxLightsPerDraw; i++)
+                this->Selected[i] = this->scores[i].second;
+            this->TruncatedDraws++;
+        }
+        this->Draws++;
+        this->SelectedLights += (GLuint)this->Selected.size();
+        this->MostLights = std::max(this->MostLights, touching);
+        return (GLuint)this->Selected.size();
+    }
+
+    void ResetStats()
+    {
+        this->Draws = this->SelectedLights = this->MostLights = this->TruncatedDraws = 0;
+    }
+
+    void PrintStats(std::ostream& out = std::cout) const
+    {
+        out << "Light manager: " << this->Lights.size() << " lights, " << (this->Draws > 0 ? (GLfloat)this->SelectedLights / this->Draws : 0.0f)
+            << " per draw over " << this->Draws << " draws (at most " << this->MostLights << " touching one, "
+            << this->TruncatedDraws << " draws over the limit of " << this->MaxLightsPerDraw << ")" << std::endl;
+    }
+
+private:
+    GLuint buffer, texture;
+    GLuint program;
+    GLint countLocation, indicesLocation;
+    std::vector<GLfloat> radii;
+    std::vector<GLfloat> lightData;
+    std::vector< std::pair<GLfloat, GLint> > scores;
+
+    void useProgram(GLuint program)
+    {
+        if (program == this->program)
+            return;
+        this->program = program;
+        this->countLocation = glGetUniformLocation(program, "pointLightCount");
+        this->indicesLocation = glGetUniformLocation(program, "pointLightIndices");
+    }
+
+    // Brightest channel of the light, attenuated over 'distance'
+    static GLfloat strength(const PointLight& light, GLfloat distance)
+    {
+        glm::vec3 sum = light.Ambient + light.Diffuse + light.Specular;
+        return std::max(sum.x, std::max(sum.y, sum.z)) /
+               (light.Constant + light.Linear * distance + light.Quadratic * distance * distance);
+    }
+};
@@ -0,0 +1,52 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <cmath>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+
+// Picks a level of detail per instance from its projected size on screen. Level i is used while the
+// bounding sphere covers at least Thresholds[i] pixels; anything smaller than the last threshold gets the
+// coarsest level. Each instance remembers its level and only switches once the size has moved past the
+// threshold by the hysteresis fraction, which stops instances near a boundary from popping every frame.
+class LodSelector
+{
+public:
+    std::vector<GLfloat> Thresholds;    // Projected diameters in pixels, largest first
+    GLfloat Hysteresis;                 // Fraction of a threshold the size must cross it by before switching
+    std::vector<GLuint> Levels;         // Current level per instance
+
+    // Constructor
+    LodSelector(GLuint instanceCount, const std::vector<GLfloat>& thresholds, GLfloat hysteresis = 0.15f)
+        : Thresholds(thresholds), Hysteresis(hysteresis), Levels(instanceCount, 0)
+    {
+    }
+
+    // Diameter in pixels of a sphere seen through the given projection. Taking the focal length from the
+    // projection matrix keeps this in line with whatever field of view was actually used to build it.
+    static GLfloat ProjectedSize(const glm::vec3& center, GLfloat radius, const glm::vec3& cameraPos, const glm::mat4& projection, GLfloat viewportHeight)
+    {
+        GLfloat distance = glm::length(center - cameraPos);
+        if (distance <= radius)
+            return viewportHeight;
+        return radius * std::fabs(projection[1][1]) / distance * viewportHeight;
+    }
+
+    // Updates and returns the level of one instance. Safe to call for different instances from several threads.
+    GLuint Select(GLuint instance, GLfloat screenSize)
+    {
+        GLuint level = this->Levels[instance];
+        GLuint coarsest = (GLuint)this->Thresholds.size();
+        // Coarser: the size dropped clearly below the threshold of the current level
+        while (level < coarsest && screenSize < this->Thresholds[level] * (1.0f - this->Hysteresis))
+            level++;
+        // Finer: the size grew clearly above the threshold of the next finer level
+        while (level > 0 && screenSize > this->Thresholds[level - 1] * (1.0f + this->Hysteresis))
+            level--;
+        this->Levels[instance] = level;
+        return level;
+    }
+};
@@ -0,0 +1,305 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "CpuProfiler.h"
+
+// SIMD Includes. AVX is used when the compiler targets it (/arch:AVX), otherwise SSE2 which every x64 build has.
+#if defined(__AVX__)
+#define MATRIX_KERNELS_AVX 1
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATRIX_KERNELS_SSE 1
+#include <emmintrin.h>
+#endif
+
+
+// Instance transforms in structure-of-arrays layout so the kernels can load 4 or 8 instances per register
+struct TransformBatch
+{
+    std::vector<GLfloat> px, py, pz;        // Translation
+    std::vector<GLfloat> qx, qy, qz, qw;    // Rotation (unit quaternion)
+    std::vector<GLfloat> sx, sy, sz;        // Scale
+
+    void Add(glm::vec3 position, glm::quat rotation, glm::vec3 scale)
+    {
+        px.push_back(position.x); py.push_back(position.y); pz.push_back(position.z);
+        qx.push_back(rotation.x); qy.push_back(rotation.y); qz.push_back(rotation.z); qw.push_back(rotation.w);
+        sx.push_back(scale.x); sy.push_back(scale.y); sz.push_back(scale.z);
+    }
+
+    void Clear()
+    {
+        px.clear(); py.clear(); pz.clear();
+        qx.clear(); qy.clear(); qz.clear(); qw.clear();
+        sx.clear(); sy.clear(); sz.clear();
+    }
+
+    GLuint Size() const
+    {
+        return (GLuint)px.size();
+    }
+};
+
+
+namespace MatrixKernels
+{
+    // Scalar reference for a single instance: model = T * R * S, normal = transpose(inverse(mat3(model))) = R * S^-1
+    inline void composeOne(const TransformBatch& batch, GLuint i, glm::mat4* models, glm::mat3* normals)
+    {
+        GLfloat x = batch.qx[i], y = batch.qy[i], z = batch.qz[i], w = batch.qw[i];
+        GLfloat r00 = 1.0f - 2.0f * (y * y + z * z), r01 = 2.0f * (x * y + w * z), r02 = 2.0f * (x * z - w * y);
+        GLfloat r10 = 2.0f * (x * y - w * z), r11 = 1.0f - 2.0f * (x * x + z * z), r12 = 2.0f * (y * z + w * x);
+        GLfloat r20 = 2.0f * (x * z + w * y), r21 = 2.0f * (y * z - w * x), r22 = 1.0f - 2.0f * (x * x + y * y);
+        GLfloat sx = batch.sx[i], sy = batch.sy[i], sz = batch.sz[i];
+
+        glm::mat4& m = models[i];
+        m[0] = glm::vec4(r00 * sx, r01 * sx, r02 * sx, 0.0f);
+        m[1] = glm::vec4(r10 * sy, r11 * sy, r12 * sy, 0.0f);
+        m[2] = glm::vec4(r20 * sz, r21 * sz, r22 * sz, 0.0f);
+        m[3] = glm::vec4(batch.px[i], batch.py[i], batch.pz[i], 1.0f);
+        if (normals)
+        {
+            glm::mat3& n = normals[i];
+            n[0] = glm::vec3(r00, r01, r02) / sx;
+            n[1] = glm::vec3(r10, r11, r12) / sy;
+            n[2] = glm::vec3(r20, r21, r22) / sz;
+        }
+    }
+
+#if MATRIX_KERNELS_SSE
+    // Writes one mat4 column for 4 instances: c.x/c.y/c.z/c.w hold that component of each instance
+    inline void storeColumns4(__m128 cx, __m128 cy, __m128 cz, __m128 cw, GLfloat* first, GLuint column)
+    {
+        _MM_TRANSPOSE4_PS(cx, cy, cz, cw);
+        _mm_storeu_ps(first + 0 * 16 + column * 4, cx);
+        _mm_storeu_ps(first + 1 * 16 + column * 4, cy);
+        _mm_storeu_ps(first + 2 * 16 + column * 4, cz);
+        _mm_storeu_ps(first + 3 * 16 + column * 4, cw);
+    }
+
+    // Writes four mat3's from the 9 component vectors (one lane per instance)
+    inline void storeMat3x4(const __m128* c, GLfloat* first)
+    {
+        __m128 a0 = c[0], a1 = c[1], a2 = c[2], a3 = c[3];
+        __m128 b0 = c[4], b1 = c[5], b2 = c[6], b3 = c[7];
+        _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+        _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+        GLfloat last[4];
+        _mm_storeu_ps(last, c[8]);
+        __m128 as[4] = { a0, a1, a2, a3 };
+        __m128 bs[4] = { b0, b1, b2, b3 };
+        for (GLuint l = 0; l < 4; l++)
+        {
+            _mm_storeu_ps(first + l * 9, as[l]);
+            _mm_storeu_ps(first + l * 9 + 4, bs[l]);
+            first[l * 9 + 8] = last[l];
+        }
+    }
+
+    // Composes 4 instances starting at 'i' from already loaded lanes
+    inline void compose4(__m128 x, __m128 y, __m128 z, __m128 w,
+                         __m128 sx, __m128 sy, __m128 sz,
+                         __m128 px, __m128 py, __m128 pz,
+                         GLfloat* model, GLfloat* normal)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 zero = _mm_setzero_ps();
+        __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+        __m128 r[9];
+        r[0] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+        r[1] = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+        r[2] = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+        r[3] = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+        r[4] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+        r[5] = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+        r[6] = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+        r[7] = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+        r[8] = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+
+        storeColumns4(_mm_mul_ps(r[0], sx), _mm_mul_ps(r[1], sx), _mm_mul_ps(r[2], sx), zero, model, 0);
+        storeColumns4(_mm_mul_ps(r[3], sy), _mm_mul_ps(r[4], sy), _mm_mul_ps(r[5], sy), zero, model, 1);
+        storeColumns4(_mm_mul_ps(r[6], sz), _mm_mul_ps(r[7], sz), _mm_mul_ps(r[8], sz), zero, model, 2);
+        storeColumns4(px, py, pz, one, model, 3);
+
+        if (normal)
+        {
+            __m128 isx = _mm_div_ps(one, sx), isy = _mm_div_ps(one, sy), isz = _mm_div_ps(one, sz);
+            __m128 n[9] = {
+                _mm_mul_ps(r[0], isx), _mm_mul_ps(r[1], isx), _mm_mul_ps(r[2], isx),
+                _mm_mul_ps(r[3], isy), _mm_mul_ps(r[4], isy), _mm_mul_ps(r[5], isy),
+                _mm_mul_ps(r[6], isz), _mm_mul_ps(r[7], isz), _mm_mul_ps(r[8], isz)
+            };
+            storeMat3x4(n, normal);
+        }
+    }
+#endif
+
+    // Writes the model matrix (and, when 'normals' is not null, the normal matrix) of every instance in the batch.
+    // 'models' and 'normals' must hold at least batch.Size() elements.
+    inline void ComposeModelMatrices(const TransformBatch& batch, glm::mat4* models, glm::mat3* normals = NULL)
+    {
+        CPU_PROFILE_ZONE("Compose model matrices");
+        GLuint count = batch.Size();
+        GLuint i = 0;
+#if MATRIX_KERNELS_AVX
+        // 8 instances per instruction; the stores are split into two 4-wide transposes
+        for (; i + 8 <= count; i += 8)
+        {
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 two = _mm256_set1_ps(2.0f);
+            __m256 x = _mm256_loadu_ps(&batch.qx[i]), y = _mm256_loadu_ps(&batch.qy[i]);
+            __m256 z = _mm256_loadu_ps(&batch.qz[i]), w = _mm256_loadu_ps(&batch.qw[i]);
+            __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+            __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+            __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+            __m256 sx = _mm256_loadu_ps(&batch.sx[i]), sy = _mm256_loadu_ps(&batch.sy[i]), sz = _mm256_loadu_ps(&batch.sz[i]);
+
+            __m256 r[9];
+            r[0] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz)));
+            r[1] = _mm256_mul_ps(two, _mm256_add_ps(xy, wz));
+            r[2] = _mm256_mul_ps(two, _mm256_sub_ps(xz, wy));
+            r[3] = _mm256_mul_ps(two, _mm256_sub_ps(xy, wz));
+            r[4] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz)));
+            r[5] = _mm256_mul_ps(two, _mm256_add_ps(yz, wx));
+            r[6] = _mm256_mul_ps(two, _mm256_add_ps(xz, wy));
+            r[7] = _mm256_mul_ps(two, _mm256_sub_ps(yz, wx));
+            r[8] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy)));
+
+            __m256 c[12] = {
+                _mm256_mul_ps(r[0], sx), _mm256_mul_ps(r[1], sx), _mm256_mul_ps(r[2], sx),
+                _mm256_mul_ps(r[3], sy), _mm256_mul_ps(r[4], sy), _mm256_mul_ps(r[5], sy),
+                _mm256_mul_ps(r[6], sz), _mm256_mul_ps(r[7], sz), _mm256_mul_ps(r[8], sz),
+                _mm256_loadu_ps(&batch.px[i]), _mm256_loadu_ps(&batch.py[i]), _mm256_loadu_ps(&batch.pz[i])
+            };
+            __m256 n[9];
+            if (normals)
+            {
+                __m256 isx = _mm256_div_ps(one, sx), isy = _mm256_div_ps(one, sy), isz = _mm256_div_ps(one, sz);
+                for (GLuint k = 0; k < 3; k++)
+                {
+                    n[k] = _mm256_mul_ps(r[k], isx);
+                    n[k + 3] = _mm256_mul_ps(r[k + 3], isy);
+                    n[k + 6] = _mm256_mul_ps(r[k + 6], isz);
+                }
+            }
+
+            for (GLuint half = 0; half < 2; half++)
+            {
+                __m128 h[12];
+                for (GLuint k = 0; k < 12; k++)
+                    h[k] = half ? _mm256_extractf128_ps(c[k], 1) : _mm256_castps256_ps128(c[k]);
+                GLfloat* model = &models[i + half * 4][0][0];
+                const __m128 zero = _mm_setzero_ps();
+                storeColumns4(h[0], h[1], h[2], zero, model, 0);
+                storeColumns4(h[3], h[4], h[5], zero, model, 1);
+                storeColumns4(h[6], h[7], h[8], zero, model, 2);
+                storeColumns4(h[9], h[10], h[11], _mm_set1_ps(1.0f), model, 3);
+                if (normals)
+                {
+                    __m128 hn[9];
+                    for (GLuint k = 0; k < 9; k++)
+                        hn[k] = half ? _mm256_extractf128_ps(n[k], 1) : _mm256_castps256_ps128(n[k]);
+                    storeMat3x4(hn, &normals[i + half * 4][0][0]);
+                }
+            }
+        }
+#endif
+#if MATRIX_KERNELS_SSE
+        // 4 instances per instruction
+        for (; i + 4 <= count; i += 4)
+        {
+            compose4(_mm_loadu_ps(&batch.qx[i]), _mm_loadu_ps(&batch.qy[i]), _mm_loadu_ps(&batch.qz[i]), _mm_loadu_ps(&batch.qw[i]),
+                     _mm_loadu_ps(&batch.sx[i]), _mm_loadu_ps(&batch.sy[i]), _mm_loadu_ps(&batch.sz[i]),
+                     _mm_loadu_ps(&batch.px[i]), _mm_loadu_ps(&batch.py[i]), _mm_loadu_ps(&batch.pz[i]),
+                     &models[i][0][0], normals ? &normals[i][0][0] : NULL);
+        }
+#endif
+        // Remaining instances (or all of them without SIMD support)
+        for (; i < count; i++)
+            composeOne(batch, i, models, normals);
+    }
+
+    // Times the scalar glm::translate/rotate/scale chain against ComposeModelMatrices at 1k, 100k and 1M instances, and
+    // reports the largest difference between their model and normal matrices
+    inline void Benchmark(std::ostream& out = std::cout)
+    {
+        const GLuint sizes[] = { 1000, 100000, 1000000 };
+        out << "MatrixKernels benchmark (" <<
+#if MATRIX_KERNELS_AVX
+            "AVX"
+#elif MATRIX_KERNELS_SSE
+            "SSE2"
+#else
+            "scalar"
+#endif
+            << ")" << std::endl;
+        for (GLuint s = 0; s < 3; s++)
+        {
+            GLuint count = sizes[s];
+            TransformBatch batch;
+            std::vector<glm::vec3> positions(count), axes(count);
+            std::vector<GLfloat> angles(count), scales(count);
+            for (GLuint i = 0; i < count; i++)
+            {
+                positions[i] = glm::vec3(rand() % 100, rand() % 100, rand() % 100);
+                axes[i] = glm::normalize(glm::vec3(0.4f, 0.6f, 0.8f));
+                angles[i] = (GLfloat)(rand() % 360);
+                scales[i] = (rand() % 20) / 100.0f + 0.05f;
+                batch.Add(positions[i], glm::angleAxis(angles[i], axes[i]), glm::vec3(scales[i]));
+            }
+            std::vector<glm::mat4> models(count), referenceModels(count);
+            std::vector<glm::mat3> normals(count), referenceNormals(count);
+
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            for (GLuint i = 0; i < count; i++)
+            {
+                glm::mat4 model;
+                model = glm::translate(model, positions[i]);
+                model = glm::rotate(model, angles[i], axes[i]);
+                model = glm::scale(model, glm::vec3(scales[i]));
+                referenceModels[i] = model;
+                referenceNormals[i] = glm::transpose(glm::inverse(glm::mat3(model)));
+            }
+            double scalarMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            start = std::chrono::high_resolution_clock::now();
+            ComposeModelMatrices(batch, &models[0], &normals[0]);
+            double batchedMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+            GLfloat modelError = 0.0f, normalError = 0.0f;
+            for (GLuint i = 0; i < count; i++)
+            {
+                for (GLuint c = 0; c < 4; c++)
+                    for (GLuint r = 0; r < 4; r++)
+                        modelError = std::max(modelError, std::abs(models[i][c][r] - referenceModels[i][c][r]));
+                for (GLuint c = 0; c < 3; c++)
+                    for (GLuint r = 0; r < 3; r++)
+                        normalError = std::max(normalError, std::abs(normals[i][c][r] - referenceNormals[i][c][r]));
+            }
+
+            out << std::setw(8) << count << " instances: glm " << std::fixed << std::setprecision(3) << scalarMs
+                << " ms, batched " << batchedMs << " ms (x" << std::setprecision(1) << (batchedMs > 0.0 ? scalarMs / batchedMs : 0.0) << "), "
+                << "largest difference " << std::scientific << std::setprecision(2) << modelError << " in the model matrices, "
+                << normalError << " in the normal matrices" << std::endl;
+            out.unsetf(std::ios_base::floatfield);
+        }
+    }
+}
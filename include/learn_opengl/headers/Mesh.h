@@ -41,7 +41,7 @@ public:
 
     /*  Functions  */
     // Constructor
-    Mesh(vector<Vertex> vertices, vector<GLuint> indices, vector<Texture> textures)
+    Mesh(vector<Vertex> vertices, vector<GLuint> indices, vector<Texture> textures) : DepthVAO(0), PositionVBO(0)
     {
         this->vertices = vertices;
         this->indices = indices;
@@ -91,8 +91,38 @@ public:
         }
     }
 
+    // Creates a second, tightly packed buffer holding only the positions and a VAO that reads just that buffer
+    // (sharing the index buffer). Passes that only need depth fetch 12 bytes per vertex instead of 32.
+    void SetupDepthStream()
+    {
+        if (this->DepthVAO != 0)
+            return;
+        vector<glm::vec3> positions(this->vertices.size());
+        for (GLuint i = 0; i < this->vertices.size(); i++)
+            positions[i] = this->vertices[i].Position;
+
+        glGenVertexArrays(1, &this->DepthVAO);
+        glGenBuffers(1, &this->PositionVBO);
+        glBindVertexArray(this->DepthVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->PositionVBO);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), &positions[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+        glBindVertexArray(0);
+    }
+
+    // Draws the mesh for a depth-only pass: no textures, and the position-only stream when it was set up
+    void DrawDepth()
+    {
+        glBindVertexArray(this->DepthVAO != 0 ? this->DepthVAO : this->VAO);
+        glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+    }
+
     /*  Render data  */
     GLuint VAO, VBO, EBO;
+    GLuint DepthVAO, PositionVBO;       // Position-only stream, 0 until SetupDepthStream is called
 
 //private:
     /*  Functions    */
@@ -0,0 +1,319 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <map>
+#include <queue>
+#include <cmath>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Mesh.h"
+
+
+// Symmetric 4x4 error quadric (Garland & Heckbert) stored as its 10 unique coefficients
+struct Quadric
+{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+    Quadric() : a2(0), ab(0), ac(0), ad(0), b2(0), bc(0), bd(0), c2(0), cd(0), d2(0)
+    {
+    }
+
+    // Quadric of the plane ax + by + cz + d = 0 (normal must be unit length) scaled by 'weight'
+    Quadric(double a, double b, double c, double d, double weight)
+    {
+        a2 = a * a * weight; ab = a * b * weight; ac = a * c * weight; ad = a * d * weight;
+        b2 = b * b * weight; bc = b * c * weight; bd = b * d * weight;
+        c2 = c * c * weight; cd = c * d * weight;
+        d2 = d * d * weight;
+    }
+
+    void Add(const Quadric& q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+    }
+
+    // Sum of squared distances from p to every plane accumulated in the quadric
+    double Evaluate(const glm::vec3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+             + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+             + c2 * z * z + 2 * cd * z
+             + d2;
+    }
+};
+
+
+// Quadric error metric simplification by edge collapse. Vertices are welded by position to find the topology;
+// the original vertices (with their normals and texture coordinates) are kept as wedges of each welded position,
+// so texture seams survive the collapses. Open borders are held in place by extra perpendicular planes.
+class MeshSimplifier
+{
+public:
+    // Reduces the mesh to about 'targetIndexCount' indices, writing a compacted vertex/index buffer
+    static void Simplify(const vector<Vertex>& vertices, const vector<GLuint>& indices, GLuint targetIndexCount,
+                         vector<Vertex>& outVertices, vector<GLuint>& outIndices)
+    {
+        GLuint triangleCount = (GLuint)indices.size() / 3;
+
+        // 1. Weld vertices by position
+        std::map<glm::vec3, GLuint, PositionLess> welded;
+        vector<GLuint> cluster(vertices.size());
+        vector<glm::vec3> position;
+        vector< vector<GLuint> > wedges;
+        for (GLuint i = 0; i < vertices.size(); i++)
+        {
+            std::map<glm::vec3, GLuint, PositionLess>::iterator it = welded.find(vertices[i].Position);
+            if (it == welded.end())
+            {
+                it = welded.insert(std::make_pair(vertices[i].Position, (GLuint)position.size())).first;
+                position.push_back(vertices[i].Position);
+                wedges.push_back(vector<GLuint>());
+            }
+            cluster[i] = it->second;
+            wedges[it->second].push_back(i);
+        }
+        GLuint clusterCount = (GLuint)position.size();
+
+        // 2. Triangle lists and plane quadrics per welded position
+        vector<GLuint> corners(indices);
+        vector<GLubyte> alive(triangleCount, 1);
+        vector< vector<GLuint> > clusterTriangles(clusterCount);
+        vector<Quadric> quadrics(clusterCount);
+        std::map< std::pair<GLuint, GLuint>, GLint > edgeUse;  // Triangle using the edge, or -1 when shared by more than one
+        GLuint liveTriangles = 0;
+        for (GLuint t = 0; t < triangleCount; t++)
+        {
+            GLuint c0 = cluster[corners[t * 3]], c1 = cluster[corners[t * 3 + 1]], c2 = cluster[corners[t * 3 + 2]];
+            if (c0 == c1 || c1 == c2 || c0 == c2)
+            {
+                alive[t] = 0;
+                continue;
+            }
+            liveTriangles++;
+            clusterTriangles[c0].push_back(t);
+            clusterTriangles[c1].push_back(t);
+            clusterTriangles[c2].push_back(t);
+
+            glm::vec3 normal = glm::cross(position[c1] - position[c0], position[c2] - position[c0]);
+            GLfloat length = glm::length(normal);
+            if (length > 0.0f)
+            {
+                normal /= length;
+                Quadric q(normal.x, normal.y, normal.z, -glm::dot(normal, position[c0]), length * 0.5);
+                quadrics[c0].Add(q);
+                quadrics[c1].Add(q);
+                quadrics[c2].Add(q);
+            }
+            GLuint c[3] = { c0, c1, c2 };
+            for (GLuint e = 0; e < 3; e++)
+            {
+                std::pair<GLuint, GLuint> key = edgeKey(c[e], c[(e + 1) % 3]);
+                std::map< std::pair<GLuint, GLuint>, GLint >::iterator it = edgeUse.find(key);
+                if (it == edgeUse.end())
+                    edgeUse[key] = (GLint)t;
+                else
+                    it->second = -1;
+            }
+        }
+
+        // Border edges get a heavily weighted plane perpendicular to their triangle so they don't shrink inwards
+        for (std::map< std::pair<GLuint, GLuint>, GLint >::iterator it = edgeUse.begin(); it != edgeUse.end(); ++it)
+        {
+            if (it->second < 0)
+                continue;
+            GLuint t = (GLuint)it->second;
+            glm::vec3 p0 = position[cluster[corners[t * 3]]], p1 = position[cluster[corners[t * 3 + 1]]], p2 = position[cluster[corners[t * 3 + 2]]];
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            glm::vec3 edge = position[it->first.second] - position[it->first.first];
+            glm::vec3 border = glm::cross(edge, normal);
+            GLfloat length = glm::length(border);
+            if (length <= 0.0f)
+                continue;
+            border /= length;
+            Quadric q(border.x, border.y, border.z, -glm::dot(border, position[it->first.first]), 1000.0 * glm::dot(edge, edge));
+            quadrics[it->first.first].Add(q);
+            quadrics[it->first.second].Add(q);
+        }
+
+        // 3. Greedily collapse the cheapest edge until the target is reached
+        vector<GLuint> version(clusterCount, 0);
+        vector<GLubyte> removed(clusterCount, 0);
+        std::priority_queue<Collapse, vector<Collapse>, CollapseGreater> heap;
+        for (std::map< std::pair<GLuint, GLuint>, GLint >::iterator it = edgeUse.begin(); it != edgeUse.end(); ++it)
+            heap.push(makeCollapse(it->first.first, it->first.second, position, quadrics, version));
+
+        while (liveTriangles * 3 > targetIndexCount && !heap.empty())
+        {
+            Collapse collapse = heap.top();
+            heap.pop();
+            GLuint from = collapse.From, to = collapse.To;
+            if (removed[from] || removed[to] || version[from] != collapse.FromVersion || version[to] != collapse.ToVersion)
+                continue;
+            if (flipsTriangle(from, to, corners, alive, cluster, clusterTriangles[from], position))
+                continue;
+
+            // Move every triangle of 'from' onto 'to'; those that already used 'to' collapse to nothing
+            quadrics[to].Add(quadrics[from]);
+            removed[from] = 1;
+            for (GLuint i = 0; i < clusterTriangles[from].size(); i++)
+            {
+                GLuint t = clusterTriangles[from][i];
+                if (!alive[t])
+                    continue;
+                GLuint* tri = &corners[t * 3];
+                if (cluster[tri[0]] == to || cluster[tri[1]] == to || cluster[tri[2]] == to)
+                {
+                    alive[t] = 0;
+                    liveTriangles--;
+                    continue;
+                }
+                for (GLuint k = 0; k < 3; k++)
+                {
+                    if (cluster[tri[k]] == from)
+                        tri[k] = closestWedge(vertices[tri[k]], wedges[to], vertices);
+                }
+                clusterTriangles[to].push_back(t);
+            }
+            clusterTriangles[from].clear();
+            version[to]++;
+
+            // Re-evaluate every edge around the merged position
+            vector<GLuint> live;
+            for (GLuint i = 0; i < clusterTriangles[to].size(); i++)
+            {
+                GLuint t = clusterTriangles[to][i];
+                if (!alive[t])
+                    continue;
+                live.push_back(t);
+                for (GLuint k = 0; k < 3; k++)
+                {
+                    GLuint neighbour = cluster[corners[t * 3 + k]];
+                    if (neighbour != to)
+                        heap.push(makeCollapse(to, neighbour, position, quadrics, version));
+                }
+            }
+            clusterTriangles[to].swap(live);
+        }
+
+        // 4. Compact the wedges that are still referenced
+        outVertices.clear();
+        outIndices.clear();
+        vector<GLint> remap(vertices.size(), -1);
+        for (GLuint t = 0; t < triangleCount; t++)
+        {
+            if (!alive[t])
+                continue;
+            for (GLuint k = 0; k < 3; k++)
+            {
+                GLuint v = corners[t * 3 + k];
+                if (remap[v] < 0)
+                {
+                    remap[v] = (GLint)outVertices.size();
+                    outVertices.push_back(vertices[v]);
+                }
+                outIndices.push_back((GLuint)remap[v]);
+            }
+        }
+    }
+
+private:
+    struct PositionLess
+    {
+        bool operator()(const glm::vec3& a, const glm::vec3& b) const
+        {
+            if (a.x != b.x) return a.x < b.x;
+            if (a.y != b.y) return a.y < b.y;
+            return a.z < b.z;
+        }
+    };
+
+    struct Collapse
+    {
+        double Cost;
+        GLuint From, To;
+        GLuint FromVersion, ToVersion;
+    };
+
+    struct CollapseGreater
+    {
+        bool operator()(const Collapse& a, const Collapse& b) const
+        {
+            return a.Cost > b.Cost;
+        }
+    };
+
+    static std::pair<GLuint, GLuint> edgeKey(GLuint a, GLuint b)
+    {
+        return a < b ? std::make_pair(a, b) : std::make_pair(b, a);
+    }
+
+    // Picks the cheaper direction of collapsing the edge a-b (the survivor keeps its position)
+    static Collapse makeCollapse(GLuint a, GLuint b, const vector<glm::vec3>& position, const vector<Quadric>& quadrics, const vector<GLuint>& version)
+    {
+        Quadric q = quadrics[a];
+        q.Add(quadrics[b]);
+        double toB = q.Evaluate(position[b]);
+        double toA = q.Evaluate(position[a]);
+        Collapse collapse;
+        collapse.Cost = toB <= toA ? toB : toA;
+        collapse.From = toB <= toA ? a : b;
+        collapse.To = toB <= toA ? b : a;
+        collapse.FromVersion = version[collapse.From];
+        collapse.ToVersion = version[collapse.To];
+        return collapse;
+    }
+
+    // True when moving 'from' onto 'to' would flip (or flatten) one of the triangles that survive the collapse
+    static bool flipsTriangle(GLuint from, GLuint to, const vector<GLuint>& corners, const vector<GLubyte>& alive, const vector<GLuint>& cluster,
+                              const vector<GLuint>& triangles, const vector<glm::vec3>& position)
+    {
+        for (GLuint i = 0; i < triangles.size(); i++)
+        {
+            GLuint t = triangles[i];
+            if (!alive[t])
+                continue;
+            GLuint c[3] = { cluster[corners[t * 3]], cluster[corners[t * 3 + 1]], cluster[corners[t * 3 + 2]] };
+            if (c[0] == to || c[1] == to || c[2] == to)
+                continue;
+            glm::vec3 before[3] = { position[c[0]], position[c[1]], position[c[2]] };
+            glm::vec3 after[3] = { before[0], before[1], before[2] };
+            for (GLuint k = 0; k < 3; k++)
+            {
+                if (c[k] == from)
+                    after[k] = position[to];
+            }
+            glm::vec3 oldNormal = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 newNormal = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(oldNormal, newNormal) <= 0.0f)
+                return true;
+        }
+        return false;
+    }
+
+    // The wedge of the surviving position whose texture coordinates and normal best match the removed one
+    static GLuint closestWedge(const Vertex& vertex, const vector<GLuint>& candidates, const vector<Vertex>& vertices)
+    {
+        GLuint best = candidates[0];
+        GLfloat bestDistance = -1.0f;
+        for (GLuint i = 0; i < candidates.size(); i++)
+        {
+            const Vertex& candidate = vertices[candidates[i]];
+            glm::vec2 uv = candidate.TexCoords - vertex.TexCoords;
+            glm::vec3 normal = candidate.Normal - vertex.Normal;
+            GLfloat distance = glm::dot(uv, uv) + glm::dot(normal, normal);
+            if (bestDistance < 0.0f || distance < bestDistance)
+            {
+                best = candidates[i];
+                bestDistance = distance;
+            }
+        }
+        return best;
+    }
+};
@@ -5,18 +5,24 @@
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <queue>
+#include <algorithm>
 #include <vector>
 using namespace std;
 // GL Includes
 #include <GL/glew.h> // Contains all the necessery OpenGL includes
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <SOIL.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "Mesh.h"
+#include "MeshSimplifier.h"
+#include "Transform.h"
+#include "CpuProfiler.h"
 
 GLint TextureFromFile(const char* path, string directory);
 
@@ -25,7 +31,7 @@ class Model
 public:
     /*  Functions   */
     // Constructor, expects a filepath to a 3D model.
-    Model(const GLchar* path)
+    Model(const GLchar* path) : boundingRadius(0.0f)
     {
         this->loadModel(path);
     }
@@ -36,7 +42,110 @@ public:
         for (GLuint i = 0; i < this->meshes.size(); i++)
             this->meshes[i].Draw(shader);
     }
+
+    // Draws the model with each mesh placed by its node's world matrix, relative to the given model matrix
+    void Draw(Shader shader, glm::mat4 model)
+    {
+        this->nodes.UpdateWorldMatrices();
+        GLint modelLoc = glGetUniformLocation(shader.Program, "model");
+        for (GLuint i = 0; i < this->meshes.size(); i++)
+        {
+            glm::mat4 meshModel = model * this->nodes.GetWorldMatrix(this->meshNodes[i]);
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(meshModel));
+            this->meshes[i].Draw(shader);
+        }
+    }
+
+    // Builds 'levels' - 1 simplified copies of every mesh, each with about 'reduction' times the triangles of the previous level.
+    // Level 0 is the mesh as loaded; simplification stops early once a mesh gets too small to reduce any further.
+    void GenerateLods(GLuint levels, GLfloat reduction = 0.5f)
+    {
+        CPU_PROFILE_ZONE("Model LOD generation");
+        this->lods.clear();
+        this->lods.push_back(this->meshes);
+        for (GLuint level = 1; level < levels; level++)
+        {
+            vector<Mesh> lod;
+            for (GLuint i = 0; i < this->meshes.size(); i++)
+            {
+                const Mesh& previous = this->lods[level - 1][i];
+                GLuint target = (GLuint)(previous.indices.size() / 3 * reduction) * 3;
+                vector<Vertex> vertices;
+                vector<GLuint> indices;
+                MeshSimplifier::Simplify(previous.vertices, previous.indices, target, vertices, indices);
+                if (indices.empty() || indices.size() >= previous.indices.size())
+                    lod.push_back(previous);
+                else
+                    lod.push_back(Mesh(vertices, indices, previous.textures));
+            }
+            this->lods.push_back(lod);
+        }
+    }
+
+    // Draws the given level of detail (clamped to the coarsest one generated)
+    void DrawLod(Shader shader, GLuint level)
+    {
+        if (this->lods.empty())
+        {
+            this->Draw(shader);
+            return;
+        }
+        vector<Mesh>& lod = this->lods[level < this->lods.size() ? level : this->lods.size() - 1];
+        for (GLuint i = 0; i < lod.size(); i++)
+            lod[i].Draw(shader);
+    }
+
+    // Gives every mesh (and every level of detail generated so far) a position-only stream for depth passes.
+    // Levels that kept a mesh unchanged share its buffers, so they share its depth stream as well.
+    void SetupDepthStreams()
+    {
+        map<GLuint, Mesh*> streams;
+        for (GLuint i = 0; i < this->meshes.size(); i++)
+            this->setupDepthStream(this->meshes[i], streams);
+        for (GLuint level = 0; level < this->lods.size(); level++)
+            for (GLuint i = 0; i < this->lods[level].size(); i++)
+                this->setupDepthStream(this->lods[level][i], streams);
+    }
+
+    // Draws every mesh for a depth-only pass
+    void DrawDepth()
+    {
+        for (GLuint i = 0; i < this->meshes.size(); i++)
+            this->meshes[i].DrawDepth();
+    }
+
+    // Draws the given level of detail for a depth-only pass
+    void DrawLodDepth(GLuint level)
+    {
+        if (this->lods.empty())
+        {
+            this->DrawDepth();
+            return;
+        }
+        vector<Mesh>& lod = this->lods[level < this->lods.size() ? level : this->lods.size() - 1];
+        for (GLuint i = 0; i < lod.size(); i++)
+            lod[i].DrawDepth();
+    }
+
+    GLuint LodCount() const
+    {
+        return this->lods.empty() ? 1 : (GLuint)this->lods.size();
+    }
+
+    GLuint TriangleCount(GLuint level) const
+    {
+        const vector<Mesh>& lod = this->lods.empty() ? this->meshes : this->lods[level < this->lods.size() ? level : this->lods.size() - 1];
+        GLuint triangles = 0;
+        for (GLuint i = 0; i < lod.size(); i++)
+            triangles += (GLuint)lod[i].indices.size() / 3;
+        return triangles;
+    }
+
     vector<Mesh> meshes;
+    vector<GLuint> meshNodes;           // Index of the node in 'nodes' each mesh hangs from
+    TransformHierarchy nodes;           // The aiNode tree with each node's local transformation
+    vector< vector<Mesh> > lods;        // Meshes per level of detail, filled by GenerateLods
+    GLfloat boundingRadius;             // Radius around the model-space origin enclosing every vertex, placed by its node
     vector<Texture> textures_loaded;	// Stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
 
 
@@ -45,9 +154,23 @@ private:
     string directory;
 
     /*  Functions   */
+    void setupDepthStream(Mesh& mesh, map<GLuint, Mesh*>& streams)
+    {
+        map<GLuint, Mesh*>::iterator shared = streams.find(mesh.VAO);
+        if (shared != streams.end())
+        {
+            mesh.DepthVAO = shared->second->DepthVAO;
+            mesh.PositionVBO = shared->second->PositionVBO;
+            return;
+        }
+        mesh.SetupDepthStream();
+        streams[mesh.VAO] = &mesh;
+    }
+
     // Loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string path)
     {
+        CPU_PROFILE_ZONE("Model load");
         // Read file via ASSIMP
         Assimp::Importer importer;
         const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
@@ -62,25 +185,54 @@ private:
 
         // Process ASSIMP's root node recursively
         this->processNode(scene->mRootNode, scene);
-    }
 
-    // Processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode* node, const aiScene* scene)
-    {
-        // Process each mesh located at the current node
-        for (GLuint i = 0; i < node->mNumMeshes; i++)
+        // The radius is measured in model space, so each mesh is placed by its node's world matrix first
+        this->nodes.UpdateWorldMatrices();
+        for (GLuint i = 0; i < this->meshes.size(); i++)
         {
-            // The node object only contains indices to index the actual objects in the scene. 
-            // The scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            this->meshes.push_back(this->processMesh(mesh, scene));
+            glm::mat4 world = this->nodes.GetWorldMatrix(this->meshNodes[i]);
+            for (GLuint j = 0; j < this->meshes[i].vertices.size(); j++)
+            {
+                glm::vec3 position = glm::vec3(world * glm::vec4(this->meshes[i].vertices[j].Position, 1.0f));
+                this->boundingRadius = std::max(this->boundingRadius, glm::length(position));
+            }
         }
-        // After we've processed all of the meshes (if any) we then recursively process each of the children nodes
-        for (GLuint i = 0; i < node->mNumChildren; i++)
+    }
+
+    // Processes the node tree breadth-first. Each node's transformation is stored in the transform hierarchy
+    // (parents always before children) and each mesh located at a node remembers which node it belongs to.
+    void processNode(aiNode* root, const aiScene* scene)
+    {
+        queue< pair<aiNode*, GLint> > pending;
+        pending.push(make_pair(root, -1));
+        while (!pending.empty())
         {
-            this->processNode(node->mChildren[i], scene);
-        }
+            aiNode* node = pending.front().first;
+            GLint parent = pending.front().second;
+            pending.pop();
+
+            // Split the node's transformation into translation, rotation and scale
+            aiVector3D scaling, position;
+            aiQuaternion rotation;
+            node->mTransformation.Decompose(scaling, rotation, position);
+            GLuint index = this->nodes.AddNode(parent,
+                glm::vec3(position.x, position.y, position.z),
+                glm::quat(rotation.w, rotation.x, rotation.y, rotation.z),
+                glm::vec3(scaling.x, scaling.y, scaling.z));
 
+            // Process each mesh located at the current node
+            for (GLuint i = 0; i < node->mNumMeshes; i++)
+            {
+                // The node object only contains indices to index the actual objects in the scene. 
+                // The scene contains all the data, node is just to keep stuff organized (like relations between nodes).
+                aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+                this->meshes.push_back(this->processMesh(mesh, scene));
+                this->meshNodes.push_back(index);
+            }
+            // Queue the children so they are processed after every node of the current depth
+            for (GLuint i = 0; i < node->mNumChildren; i++)
+                pending.push(make_pair(node->mChildren[i], (GLint)index));
+        }
     }
 
     Mesh processMesh(aiMesh* mesh, const aiScene* scene)
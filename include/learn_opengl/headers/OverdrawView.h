@@ -0,0 +1,292 @@
+#pragma once
+// Std. Includes
+#include <iostream>
+#include <algorithm>
+
+// GL Includes
+#include <GL/glew.h>
+
+
+// Debug view that shows how many fragments were shaded per pixel, as a heatmap, and measures it.
+// While enabled, Begin redirects the frame into an offscreen target whose stencil buffer counts the fragments that
+// reach each pixel (it works with whatever shaders the scene uses). End turns the stencil counts into a float
+// counter texture by additively blending one full-screen pass per count level, draws the heatmap into the
+// framebuffer that was bound at Begin, and starts an asynchronous readback of the counters.
+// A GL_SAMPLES_PASSED query gives the exact number of shaded fragments; the counters give the distribution.
+// Both are read back a few frames later without stalling the pipeline.
+class OverdrawView
+{
+public:
+    static const GLuint MaxLevels = 32;     // Counts at or above this saturate the heatmap and the readback
+    static const GLuint ReadbackFrames = 3; // Pixel buffers in flight
+
+    /*  Options  */
+    GLboolean Enabled;
+    GLboolean CountDepthFailures;   // Also count fragments that fail the depth test (raster rather than shading cost)
+
+    /*  Statistics of the last frame read back  */
+    GLuint ShadedFragments;         // From the occlusion query
+    GLuint ShadedPixels;            // Pixels shaded at least once
+    GLfloat AverageOverdraw;        // Fragments per shaded pixel
+    GLuint MaxOverdraw;             // Most fragments in one pixel (saturates at MaxLevels)
+    GLuint FramesMeasured;
+
+    /*  Functions  */
+    // Constructor, the size must match the viewport the scene renders with
+    OverdrawView(GLuint width, GLuint height)
+        : Enabled(false), CountDepthFailures(false), ShadedFragments(0), ShadedPixels(0), AverageOverdraw(0.0f),
+          MaxOverdraw(0), FramesMeasured(0), width(width), height(height), previousFramebuffer(0), frame(0),
+          pixels(width * height)
+    {
+        // Scene colour, fragment counter and a depth-stencil buffer that does the counting
+        glGenTextures(1, &this->sceneColor);
+        glBindTexture(GL_TEXTURE_2D, this->sceneColor);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glGenTextures(1, &this->counter);
+        glBindTexture(GL_TEXTURE_2D, this->counter);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, width, height, 0, GL_RED, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glGenRenderbuffers(1, &this->depthStencil);
+        glBindRenderbuffer(GL_RENDERBUFFER, this->depthStencil);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        GLint framebuffer = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        glGenFramebuffers(1, &this->FBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->sceneColor, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, this->counter, 0);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depthStencil);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Overdraw framebuffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+        this->resolveProgram = createProgram(
+            "#version 330 core\n"
+            "out float Count;\n"
+            "void main() { Count = 1.0; }\n");
+        this->heatmapProgram = createProgram(
+            "#version 330 core\n"
+            "out vec4 color;\n"
+            "uniform sampler2D counter;\n"
+            "uniform float maxLevels;\n"
+            "void main()\n"
+            "{\n"
+            "    float count = texelFetch(counter, ivec2(gl_FragCoord.xy), 0).r;\n"
+            "    // 0 black, 1 blue, then through green, yellow and red to white at the saturation level\n"
+            "    float t = clamp((count - 1.0) / (maxLevels - 1.0), 0.0, 1.0) * 4.0;\n"
+            "    vec3 ramp[5] = vec3[](vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0), vec3(1.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), vec3(1.0));\n"
+            "    int i = min(int(t), 3);\n"
+            "    color = count < 0.5 ? vec4(0.0, 0.0, 0.0, 1.0) : vec4(mix(ramp[i], ramp[i + 1], t - float(i)), 1.0);\n"
+            "}\n");
+        // The full-screen triangle is generated from gl_VertexID, but core profile still wants a VAO bound
+        glGenVertexArrays(1, &this->emptyVAO);
+
+        glGenQueries(ReadbackFrames, this->queries);
+        glGenBuffers(ReadbackFrames, this->readbackBuffers);
+        for (GLuint i = 0; i < ReadbackFrames; i++)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, this->readbackBuffers[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, this->pixels * sizeof(GLfloat), NULL, GL_STREAM_READ);
+            this->fences[i] = 0;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    // Call where the frame starts drawing (before its clear). Does nothing while disabled.
+    void Begin()
+    {
+        this->collect();
+        if (!this->Enabled)
+            return;
+
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &this->previousFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+        glStencilMask(0xFF);
+        glClearStencil(0);
+        glClear(GL_STENCIL_BUFFER_BIT);
+
+        // Every fragment that passes (or, optionally, fails) the depth test bumps its pixel's stencil value
+        glEnable(GL_STENCIL_TEST);
+        glStencilFunc(GL_ALWAYS, 0, 0xFF);
+        glStencilOp(GL_KEEP, this->CountDepthFailures ? GL_INCR : GL_KEEP, GL_INCR);
+
+        GLuint slot = this->frame % ReadbackFrames;
+        if (this->fences[slot] == 0)
+            glBeginQuery(GL_SAMPLES_PASSED, this->queries[slot]);
+    }
+
+    // Call where the frame is done drawing (before swapping or post-processing). Does nothing while disabled.
+    void End()
+    {
+        if (!this->Enabled)
+            return;
+
+        GLuint slot = this->frame % ReadbackFrames;
+        bool measuring = this->fences[slot] == 0;
+        if (measuring)
+            glEndQuery(GL_SAMPLES_PASSED);
+
+        // Save the state the resolve touches
+        GLint program = 0, vertexArray = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+        GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+        GLboolean blend = glIsEnabled(GL_BLEND);
+        GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+        GLint blendSrc = 0, blendDst = 0;
+        glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrc);
+        glGetIntegerv(GL_BLEND_DST_RGB, &blendDst);
+
+        // Stencil counts -> float counter: pass 'level' adds one to every pixel counted at least 'level' times
+        glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
+        glDrawBuffer(GL_COLOR_ATTACHMENT1);
+        GLfloat zero[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        glClearBufferfv(GL_COLOR, 0, zero);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glEnable(GL_STENCIL_TEST);
+        glStencilMask(0x00);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        glUseProgram(this->resolveProgram);
+        glBindVertexArray(this->emptyVAO);
+        for (GLuint level = 1; level <= MaxLevels; level++)
+        {
+            glStencilFunc(GL_LEQUAL, level, 0xFF);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        glDisable(GL_BLEND);
+        glDisable(GL_STENCIL_TEST);
+        glStencilMask(0xFF);
+        glStencilFunc(GL_ALWAYS, 0, 0xFF);
+
+        // Start reading the counters back; they're mapped once the fence says the copy is done
+        if (measuring)
+        {
+            glReadBuffer(GL_COLOR_ATTACHMENT1);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, this->readbackBuffers[slot]);
+            glReadPixels(0, 0, this->width, this->height, GL_RED, GL_FLOAT, 0);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            glReadBuffer(GL_COLOR_ATTACHMENT0);
+            this->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+
+        // Heatmap into the framebuffer the frame was meant for
+        glBindFramebuffer(GL_FRAMEBUFFER, this->previousFramebuffer);
+        glUseProgram(this->heatmapProgram);
+        glUniform1f(glGetUniformLocation(this->heatmapProgram, "maxLevels"), (GLfloat)MaxLevels);
+        glUniform1i(glGetUniformLocation(this->heatmapProgram, "counter"), 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, this->counter);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // Restore
+        glBindVertexArray(vertexArray);
+        glUseProgram(program);
+        if (depthTest)
+            glEnable(GL_DEPTH_TEST);
+        if (blend)
+            glEnable(GL_BLEND);
+        if (cullFace)
+            glEnable(GL_CULL_FACE);
+        glBlendFunc(blendSrc, blendDst);
+        this->frame++;
+    }
+
+    void PrintStats(std::ostream& out = std::cout) const
+    {
+        out << "Overdraw: " << this->ShadedFragments << " fragments over " << this->ShadedPixels << " pixels ("
+            << 100.0f * this->ShadedPixels / this->pixels << "% of the screen), average " << this->AverageOverdraw
+            << ", max " << this->MaxOverdraw << (this->MaxOverdraw >= MaxLevels ? "+" : "")
+            << (this->CountDepthFailures ? " (including depth test failures)" : "") << std::endl;
+    }
+
+private:
+    GLuint width, height;
+    GLuint FBO, sceneColor, counter, depthStencil;
+    GLuint resolveProgram, heatmapProgram, emptyVAO;
+    GLint previousFramebuffer;
+    GLuint frame;
+    GLuint pixels;
+    GLuint queries[ReadbackFrames];
+    GLuint readbackBuffers[ReadbackFrames];
+    GLsync fences[ReadbackFrames];
+
+    // Reads back every measurement whose copy has finished, without waiting for the ones that haven't
+    void collect()
+    {
+        for (GLuint i = 0; i < ReadbackFrames; i++)
+        {
+            if (this->fences[i] == 0)
+                continue;
+            GLenum status = glClientWaitSync(this->fences[i], 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                continue;
+            glDeleteSync(this->fences[i]);
+            this->fences[i] = 0;
+
+            glGetQueryObjectuiv(this->queries[i], GL_QUERY_RESULT, &this->ShadedFragments);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, this->readbackBuffers[i]);
+            const GLfloat* counts = (const GLfloat*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, this->pixels * sizeof(GLfloat), GL_MAP_READ_BIT);
+            if (counts)
+            {
+                GLuint shaded = 0, maxCount = 0;
+                for (GLuint p = 0; p < this->pixels; p++)
+                {
+                    GLuint count = (GLuint)(counts[p] + 0.5f);
+                    if (count > 0)
+                        shaded++;
+                    maxCount = std::max(maxCount, count);
+                }
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                this->ShadedPixels = shaded;
+                this->MaxOverdraw = maxCount;
+                this->AverageOverdraw = shaded > 0 ? (GLfloat)this->ShadedFragments / (GLfloat)shaded : 0.0f;
+                this->FramesMeasured++;
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+    }
+
+    static GLuint createProgram(const GLchar* fragmentSource)
+    {
+        const GLchar* vertexSource =
+            "#version 330 core\n"
+            "void main()\n"
+            "{\n"
+            "    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+            "    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+            "}\n";
+        GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vertexSource, NULL);
+        glCompileShader(vertex);
+        GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fragmentSource, NULL);
+        glCompileShader(fragment);
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glLinkProgram(program);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[512];
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return program;
+    }
+};
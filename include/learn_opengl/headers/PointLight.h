@@ -0,0 +1,60 @@
+#pragma once
+// Std. Includes
+#include <cmath>
+#include <algorithm>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+
+// Point light with the constant/linear/quadratic attenuation of the lighting shaders
+struct PointLight
+{
+    glm::vec3 Position;
+    glm::vec3 Ambient;
+    glm::vec3 Diffuse;
+    glm::vec3 Specular;
+    GLfloat Constant;
+    GLfloat Linear;
+    GLfloat Quadratic;
+
+    PointLight(glm::vec3 position = glm::vec3(0.0f), glm::vec3 color = glm::vec3(1.0f), GLfloat constant = 1.0f,
+               GLfloat linear = 0.09f, GLfloat quadratic = 0.032f)
+        : Position(position), Ambient(color * 0.05f), Diffuse(color), Specular(color), Constant(constant), Linear(linear),
+          Quadratic(quadratic)
+    {
+    }
+
+    // Distance beyond which the light adds less than 'threshold' to any colour channel: the strongest channel of
+    // ambient + diffuse + specular, divided by the attenuation, drops below it. Solves
+    // quadratic * d^2 + linear * d + constant = strongest / threshold for d.
+    GLfloat Radius(GLfloat threshold = 1.0f / 256.0f) const
+    {
+        glm::vec3 sum = this->Ambient + this->Diffuse + this->Specular;
+        GLfloat strongest = std::max(sum.x, std::max(sum.y, sum.z));
+        GLfloat c = this->Constant - strongest / threshold;
+        if (c >= 0.0f)
+            return 0.0f;                    // Never bright enough to matter
+        if (this->Quadratic > 0.0f)
+            return (-this->Linear + std::sqrt(this->Linear * this->Linear - 4.0f * this->Quadratic * c)) / (2.0f * this->Quadratic);
+        if (this->Linear > 0.0f)
+            return -c / this->Linear;
+        return 1e30f;                       // No falloff at all
+    }
+
+    // Writes the light as the four RGBA32F texels of the light buffers (ClusteredLighting, LightManager):
+    // position + radius, ambient + constant, diffuse + linear, specular + quadratic
+    void Pack(GLfloat* texels, GLfloat radius) const
+    {
+        const glm::vec3* vectors[4] = { &this->Position, &this->Ambient, &this->Diffuse, &this->Specular };
+        const GLfloat scalars[4] = { radius, this->Constant, this->Linear, this->Quadratic };
+        for (GLuint t = 0; t < 4; t++)
+        {
+            texels[4 * t] = vectors[t]->x;
+            texels[4 * t + 1] = vectors[t]->y;
+            texels[4 * t + 2] = vectors[t]->z;
+            texels[4 * t + 3] = scalars[t];
+        }
+    }
+};
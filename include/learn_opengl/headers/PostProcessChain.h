@@ -0,0 +1,800 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+
+#include "RenderGraph.h"
+
+
+// Stack of full-screen effects drawn as few passes as possible. Per-pixel effects (invert, grayscale, tonemap, gamma)
+// are fused into the generated shader of their neighbours; a 3x3 kernel needs its input at the neighbouring pixels,
+// so the effects before it are applied to each of its taps and the effects after it to the result. Only a second
+// kernel, which would need the first one's result at its neighbours, starts a new pass; the passes ping-pong
+// through transient render graph textures.
+// Separable kernels (Gaussian, box, Sobel) of any radius take a horizontal and a vertical pass, so their cost grows
+// linearly with the radius. Neighbouring taps with non-negative weights are merged into one bilinear fetch between
+// the two texels, which halves the fetches of the blurs and, once they're wide enough for fetches to dominate, about
+// halves their time. The horizontal pass writes a half-float target, so
+// gradients keep their sign and range until the vertical pass; the effects after the kernel fuse into that pass.
+// Taps are KernelSpacing texels apart, measured on the texture each pass reads, whatever its resolution.
+// With Fuse off every effect gets a pass of its own, which is what stacking the single-effect shaders costs.
+// With Compute on and a GL 4.3 context, the passes with a kernel run as compute shaders instead: each work group
+// loads its tile plus the kernel's reach into shared memory once, so every texel is fetched (and has the effects
+// before the kernel applied) about once rather than once per tap, and writes its pixels with image stores.
+// Generated programs are cached by source, so switching between chains doesn't recompile.
+class PostProcessChain
+{
+public:
+    enum Effect {
+        INVERT,
+        GRAYSCALE,
+        TONEMAP,
+        GAMMA,
+        KERNEL,
+        SEPARABLE
+    };
+
+    struct Operation
+    {
+        Effect Type;
+        std::string Name;
+        GLfloat Weights[9];     // KERNEL: top row first, as the screen shows it
+        GLfloat Parameter;      // TONEMAP: exposure, GAMMA: gamma
+        std::vector<GLfloat> Horizontal, Vertical;  // SEPARABLE: weights from -radius to +radius (left to right,
+                                                    // bottom to top); the kernel is their outer product
+    };
+
+    /*  Options  */
+    GLboolean Fuse;
+    GLboolean LinearTaps;       // Merge pairs of non-negative taps of separable kernels into bilinear fetches
+    GLfloat KernelSpacing;      // Distance between kernel taps in texels
+    GLboolean Compute;          // Run kernel passes as compute shaders when the context has them (GL 4.3)
+
+    /*  Chain  */
+    std::vector<Operation> Operations;
+
+    /*  Functions  */
+    // Constructor, needs a current GL context
+    PostProcessChain() : Fuse(true), LinearTaps(true), KernelSpacing(1.0f), Compute(false), dirty(true)
+    {
+        // The full-screen triangle is generated from gl_VertexID, but core profile still wants a VAO bound
+        glGenVertexArrays(1, &this->emptyVAO);
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        this->computeSupported = major > 4 || (major == 4 && minor >= 3);
+        this->sharedMemory = 0;
+        if (this->computeSupported)
+            glGetIntegerv(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, &this->sharedMemory);
+        // Copies the last pass's result into an output compute shaders can't store to
+        this->addStage(POINT, 0, -1);
+        this->copyStage = this->stages.back();
+        this->stages.clear();
+    }
+
+    ~PostProcessChain()
+    {
+        this->Release();
+    }
+
+    // Deletes the programs and the vertex array; the chain can't run afterwards. Call it while the context is still
+    // current when the chain outlives it.
+    void Release()
+    {
+        for (std::map<std::string, GLuint>::iterator it = this->programs.begin(); it != this->programs.end(); ++it)
+            glDeleteProgram(it->second);
+        this->programs.clear();
+        if (this->emptyVAO != 0)
+            glDeleteVertexArrays(1, &this->emptyVAO);
+        this->emptyVAO = 0;
+        this->dirty = true;
+    }
+
+    PostProcessChain& Clear()
+    {
+        this->Operations.clear();
+        this->dirty = true;
+        return *this;
+    }
+
+    PostProcessChain& Invert() { return this->add(INVERT, "invert", 0.0f); }
+    PostProcessChain& Grayscale() { return this->add(GRAYSCALE, "grayscale", 0.0f); }
+    PostProcessChain& Tonemap(GLfloat exposure = 1.0f) { return this->add(TONEMAP, "tonemap", exposure); }
+    PostProcessChain& Gamma(GLfloat gamma = 2.2f) { return this->add(GAMMA, "gamma", gamma); }
+
+    PostProcessChain& Kernel(const std::string& name, const GLfloat weights[9])
+    {
+        this->add(KERNEL, name, 0.0f);
+        std::copy(weights, weights + 9, this->Operations.back().Weights);
+        return *this;
+    }
+
+    // The kernels of the single-effect shaders
+    PostProcessChain& Sharpen()
+    {
+        const GLfloat weights[9] = { -1.0f, -1.0f, -1.0f, -1.0f, 9.0f, -1.0f, -1.0f, -1.0f, -1.0f };
+        return this->Kernel("sharpen", weights);
+    }
+
+    PostProcessChain& Blur()
+    {
+        const GLfloat weights[9] = { 1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f, 2.0f / 16.0f, 4.0f / 16.0f, 2.0f / 16.0f,
+                                     1.0f / 16.0f, 2.0f / 16.0f, 1.0f / 16.0f };
+        return this->Kernel("blur", weights);
+    }
+
+    PostProcessChain& EdgeDetection()
+    {
+        const GLfloat weights[9] = { 1.0f, 1.0f, 1.0f, 1.0f, -8.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+        return this->Kernel("edge detection", weights);
+    }
+
+    PostProcessChain& Emboss()
+    {
+        const GLfloat weights[9] = { -2.0f, -1.0f, 0.0f, -1.0f, 1.0f, 1.0f, 0.0f, 1.0f, 2.0f };
+        return this->Kernel("emboss", weights);
+    }
+
+    PostProcessChain& TopSobel()
+    {
+        const GLfloat weights[9] = { 1.0f, 2.0f, 1.0f, 0.0f, 0.0f, 0.0f, -1.0f, -2.0f, -1.0f };
+        return this->Kernel("top sobel", weights);
+    }
+
+    // Separable kernels of any radius
+    PostProcessChain& Separable(const std::string& name, const std::vector<GLfloat>& horizontal, const std::vector<GLfloat>& vertical)
+    {
+        this->add(SEPARABLE, name, 0.0f);
+        this->Operations.back().Horizontal = horizontal;
+        this->Operations.back().Vertical = vertical;
+        return *this;
+    }
+
+    // Normalized Gaussian over [-radius, radius]; sigma defaults to half the radius
+    PostProcessChain& Gaussian(GLuint radius, GLfloat sigma = 0.0f)
+    {
+        sigma = sigma > 0.0f ? sigma : std::max(0.5f, radius / 2.0f);
+        std::vector<GLfloat> weights(2 * radius + 1);
+        GLfloat sum = 0.0f;
+        for (GLint i = -(GLint)radius; i <= (GLint)radius; i++)
+            sum += weights[i + radius] = std::exp(-(GLfloat)(i * i) / (2.0f * sigma * sigma));
+        for (GLuint i = 0; i < weights.size(); i++)
+            weights[i] /= sum;
+        return this->Separable("gaussian " + std::to_string(radius), weights, weights);
+    }
+
+    PostProcessChain& Box(GLuint radius)
+    {
+        std::vector<GLfloat> weights(2 * radius + 1, 1.0f / (2 * radius + 1));
+        return this->Separable("box " + std::to_string(radius), weights, weights);
+    }
+
+    // Top Sobel as a smoothing row times a differencing column, the same response as TopSobel()
+    PostProcessChain& Sobel()
+    {
+        std::vector<GLfloat> smooth(3), difference(3);
+        smooth[0] = 1.0f; smooth[1] = 2.0f; smooth[2] = 1.0f;
+        difference[0] = -1.0f; difference[1] = 0.0f; difference[2] = 1.0f;
+        return this->Separable("separable sobel", smooth, difference);
+    }
+
+    // Number of full-screen passes the chain takes with the current options
+    GLuint Passes()
+    {
+        this->build();
+        return (GLuint)this->stages.size();
+    }
+
+    // Adds the chain's passes to 'graph', from 'input' to 'output'; the textures in between have the input's size
+    void AddPasses(RenderGraph& graph, RenderGraph::Resource input, RenderGraph::Resource output)
+    {
+        this->build();
+        // A compute shader can only store to a texture of its own format and size, so when the last pass runs as
+        // one but the output isn't such a texture (the backbuffer, say), a copy pass draws its result into it
+        RenderGraph::TextureDesc in = graph.Desc(input), out = graph.Desc(output);
+        bool copy = this->computable(this->stages.back()) && (graph.IsBackbuffer(output) ||
+            out.InternalFormat != this->format(this->stages.back()) || out.Width != in.Width || out.Height != in.Height);
+        GLuint passes = (GLuint)this->stages.size() + (copy ? 1 : 0);
+        this->targets.assign(passes, output);
+        RenderGraph::Resource source = input;
+        for (GLuint i = 0; i < passes; i++)
+        {
+            bool last = i + 1 == passes;
+            RenderGraph::TextureDesc desc(in.Width, in.Height, i < this->stages.size() ? this->format(this->stages[i]) : GL_RGBA8);
+            graph.AddPass("post-process: " + (i < this->stages.size() ? this->stages[i].Name : this->copyStage.Name), [&](RenderGraph::Builder& builder)
+            {
+                builder.Read(source);
+                if (last)
+                    builder.Write(output);
+                else
+                    this->targets[i] = builder.Create("post-process " + std::to_string(i), desc);
+            }, [this, &graph, source, i]()
+            {
+                RenderGraph::Resource target = this->targets[i];
+                const RenderGraph::TextureDesc& from = graph.Desc(source), & to = graph.Desc(target);
+                bool image = !graph.IsBackbuffer(target) && from.Width == to.Width && from.Height == to.Height;
+                this->run(i, graph.Texture(source), image ? graph.Texture(target) : 0, to.InternalFormat, to.Width, to.Height);
+            });
+            source = this->targets[i];
+        }
+    }
+
+    // Whether the context has compute shaders (GL 4.3); without them Compute is ignored
+    bool ComputeSupported() const
+    {
+        return this->computeSupported;
+    }
+
+    // Prints the passes and the estimated texture traffic per frame at the given size, fused and unfused
+    void PrintStats(GLsizei width, GLsizei height, std::ostream& out = std::cout)
+    {
+        GLboolean fuse = this->Fuse;
+        this->Fuse = true;
+        this->build();
+        out << "Post-process chain:";
+        for (GLuint i = 0; i < this->Operations.size(); i++)
+            out << (i > 0 ? " -> " : " ") << this->Operations[i].Name;
+        out << (this->Operations.empty() ? " empty" : "") << std::endl;
+        for (GLuint i = 0; i < this->stages.size(); i++)
+        {
+            out << "  pass " << i << ": " << this->stages[i].Name << " (" << this->stages[i].Fetches << " fetches per pixel";
+            if (this->computable(this->stages[i]))
+                out << "; as a compute shader " << this->stages[i].ComputeFetches << " per pixel into shared memory";
+            out << ")" << std::endl;
+        }
+        size_t fusedBytes = this->traffic(width, height), fusedFetches = this->fetches();
+        GLuint fusedPasses = (GLuint)this->stages.size();
+        this->Fuse = false;
+        this->build();
+        size_t unfusedBytes = this->traffic(width, height);
+        out << "  fused: " << fusedPasses << " passes, " << fusedFetches << " fetches per pixel, " << fusedBytes / 1024 << " KiB per frame; "
+            << "unfused: " << this->stages.size() << " passes, " << this->fetches() << " fetches per pixel, " << unfusedBytes / 1024
+            << " KiB per frame; saved " << (unfusedBytes - fusedBytes) / 1024 << " KiB ("
+            << (unfusedBytes > 0 ? 100.0 * (unfusedBytes - fusedBytes) / unfusedBytes : 0.0) << "%)" << std::endl;
+        this->Fuse = fuse;
+        this->dirty = true;
+    }
+
+    // Runs the chain on 'texture' fused and unfused, 'iterations' times each, and prints the time and traffic.
+    // With compute shaders it also times the fused chain with Compute on, and each kernel pass both ways.
+    void Benchmark(GLuint texture, GLsizei width, GLsizei height, GLuint iterations = 50, std::ostream& out = std::cout)
+    {
+        this->PrintStats(width, height, out);
+
+        // Ping-pong targets of the input's size, and a half-float one for the horizontal passes of separable kernels
+        GLuint targets[3], fbo;
+        glGenTextures(3, targets);
+        for (GLuint i = 0; i < 3; i++)
+        {
+            glBindTexture(GL_TEXTURE_2D, targets[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, i < 2 ? GL_RGBA8 : GL_RGBA16F, width, height, 0, GL_RGBA, i < 2 ? GL_UNSIGNED_BYTE : GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        glGenFramebuffers(1, &fbo);
+        GLint framebuffer = 0, viewport[4];
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glViewport(0, 0, width, height);
+
+        GLboolean fuse = this->Fuse, compute = this->Compute;
+        this->Compute = false;
+        this->Fuse = false;
+        this->build();
+        GLdouble unfused = this->measure(0, (GLuint)this->stages.size(), texture, targets, width, height, iterations);
+        this->Fuse = true;
+        this->build();
+        GLdouble fused = this->measure(0, (GLuint)this->stages.size(), texture, targets, width, height, iterations);
+        out << "  Time per frame: fused " << fused << " ms, unfused " << unfused << " ms";
+        if (this->computeSupported)
+        {
+            this->Compute = true;
+            out << ", fused with compute shaders " << this->measure(0, (GLuint)this->stages.size(), texture, targets, width, height, iterations) << " ms";
+        }
+        out << std::endl;
+
+        // Every kernel pass on its own, drawn and dispatched
+        for (GLuint i = 0; i < this->stages.size() && this->computeSupported; i++)
+        {
+            this->Compute = true;
+            if (!this->computable(this->stages[i]))
+                continue;
+            GLdouble dispatched = this->measure(i, i + 1, texture, targets, width, height, iterations);
+            this->Compute = false;
+            GLdouble drawn = this->measure(i, i + 1, texture, targets, width, height, iterations);
+            out << "  pass " << i << " (" << this->stages[i].Name << "): fragment " << drawn << " ms with " << this->stages[i].Fetches
+                << " fetches per pixel, compute " << dispatched << " ms with " << this->stages[i].ComputeFetches << " loads per pixel" << std::endl;
+        }
+        this->Fuse = fuse;
+        this->Compute = compute;
+        this->dirty = true;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteTextures(3, targets);
+    }
+
+private:
+    // How a pass treats the first operation of its range
+    enum StageKind {
+        POINT,          // Per-pixel effects, possibly around one 3x3 kernel
+        HORIZONTAL,     // First half of a separable kernel, nothing else
+        VERTICAL        // Second half of a separable kernel, then per-pixel effects
+    };
+
+    // One pass: operations [First, Last] of the chain
+    struct Stage
+    {
+        std::string Name;
+        StageKind Kind;
+        GLint First, Last;
+        GLint Kernel;           // Operation index of the pass's kernel, -1 without one
+        GLuint Fetches;
+        GLboolean Float;        // Writes a half-float target (for the vertical pass after it)
+        GLuint Program;
+        GLint ComputeProgram;   // Generated on first use: -1 not yet, 0 if the pass can't run as a compute shader
+        GLfloat ComputeFetches; // Texels the compute shader loads per pixel, tile and apron
+    };
+
+    std::vector<Stage> stages;
+    Stage copyStage;
+    std::vector<RenderGraph::Resource> targets;     // Written by the passes of the last AddPasses
+    std::map<std::string, GLuint> programs;
+    GLuint emptyVAO;
+    GLboolean dirty, builtFused, builtLinearTaps;
+    GLfloat builtSpacing;
+    GLboolean computeSupported;
+    GLint sharedMemory;
+
+    PostProcessChain& add(Effect type, const std::string& name, GLfloat parameter)
+    {
+        Operation operation;
+        operation.Type = type;
+        operation.Name = name;
+        std::fill(operation.Weights, operation.Weights + 9, 0.0f);
+        operation.Parameter = parameter;
+        this->Operations.push_back(operation);
+        this->dirty = true;
+        return *this;
+    }
+
+    // Splits the chain into passes and generates their programs. Fused, a pass holds at most one kernel; a separable
+    // kernel ends the pass before it (its bilinear taps can't apply effects per texel) and takes two passes itself.
+    void build()
+    {
+        if (!this->dirty && this->builtFused == this->Fuse && this->builtLinearTaps == this->linearTaps() &&
+            this->builtSpacing == this->KernelSpacing)
+            return;
+        this->stages.clear();
+        GLint count = (GLint)this->Operations.size(), first = 0;
+        bool kernel = false;
+        for (GLint i = 0; i < count; i++)
+        {
+            Effect type = this->Operations[i].Type;
+            if (type == SEPARABLE)
+            {
+                if (i > first)
+                    this->addStage(this->Operations[first].Type == SEPARABLE ? VERTICAL : POINT, first, i - 1);
+                this->addStage(HORIZONTAL, i, i);
+                first = i;
+                kernel = true;
+                continue;
+            }
+            if (i > first && (!this->Fuse || (kernel && type == KERNEL)))
+            {
+                this->addStage(this->Operations[first].Type == SEPARABLE ? VERTICAL : POINT, first, i - 1);
+                first = i;
+                kernel = false;
+            }
+            kernel = kernel || type == KERNEL;
+        }
+        // The rest, or a copy of the input for an empty chain
+        if (first < count || this->stages.empty())
+            this->addStage(first < count && this->Operations[first].Type == SEPARABLE ? VERTICAL : POINT, first, count - 1);
+        for (GLuint i = 0; i < this->stages.size(); i++)
+            this->stages[i].Float = i + 1 < this->stages.size() && this->stages[i + 1].Kind == VERTICAL;
+        this->dirty = false;
+        this->builtFused = this->Fuse;
+        this->builtLinearTaps = this->linearTaps();
+        this->builtSpacing = this->KernelSpacing;
+    }
+
+    void addStage(StageKind kind, GLint first, GLint last)
+    {
+        Stage stage;
+        stage.Kind = kind;
+        stage.First = first;
+        stage.Last = last;
+        stage.Fetches = 1;
+        stage.Kernel = -1;
+        stage.ComputeProgram = -1;
+        stage.ComputeFetches = 0.0f;
+        for (GLint i = first; i <= last; i++)
+        {
+            stage.Name += (i > first ? " + " : "") + this->Operations[i].Name;
+            if (this->Operations[i].Type == KERNEL || this->Operations[i].Type == SEPARABLE)
+                stage.Kernel = i;
+        }
+        GLint kernel = stage.Kernel;
+        if (kind == HORIZONTAL)
+            stage.Name += " horizontal";
+        else if (kind == VERTICAL)
+            stage.Name = this->Operations[first].Name + " vertical" + stage.Name.substr(this->Operations[first].Name.size());
+        if (stage.Name.empty())
+            stage.Name = "copy";
+
+        // The operations before a kernel run on every tap, the ones after it (or all of them) on the pixel
+        std::string source =
+            "#version 330 core\n"
+            "in vec2 TexCoords;\n"
+            "out vec4 color;\n"
+            "uniform sampler2D screenTexture;\n"
+            "uniform float spacing;\n";
+        if (kernel >= 0)
+        {
+            source += "vec3 tap(vec2 direction)\n{\n"
+                      "    vec2 offset = spacing / vec2(textureSize(screenTexture, 0));\n"
+                      "    vec3 c = texture(screenTexture, TexCoords + direction * offset).rgb;\n";
+            for (GLint i = first; i < kernel; i++)
+                source += code(this->Operations[i]);
+            source += "    return c;\n}\n";
+        }
+        source += "void main()\n{\n";
+        if (kernel >= 0)
+        {
+            std::vector<GLfloat> weights, xs, ys;
+            this->taps(stage, this->linearTaps(), weights, xs, ys);
+            source += "    vec3 c = vec3(0.0);\n";
+            stage.Fetches = 0;
+            for (GLuint i = 0; i < weights.size(); i++)
+            {
+                if (weights[i] == 0.0f)
+                    continue;
+                source += "    c += " + literal(weights[i]) + " * tap(vec2(" + literal(xs[i]) + ", " + literal(ys[i]) + "));\n";
+                stage.Fetches++;
+            }
+            // Between unfused passes the result is stored in an 8-bit target
+            if (kind != HORIZONTAL)
+                source += "    c = clamp(c, 0.0, 1.0);\n";
+        }
+        else
+            source += "    vec3 c = texture(screenTexture, TexCoords).rgb;\n";
+        for (GLint i = kernel >= 0 ? kernel + 1 : first; i <= last; i++)
+            source += code(this->Operations[i]);
+        source += "    color = vec4(c, 1.0);\n}\n";
+
+        std::map<std::string, GLuint>::iterator it = this->programs.find(source);
+        if (it == this->programs.end())
+            it = this->programs.insert(std::make_pair(source, createProgram(source))).first;
+        stage.Program = it->second;
+        stage.Float = false;
+        this->stages.push_back(stage);
+    }
+
+    // Bilinear fetches only blend neighbouring texels, so taps further apart can't be merged
+    bool linearTaps() const
+    {
+        return this->LinearTaps && this->KernelSpacing == 1.0f;
+    }
+
+    // Weights and positions (in taps) of the kernel of a pass; 3x3 kernels top left to bottom right
+    void taps(const Stage& stage, bool merge, std::vector<GLfloat>& weights, std::vector<GLfloat>& xs, std::vector<GLfloat>& ys) const
+    {
+        const Operation& kernel = this->Operations[stage.Kernel];
+        if (stage.Kind == POINT)
+        {
+            for (GLint y = 1; y >= -1; y--)
+                for (GLint x = -1; x <= 1; x++)
+                {
+                    weights.push_back(kernel.Weights[(1 - y) * 3 + x + 1]);
+                    xs.push_back((GLfloat)x);
+                    ys.push_back((GLfloat)y);
+                }
+            return;
+        }
+        std::vector<GLfloat> positions;
+        taps(stage.Kind == HORIZONTAL ? kernel.Horizontal : kernel.Vertical, merge, weights, positions);
+        for (GLuint i = 0; i < positions.size(); i++)
+        {
+            xs.push_back(stage.Kind == HORIZONTAL ? positions[i] : 0.0f);
+            ys.push_back(stage.Kind == HORIZONTAL ? 0.0f : positions[i]);
+        }
+    }
+
+    // Fetches of a 1D kernel: the centre tap, then each side outwards. With 'merge', two neighbouring
+    // non-negative weights a (at distance d) and b (at d + 1) become one fetch of weight a + b at d + b / (a + b),
+    // where the bilinear filter blends the two texels in exactly that ratio.
+    static void taps(const std::vector<GLfloat>& line, bool merge, std::vector<GLfloat>& weights, std::vector<GLfloat>& positions)
+    {
+        GLint radius = (GLint)line.size() / 2;
+        for (GLuint i = 0; i < line.size(); i++)
+            merge = merge && line[i] >= 0.0f;
+        weights.push_back(line[radius]);
+        positions.push_back(0.0f);
+        for (GLint side = -1; side <= 1; side += 2)
+            for (GLint d = 1; d <= radius; d += merge ? 2 : 1)
+            {
+                GLfloat a = line[radius + side * d];
+                GLfloat b = merge && d < radius ? line[radius + side * (d + 1)] : 0.0f;
+                if (a + b == 0.0f)
+                    continue;
+                weights.push_back(a + b);
+                positions.push_back(side * (merge ? d + b / (a + b) : (GLfloat)d));
+            }
+    }
+
+    // Float constant for the generated GLSL, precise enough for the small weights of wide kernels
+    static std::string literal(GLfloat value)
+    {
+        std::ostringstream out;
+        out << std::setprecision(9) << value;
+        std::string text = out.str();
+        return text.find_first_of(".e") == std::string::npos ? text + ".0" : text;
+    }
+
+    static std::string code(const Operation& operation)
+    {
+        switch (operation.Type)
+        {
+        case INVERT: return "    c = vec3(1.0) - c;\n";
+        case GRAYSCALE: return "    c = vec3(dot(c, vec3(0.2126, 0.7152, 0.0722)));\n";
+        case TONEMAP: return "    c = vec3(1.0) - exp(-c * " + std::to_string(operation.Parameter) + ");\n";
+        case GAMMA: return "    c = pow(c, vec3(1.0 / " + std::to_string(operation.Parameter) + "));\n";
+        default: return "";
+        }
+    }
+
+    // Draws one pass into the bound framebuffer
+    void draw(const Stage& stage, GLuint texture)
+    {
+        glDisable(GL_DEPTH_TEST);
+        glUseProgram(stage.Program);
+        glUniform1i(glGetUniformLocation(stage.Program, "screenTexture"), 0);
+        glUniform1f(glGetUniformLocation(stage.Program, "spacing"), this->KernelSpacing);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glBindVertexArray(this->emptyVAO);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+    }
+
+    GLuint fetches() const
+    {
+        GLuint total = 0;
+        for (GLuint i = 0; i < this->stages.size(); i++)
+            total += this->stages[i].Fetches;
+        return total;
+    }
+
+    // Every pass reads its input once (neighbouring taps hit the texture cache) and writes its target: RGBA8, or
+    // RGBA16F before a vertical pass
+    size_t traffic(GLsizei width, GLsizei height) const
+    {
+        size_t bytes = 0, input = 4;
+        for (GLuint i = 0; i < this->stages.size(); i++)
+        {
+            size_t output = this->stages[i].Float ? 8 : 4;
+            bytes += (input + output) * (size_t)width * height;
+            input = output;
+        }
+        return bytes;
+    }
+
+    GLenum format(const Stage& stage) const
+    {
+        return stage.Float ? GL_RGBA16F : GL_RGBA8;
+    }
+
+    // Work group size of a pass: square tiles for 3x3 kernels, tiles stretched along the kernel for the halves of
+    // separable ones (so their apron is only on two sides, and a smaller part of the tile)
+    static void groupSize(StageKind kind, GLint& width, GLint& height)
+    {
+        width = kind == POINT ? 16 : kind == HORIZONTAL ? 32 : 8;
+        height = kind == POINT ? 16 : kind == HORIZONTAL ? 8 : 32;
+    }
+
+    // Whether the pass runs as a compute shader: Compute is on and supported, and the pass has a kernel whose taps
+    // fall on whole texels (KernelSpacing is an integer) and whose tile fits into shared memory
+    bool computable(Stage& stage)
+    {
+        if (!this->Compute || !this->computeSupported || stage.Kernel < 0)
+            return false;
+        if (stage.ComputeProgram < 0)
+            stage.ComputeProgram = (GLint)this->createComputeStage(stage);
+        return stage.ComputeProgram > 0;
+    }
+
+    // Generates the compute version of a pass. A work group loads its tile of the input plus an apron of the
+    // kernel's reach into shared memory once, applying the effects before the kernel per texel; every pixel then
+    // reads its taps from there, and the result is written with an image store.
+    GLuint createComputeStage(Stage& stage)
+    {
+        GLint spacing = (GLint)this->KernelSpacing;
+        if ((GLfloat)spacing != this->KernelSpacing || spacing < 1)
+            return 0;
+        std::vector<GLfloat> weights, xs, ys;
+        this->taps(stage, false, weights, xs, ys);
+        GLint reachX = 0, reachY = 0, groupX, groupY;
+        for (GLuint i = 0; i < weights.size(); i++)
+        {
+            reachX = std::max(reachX, (GLint)std::abs(xs[i]) * spacing);
+            reachY = std::max(reachY, (GLint)std::abs(ys[i]) * spacing);
+        }
+        groupSize(stage.Kind, groupX, groupY);
+        GLint tileX = groupX + 2 * reachX, tileY = groupY + 2 * reachY;
+        if (tileX * tileY * 16 > this->sharedMemory)
+            return 0;
+        stage.ComputeFetches = (GLfloat)(tileX * tileY) / (groupX * groupY);
+
+        std::string source =
+            "#version 430 core\n"
+            "layout(local_size_x = " + std::to_string(groupX) + ", local_size_y = " + std::to_string(groupY) + ") in;\n"
+            "uniform sampler2D screenTexture;\n"
+            "layout(" + (stage.Float ? "rgba16f" : "rgba8") + ", binding = 0) writeonly uniform image2D result;\n"
+            "const ivec2 reach = ivec2(" + std::to_string(reachX) + ", " + std::to_string(reachY) + ");\n"
+            "const ivec2 tileSize = ivec2(" + std::to_string(tileX) + ", " + std::to_string(tileY) + ");\n"
+            "shared vec3 tile[" + std::to_string(tileX * tileY) + "];\n"
+            "vec3 load(ivec2 texel)\n{\n"
+            "    vec3 c = texelFetch(screenTexture, clamp(texel, ivec2(0), textureSize(screenTexture, 0) - 1), 0).rgb;\n";
+        for (GLint i = stage.First; i < stage.Kernel; i++)
+            source += code(this->Operations[i]);
+        source += "    return c;\n}\n"
+                  "void main()\n{\n"
+                  "    ivec2 origin = ivec2(gl_WorkGroupID.xy * gl_WorkGroupSize.xy) - reach;\n"
+                  "    for (int i = int(gl_LocalInvocationIndex); i < tileSize.x * tileSize.y; i += int(gl_WorkGroupSize.x * gl_WorkGroupSize.y))\n"
+                  "        tile[i] = load(origin + ivec2(i % tileSize.x, i / tileSize.x));\n"
+                  "    memoryBarrierShared();\n"
+                  "    barrier();\n"
+                  "    int center = (int(gl_LocalInvocationID.y) + reach.y) * tileSize.x + int(gl_LocalInvocationID.x) + reach.x;\n"
+                  "    vec3 c = vec3(0.0);\n";
+        for (GLuint i = 0; i < weights.size(); i++)
+            if (weights[i] != 0.0f)
+                source += "    c += " + literal(weights[i]) + " * tile[center + " +
+                          std::to_string((GLint)ys[i] * spacing * tileX + (GLint)xs[i] * spacing) + "];\n";
+        if (stage.Kind != HORIZONTAL)
+            source += "    c = clamp(c, 0.0, 1.0);\n";
+        for (GLint i = stage.Kernel + 1; i <= stage.Last; i++)
+            source += code(this->Operations[i]);
+        source += "    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);\n"
+                  "    if (all(lessThan(pixel, imageSize(result))))\n"
+                  "        imageStore(result, pixel, vec4(c, 1.0));\n"
+                  "}\n";
+
+        std::map<std::string, GLuint>::iterator it = this->programs.find(source);
+        if (it == this->programs.end())
+            it = this->programs.insert(std::make_pair(source, createComputeProgram(source))).first;
+        return it->second;
+    }
+
+    // Runs pass 'i' (or the copy pass after the last) on 'texture'. Dispatched into 'target' if the pass can run as
+    // a compute shader and 'target' is a texture of its format and the input's size, else drawn into the framebuffer.
+    void run(GLuint i, GLuint texture, GLuint target, GLenum format, GLsizei width, GLsizei height)
+    {
+        if (i == this->stages.size())
+        {
+            this->draw(this->copyStage, texture);
+            return;
+        }
+        Stage& stage = this->stages[i];
+        if (target == 0 || format != this->format(stage) || !this->computable(stage))
+        {
+            this->draw(stage, texture);
+            return;
+        }
+        GLint groupX, groupY;
+        groupSize(stage.Kind, groupX, groupY);
+        glUseProgram(stage.ComputeProgram);
+        glUniform1i(glGetUniformLocation(stage.ComputeProgram, "screenTexture"), 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glBindImageTexture(0, target, 0, GL_FALSE, 0, GL_WRITE_ONLY, format);
+        glDispatchCompute((width + groupX - 1) / groupX, (height + groupY - 1) / groupY, 1);
+        // Later passes sample the result, draw over it or read it back
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    }
+
+    GLuint target(GLuint i, const GLuint targets[3]) const
+    {
+        return this->stages[i].Float ? targets[2] : targets[i % 2];
+    }
+
+    // Time in milliseconds of passes [first, last) on 'texture', averaged over 'iterations' runs after an untimed
+    // one (so that compiling the shaders on first use isn't measured). Taken on the CPU between glFinish calls rather
+    // than with a timer query, which software renderers like llvmpipe don't fill in for draws.
+    GLdouble measure(GLuint first, GLuint last, GLuint texture, const GLuint targets[3], GLsizei width, GLsizei height, GLuint iterations)
+    {
+        std::chrono::high_resolution_clock::time_point start;
+        for (GLuint n = 0; n <= iterations; n++)
+        {
+            if (n == 1)
+            {
+                glFinish();
+                start = std::chrono::high_resolution_clock::now();
+            }
+            // A pass after the first reads the previous pass's target, which has the format it expects
+            GLuint source = first > 0 ? this->target(first - 1, targets) : texture;
+            for (GLuint i = first; i < last; i++)
+            {
+                GLuint target = this->target(i, targets);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+                this->run(i, source, target, this->format(this->stages[i]), width, height);
+                source = target;
+            }
+        }
+        glFinish();
+        return std::chrono::duration<GLdouble, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / iterations;
+    }
+
+    static GLuint createComputeProgram(const std::string& computeSource)
+    {
+        const GLchar* computeText = computeSource.c_str();
+        GLuint compute = glCreateShader(GL_COMPUTE_SHADER);
+        glShaderSource(compute, 1, &computeText, NULL);
+        glCompileShader(compute);
+        GLuint program = glCreateProgram();
+        glAttachShader(program, compute);
+        glLinkProgram(program);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[512];
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::POST_PROCESS_CHAIN::COMPUTE_PROGRAM::LINKING_FAILED\n" << infoLog << std::endl << computeSource << std::endl;
+            // The pass is drawn instead
+            glDeleteProgram(program);
+            program = 0;
+        }
+        glDeleteShader(compute);
+        return program;
+    }
+
+    static GLuint createProgram(const std::string& fragmentSource)
+    {
+        const GLchar* vertexSource =
+            "#version 330 core\n"
+            "out vec2 TexCoords;\n"
+            "void main()\n"
+            "{\n"
+            "    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+            "    TexCoords = position;\n"
+            "    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+            "}\n";
+        const GLchar* fragmentText = fragmentSource.c_str();
+        GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vertexSource, NULL);
+        glCompileShader(vertex);
+        GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fragmentText, NULL);
+        glCompileShader(fragment);
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glLinkProgram(program);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[512];
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::POST_PROCESS_CHAIN::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl << fragmentSource << std::endl;
+        }
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return program;
+    }
+};
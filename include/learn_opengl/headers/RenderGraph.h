@@ -0,0 +1,628 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+
+
+// Frame graph of render passes over virtual textures. Every frame the passes are added with a setup function, which
+// declares the textures the pass reads and writes, and an execute function, which draws. Execute then
+//  - orders the passes so every texture is written before it is read (declaration order breaks ties),
+//  - culls the passes whose results nothing needs: a pass is kept if it writes the backbuffer or an imported
+//    texture, is marked with SideEffect, or writes something a kept pass reads,
+//  - gives each transient texture a physical texture from a pool for just the passes between its first and last
+//    use, so transient textures of the same description whose lifetimes don't overlap share one texture,
+//  - binds a framebuffer with the pass's written textures attached (cached per attachment set) and runs the pass.
+// Pooled textures that go unused for FramesToKeep frames are deleted, so a resize or a dropped effect frees its
+// textures instead of leaking them. Imported textures belong to the caller and live across frames (e.g. a cached
+// shadow map); call ForgetTexture before deleting one that was used as an attachment.
+//
+//     RenderGraph::Resource color;
+//     graph.AddPass("scene", [&](RenderGraph::Builder& builder) {
+//         color = builder.Create("scene color", RenderGraph::TextureDesc(width, height, GL_RGBA8));
+//         builder.Create("scene depth", RenderGraph::TextureDesc(width, height, GL_DEPTH24_STENCIL8));
+//     }, [&]() { glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); DrawScene(); });
+//     graph.AddPass("post", [&](RenderGraph::Builder& builder) {
+//         builder.Read(color);
+//         builder.Write(backbuffer);
+//     }, [&]() { glBindTexture(GL_TEXTURE_2D, graph.Texture(color)); DrawQuad(); });
+//     graph.Execute();
+class RenderGraph
+{
+public:
+    // Handle of a virtual texture, valid for the frame it was created in
+    typedef GLint Resource;
+
+    // Everything a texture is created from; transient textures with equal descriptions can share storage
+    struct TextureDesc
+    {
+        GLsizei Width, Height;
+        GLenum InternalFormat;
+        GLenum Filter;          // Minification and magnification
+        GLenum Wrap;
+
+        TextureDesc(GLsizei width = 0, GLsizei height = 0, GLenum internalFormat = GL_RGBA8, GLenum filter = GL_LINEAR,
+                    GLenum wrap = GL_CLAMP_TO_EDGE)
+            : Width(width), Height(height), InternalFormat(internalFormat), Filter(filter), Wrap(wrap)
+        {
+        }
+
+        bool operator==(const TextureDesc& other) const
+        {
+            return this->Width == other.Width && this->Height == other.Height && this->InternalFormat == other.InternalFormat &&
+                   this->Filter == other.Filter && this->Wrap == other.Wrap;
+        }
+    };
+
+    // Passed to a pass's setup function to declare its reads and writes
+    class Builder
+    {
+    public:
+        // A new transient texture, written by this pass
+        Resource Create(const std::string& name, const TextureDesc& desc)
+        {
+            return this->Write(this->graph->createResource(name, desc, 0, false));
+        }
+
+        Resource Read(Resource resource)
+        {
+            this->graph->passes[this->pass].Reads.push_back(resource);
+            return resource;
+        }
+
+        // Attaches the texture to the pass's framebuffer: depth formats as the depth(-stencil) attachment, colour
+        // formats as the colour attachments in the order written
+        Resource Write(Resource resource)
+        {
+            this->graph->passes[this->pass].Writes.push_back(resource);
+            this->graph->resources[resource].Writers.push_back(this->pass);
+            return resource;
+        }
+
+        // Keeps the pass even if nothing reads what it writes
+        void SideEffect()
+        {
+            this->graph->passes[this->pass].SideEffect = true;
+        }
+
+    private:
+        friend class RenderGraph;
+        RenderGraph* graph;
+        GLuint pass;
+
+        Builder(RenderGraph* graph, GLuint pass) : graph(graph), pass(pass) { }
+    };
+
+    /*  Options  */
+    GLuint FramesToKeep;            // Frames an unused pooled texture survives before it's deleted
+
+    /*  Statistics of the last executed frame  */
+    GLuint Passes;
+    GLuint CulledPasses;
+    GLuint TransientTextures;       // Virtual
+    GLuint PhysicalTextures;        // Pooled textures they were given
+    size_t TransientBytes;          // What the transient textures would take without sharing
+    size_t PeakBytes;               // Most transient texture memory in use at once
+    size_t PooledBytes;             // Held by the pool, in use or not
+
+    /*  Statistics since construction  */
+    GLuint TexturesCreated;
+    GLuint TexturesDeleted;
+
+    /*  Functions  */
+    RenderGraph(GLuint framesToKeep = 2)
+        : FramesToKeep(framesToKeep), Passes(0), CulledPasses(0), TransientTextures(0), PhysicalTextures(0), TransientBytes(0),
+          PeakBytes(0), PooledBytes(0), TexturesCreated(0), TexturesDeleted(0), frame(0)
+    {
+    }
+
+    ~RenderGraph()
+    {
+        this->Release();
+    }
+
+    // Deletes the pooled textures and the framebuffers. Call it while the context is still current when the graph
+    // outlives it, e.g. before glfwTerminate() for a graph declared in main.
+    void Release()
+    {
+        for (GLuint i = 0; i < this->pool.size(); i++)
+            glDeleteTextures(1, &this->pool[i].Texture);
+        for (std::map<std::vector<GLuint>, GLuint>::iterator it = this->framebuffers.begin(); it != this->framebuffers.end(); ++it)
+            glDeleteFramebuffers(1, &it->second);
+        this->TexturesDeleted += this->pool.size();
+        this->pool.clear();
+        this->framebuffers.clear();
+        this->PooledBytes = 0;
+    }
+
+    // Makes a texture owned by the caller usable by this frame's passes. Passes writing it are never culled.
+    Resource ImportTexture(const std::string& name, GLuint texture, const TextureDesc& desc)
+    {
+        return this->createResource(name, desc, texture, true);
+    }
+
+    // The default framebuffer, as a colour texture passes can write
+    Resource ImportBackbuffer(GLsizei width, GLsizei height)
+    {
+        Resource resource = this->createResource("backbuffer", TextureDesc(width, height), 0, true);
+        this->resources[resource].Backbuffer = true;
+        return resource;
+    }
+
+    // Declares a pass: 'setup' runs right away and declares the reads and writes, 'execute' runs in Execute
+    void AddPass(const std::string& name, std::function<void(Builder&)> setup, std::function<void()> execute)
+    {
+        Pass pass;
+        pass.Name = name;
+        pass.Execute = execute;
+        this->passes.push_back(pass);
+        Builder builder(this, (GLuint)this->passes.size() - 1);
+        setup(builder);
+    }
+
+    // The physical texture of a resource; transient ones only have one while their passes execute
+    GLuint Texture(Resource resource) const
+    {
+        return this->resources[resource].Texture;
+    }
+
+    const TextureDesc& Desc(Resource resource) const
+    {
+        return this->resources[resource].Desc;
+    }
+
+    bool IsBackbuffer(Resource resource) const
+    {
+        return this->resources[resource].Backbuffer;
+    }
+
+    // Compiles and runs the passes added since the last call, then forgets them. Leaves the default framebuffer bound.
+    void Execute()
+    {
+        this->compile();
+
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        size_t bytesInUse = 0;
+        this->PeakBytes = 0;
+        for (GLuint step = 0; step < this->order.size(); step++)
+        {
+            Pass& pass = this->passes[this->order[step]];
+
+            // Textures start their life at their first pass and go back to the pool after their last
+            for (GLuint i = 0; i < this->resources.size(); i++)
+                if (!this->resources[i].Imported && this->resources[i].FirstUse == (GLint)step)
+                {
+                    this->resources[i].Texture = this->acquire(this->resources[i].Desc);
+                    bytesInUse += bytes(this->resources[i].Desc);
+                }
+            this->PeakBytes = std::max(this->PeakBytes, bytesInUse);
+
+            this->bindTargets(pass);
+            pass.Execute();
+
+            for (GLuint i = 0; i < this->resources.size(); i++)
+                if (!this->resources[i].Imported && this->resources[i].LastUse == (GLint)step)
+                {
+                    this->recycle(this->resources[i].Texture);
+                    bytesInUse -= bytes(this->resources[i].Desc);
+                }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+        this->PhysicalTextures = 0;
+        for (GLuint i = 0; i < this->pool.size(); i++)
+            if (this->pool[i].LastFrame == this->frame)
+                this->PhysicalTextures++;
+        this->trim();
+        this->compiled = this->describe();
+        this->passes.clear();
+        this->resources.clear();
+        this->frame++;
+    }
+
+    // Drops the cached framebuffers with 'texture' attached
+    void ForgetTexture(GLuint texture)
+    {
+        std::map<std::vector<GLuint>, GLuint>::iterator it = this->framebuffers.begin();
+        while (it != this->framebuffers.end())
+        {
+            if (std::find(it->first.begin(), it->first.end(), texture) != it->first.end())
+            {
+                glDeleteFramebuffers(1, &it->second);
+                it = this->framebuffers.erase(it);
+            }
+            else
+                ++it;
+        }
+    }
+
+    // Prints the last frame's pass order and memory use
+    void PrintStats(std::ostream& out = std::cout) const
+    {
+        out << "Render graph: " << this->Passes << " passes (" << this->CulledPasses << " culled), " << this->TransientTextures
+            << " transient textures in " << this->PhysicalTextures << " pooled ones, peak "
+            << this->PeakBytes / 1024 << " KiB of " << this->TransientBytes / 1024 << " KiB unshared, pool "
+            << this->PooledBytes / 1024 << " KiB (" << this->TexturesCreated << " textures created, " << this->TexturesDeleted
+            << " deleted)" << std::endl << this->compiled;
+    }
+
+private:
+    struct Pass
+    {
+        std::string Name;
+        std::function<void()> Execute;
+        std::vector<Resource> Reads, Writes;
+        bool SideEffect;
+        bool Culled;
+        std::vector<GLuint> Inputs;     // Passes whose results this one needs
+        std::vector<GLuint> After;      // Passes that must merely run first (they read what this one overwrites)
+
+        Pass() : SideEffect(false), Culled(false) { }
+    };
+
+    struct VirtualTexture
+    {
+        std::string Name;
+        TextureDesc Desc;
+        GLuint Texture;
+        bool Imported;
+        bool Backbuffer;
+        GLint FirstUse, LastUse;        // Steps of the compiled order, -1 if unused
+        std::vector<GLuint> Writers;    // In declaration order
+    };
+
+    struct PooledTexture
+    {
+        GLuint Texture;
+        TextureDesc Desc;
+        bool InUse;
+        GLuint LastFrame;
+    };
+
+    std::vector<Pass> passes;
+    std::vector<VirtualTexture> resources;
+    std::vector<GLuint> order;
+    std::vector<PooledTexture> pool;
+    std::map<std::vector<GLuint>, GLuint> framebuffers;     // Depth attachment then colour attachments -> FBO
+    std::string compiled;
+    GLuint frame;
+
+    Resource createResource(const std::string& name, const TextureDesc& desc, GLuint texture, bool imported)
+    {
+        VirtualTexture resource;
+        resource.Name = name;
+        resource.Desc = desc;
+        resource.Texture = texture;
+        resource.Imported = imported;
+        resource.Backbuffer = false;
+        resource.FirstUse = resource.LastUse = -1;
+        this->resources.push_back(resource);
+        return (Resource)this->resources.size() - 1;
+    }
+
+    void compile()
+    {
+        // Dependencies: a read needs the texture's writers declared before the reader (or all of them, if the
+        // reader came first), a write comes after the earlier writers and readers of the texture
+        for (GLuint p = 0; p < this->passes.size(); p++)
+        {
+            Pass& pass = this->passes[p];
+            for (GLuint i = 0; i < pass.Reads.size(); i++)
+            {
+                const std::vector<GLuint>& writers = this->resources[pass.Reads[i]].Writers;
+                bool earlier = !writers.empty() && writers[0] < p;
+                for (GLuint w = 0; w < writers.size(); w++)
+                    if (writers[w] != p && (!earlier || writers[w] < p))
+                        pass.Inputs.push_back(writers[w]);
+            }
+            for (GLuint i = 0; i < pass.Writes.size(); i++)
+            {
+                Resource resource = pass.Writes[i];
+                const std::vector<GLuint>& writers = this->resources[resource].Writers;
+                for (GLuint w = 0; w < writers.size() && writers[w] < p; w++)
+                    pass.Inputs.push_back(writers[w]);      // Later writes may only touch part of the texture
+                for (GLuint q = 0; q < p; q++)
+                    if (std::find(this->passes[q].Reads.begin(), this->passes[q].Reads.end(), resource) != this->passes[q].Reads.end())
+                        pass.After.push_back(q);
+            }
+        }
+
+        // Culling: keep what reaches the backbuffer, an imported texture or a side effect
+        std::vector<GLuint> stack;
+        std::vector<bool> needed(this->passes.size(), false);
+        for (GLuint p = 0; p < this->passes.size(); p++)
+        {
+            bool output = this->passes[p].SideEffect;
+            for (GLuint i = 0; i < this->passes[p].Writes.size(); i++)
+                output = output || this->resources[this->passes[p].Writes[i]].Imported;
+            if (output)
+            {
+                needed[p] = true;
+                stack.push_back(p);
+            }
+        }
+        while (!stack.empty())
+        {
+            GLuint p = stack.back();
+            stack.pop_back();
+            for (GLuint i = 0; i < this->passes[p].Inputs.size(); i++)
+            {
+                GLuint input = this->passes[p].Inputs[i];
+                if (!needed[input])
+                {
+                    needed[input] = true;
+                    stack.push_back(input);
+                }
+            }
+        }
+
+        // Order: repeatedly run the first declared pass whose dependencies have run
+        this->order.clear();
+        std::vector<bool> done(this->passes.size(), false);
+        this->CulledPasses = 0;
+        for (GLuint p = 0; p < this->passes.size(); p++)
+        {
+            this->passes[p].Culled = !needed[p];
+            done[p] = !needed[p];
+            if (!needed[p])
+                this->CulledPasses++;
+        }
+        while (this->order.size() + this->CulledPasses < this->passes.size())
+        {
+            GLint next = -1;
+            for (GLuint p = 0; p < this->passes.size() && next < 0; p++)
+            {
+                if (done[p])
+                    continue;
+                bool ready = true;
+                for (GLuint i = 0; i < this->passes[p].Inputs.size(); i++)
+                    ready = ready && done[this->passes[p].Inputs[i]];
+                for (GLuint i = 0; i < this->passes[p].After.size(); i++)
+                    ready = ready && done[this->passes[p].After[i]];
+                if (ready)
+                    next = p;
+            }
+            if (next < 0)
+            {
+                // Only possible with a cycle; run the rest as declared
+                std::cout << "ERROR::RENDER_GRAPH:: Passes depend on each other, running them in declaration order" << std::endl;
+                for (GLuint p = 0; p < this->passes.size(); p++)
+                    if (!done[p])
+                    {
+                        done[p] = true;
+                        this->order.push_back(p);
+                    }
+                break;
+            }
+            done[next] = true;
+            this->order.push_back(next);
+        }
+
+        // Lifetimes of the transient textures over the compiled order
+        this->TransientTextures = 0;
+        this->TransientBytes = 0;
+        for (GLuint step = 0; step < this->order.size(); step++)
+        {
+            const Pass& pass = this->passes[this->order[step]];
+            for (GLuint k = 0; k < 2; k++)
+            {
+                const std::vector<Resource>& used = k == 0 ? pass.Reads : pass.Writes;
+                for (GLuint i = 0; i < used.size(); i++)
+                {
+                    VirtualTexture& resource = this->resources[used[i]];
+                    if (resource.FirstUse < 0)
+                    {
+                        resource.FirstUse = step;
+                        if (!resource.Imported)
+                        {
+                            this->TransientTextures++;
+                            this->TransientBytes += bytes(resource.Desc);
+                        }
+                        if (k == 0 && !resource.Imported)
+                            std::cout << "ERROR::RENDER_GRAPH:: Pass " << pass.Name << " reads " << resource.Name
+                                      << " before anything writes it" << std::endl;
+                    }
+                    resource.LastUse = step;
+                }
+            }
+        }
+        this->Passes = (GLuint)this->passes.size();
+    }
+
+    void bindTargets(const Pass& pass)
+    {
+        if (pass.Writes.empty())
+            return;
+
+        GLuint depth = 0;
+        std::vector<GLuint> colors;
+        const TextureDesc* size = NULL;
+        for (GLuint i = 0; i < pass.Writes.size(); i++)
+        {
+            const VirtualTexture& resource = this->resources[pass.Writes[i]];
+            size = size ? size : &resource.Desc;
+            if (resource.Backbuffer)
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glViewport(0, 0, resource.Desc.Width, resource.Desc.Height);
+                return;
+            }
+            if (isDepth(resource.Desc.InternalFormat))
+                depth = resource.Texture;
+            else if (std::find(colors.begin(), colors.end(), resource.Texture) == colors.end())
+                colors.push_back(resource.Texture);
+        }
+
+        std::vector<GLuint> key(1, depth);
+        key.insert(key.end(), colors.begin(), colors.end());
+        std::map<std::vector<GLuint>, GLuint>::iterator it = this->framebuffers.find(key);
+        if (it != this->framebuffers.end())
+            glBindFramebuffer(GL_FRAMEBUFFER, it->second);
+        else
+        {
+            GLuint fbo;
+            glGenFramebuffers(1, &fbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+            std::vector<GLenum> drawBuffers;
+            for (GLuint i = 0; i < colors.size(); i++)
+            {
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, colors[i], 0);
+                drawBuffers.push_back(GL_COLOR_ATTACHMENT0 + i);
+            }
+            if (depth != 0)
+            {
+                GLenum format = 0;
+                for (GLuint i = 0; i < pass.Writes.size(); i++)
+                    if (this->resources[pass.Writes[i]].Texture == depth)
+                        format = this->resources[pass.Writes[i]].Desc.InternalFormat;
+                GLenum attachment = format == GL_DEPTH24_STENCIL8 || format == GL_DEPTH32F_STENCIL8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+                glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, depth, 0);
+            }
+            if (drawBuffers.empty())
+            {
+                glDrawBuffer(GL_NONE);
+                glReadBuffer(GL_NONE);
+            }
+            else
+                glDrawBuffers((GLsizei)drawBuffers.size(), &drawBuffers[0]);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::RENDER_GRAPH:: Framebuffer of pass " << pass.Name << " is not complete!" << std::endl;
+            this->framebuffers[key] = fbo;
+        }
+        glViewport(0, 0, size->Width, size->Height);
+    }
+
+    GLuint acquire(const TextureDesc& desc)
+    {
+        for (GLuint i = 0; i < this->pool.size(); i++)
+            if (!this->pool[i].InUse && this->pool[i].Desc == desc)
+            {
+                this->pool[i].InUse = true;
+                this->pool[i].LastFrame = this->frame;
+                return this->pool[i].Texture;
+            }
+
+        PooledTexture entry;
+        entry.Desc = desc;
+        entry.InUse = true;
+        entry.LastFrame = this->frame;
+        GLenum format, type;
+        formatOf(desc.InternalFormat, format, type);
+        glGenTextures(1, &entry.Texture);
+        glBindTexture(GL_TEXTURE_2D, entry.Texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, desc.InternalFormat, desc.Width, desc.Height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.Filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.Filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, desc.Wrap);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, desc.Wrap);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        this->pool.push_back(entry);
+        this->PooledBytes += bytes(desc);
+        this->TexturesCreated++;
+        return entry.Texture;
+    }
+
+    void recycle(GLuint texture)
+    {
+        for (GLuint i = 0; i < this->pool.size(); i++)
+            if (this->pool[i].Texture == texture)
+                this->pool[i].InUse = false;
+    }
+
+    // Deletes the pooled textures no frame has used for a while, and their framebuffers
+    void trim()
+    {
+        for (GLuint i = 0; i < this->pool.size(); )
+        {
+            if (this->frame - this->pool[i].LastFrame >= this->FramesToKeep)
+            {
+                this->ForgetTexture(this->pool[i].Texture);
+                glDeleteTextures(1, &this->pool[i].Texture);
+                this->PooledBytes -= bytes(this->pool[i].Desc);
+                this->TexturesDeleted++;
+                this->pool.erase(this->pool.begin() + i);
+            }
+            else
+                i++;
+        }
+    }
+
+    // Pass order, culled passes and texture lifetimes, for PrintStats
+    std::string describe() const
+    {
+        std::string text;
+        for (GLuint step = 0; step < this->order.size(); step++)
+        {
+            const Pass& pass = this->passes[this->order[step]];
+            text += "  " + std::to_string(step) + ". " + pass.Name + ":";
+            for (GLuint i = 0; i < pass.Reads.size(); i++)
+                text += " reads " + this->resources[pass.Reads[i]].Name + ",";
+            for (GLuint i = 0; i < pass.Writes.size(); i++)
+            {
+                const VirtualTexture& resource = this->resources[pass.Writes[i]];
+                text += " writes " + resource.Name;
+                if (!resource.Imported)
+                    text += " (texture " + std::to_string(resource.Texture) + ", steps " + std::to_string(resource.FirstUse) + "-" +
+                            std::to_string(resource.LastUse) + ")";
+                text += ",";
+            }
+            text.back() = '\n';
+        }
+        for (GLuint p = 0; p < this->passes.size(); p++)
+            if (this->passes[p].Culled)
+                text += "  culled: " + this->passes[p].Name + "\n";
+        return text;
+    }
+
+    static bool isDepth(GLenum internalFormat)
+    {
+        return internalFormat == GL_DEPTH_COMPONENT || internalFormat == GL_DEPTH_COMPONENT16 ||
+               internalFormat == GL_DEPTH_COMPONENT24 || internalFormat == GL_DEPTH_COMPONENT32F ||
+               internalFormat == GL_DEPTH24_STENCIL8 || internalFormat == GL_DEPTH32F_STENCIL8;
+    }
+
+    // Pixel transfer format and type glTexImage2D accepts for an internal format
+    static void formatOf(GLenum internalFormat, GLenum& format, GLenum& type)
+    {
+        type = GL_UNSIGNED_BYTE;
+        switch (internalFormat)
+        {
+        case GL_DEPTH24_STENCIL8: format = GL_DEPTH_STENCIL; type = GL_UNSIGNED_INT_24_8; return;
+        case GL_DEPTH32F_STENCIL8: format = GL_DEPTH_STENCIL; type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV; return;
+        case GL_DEPTH_COMPONENT: case GL_DEPTH_COMPONENT16: case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32F:
+            format = GL_DEPTH_COMPONENT; type = GL_FLOAT; return;
+        case GL_R8: case GL_R16F: case GL_R32F: format = GL_RED; break;
+        case GL_RG8: case GL_RG16F: case GL_RG32F: format = GL_RG; break;
+        case GL_RGB: case GL_RGB8: case GL_SRGB8: case GL_RGB16F: case GL_RGB32F: case GL_R11F_G11F_B10F: format = GL_RGB; break;
+        default: format = GL_RGBA; break;
+        }
+        if (internalFormat == GL_R16F || internalFormat == GL_RG16F || internalFormat == GL_RGB16F || internalFormat == GL_RGBA16F ||
+            internalFormat == GL_R32F || internalFormat == GL_RG32F || internalFormat == GL_RGB32F || internalFormat == GL_RGBA32F ||
+            internalFormat == GL_R11F_G11F_B10F)
+            type = GL_FLOAT;
+    }
+
+    // Approximate size of a texture (drivers pad RGB formats to four channels)
+    static size_t bytes(const TextureDesc& desc)
+    {
+        size_t texel;
+        switch (desc.InternalFormat)
+        {
+        case GL_R8: texel = 1; break;
+        case GL_RG8: case GL_R16F: case GL_DEPTH_COMPONENT16: texel = 2; break;
+        case GL_RG16F: case GL_R32F: case GL_R11F_G11F_B10F: texel = 4; break;
+        case GL_RGB16F: case GL_RGBA16F: case GL_RG32F: case GL_DEPTH32F_STENCIL8: texel = 8; break;
+        case GL_RGB32F: case GL_RGBA32F: texel = 16; break;
+        default: texel = 4; break;      // 8-bit RGB(A), 24- and 32-bit depth, depth-stencil
+        }
+        return texel * desc.Width * desc.Height;
+    }
+};
@@ -0,0 +1,460 @@
+#pragma once
+// Std. Includes
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cctype>
+#include <algorithm>
+#include <iostream>
+
+// GL Includes
+#include <GL/glew.h>
+
+#include "GLRecorder.h"
+
+
+// Render statistics of every frame: draw calls, triangles, instances, program/texture/vertex array binds, uniform and
+// buffer uploads, and the CPU and GPU time of the frame. The GL counts come from the GLRecorder, which sees every
+// call the renderer makes, so nothing has to be counted by hand; define LEARN_OPENGL_GL_RECORDER and include this
+// header before the other headers so the GL 1.1 calls (glDrawElements, glBindTexture, ...) are seen as well.
+// The CPU time runs from BeginFrame to EndFrame; the GPU time comes from a pair of GL_TIMESTAMP queries around the
+// same span, read back a few frames later. Timestamps don't interfere with the GL_TIME_ELAPSED queries of a
+// GpuProfiler.
+// With ShowOverlay set, EndFrame draws the numbers in the top-left corner with a built-in bitmap font, all text in
+// one draw call. The overlay's own calls are left out of the counters.
+class RenderStats
+{
+public:
+    static const GLuint FrameLatency = 4;   // Frames in flight before a pair of timestamp queries is reused
+    static const GLuint AverageFrames = 60; // Frames the overlay averages the frame times over
+
+    struct Frame
+    {
+        GLRecorder::FrameStats Calls;
+        GLdouble CpuMs;
+        GLdouble GpuMs;                     // Of the last frame the GPU has finished, a few frames behind
+    };
+
+    /*  Options  */
+    GLboolean ShowOverlay;
+    GLuint Scale;                           // Screen pixels per font pixel
+
+    /*  Functions  */
+    // Constructor, needs a current GL context; the size must match the default framebuffer
+    RenderStats(GLuint width, GLuint height)
+        : ShowOverlay(false), Scale(2), width(width), height(height), frame(0), timestampsSupported(false)
+    {
+        this->last.CpuMs = this->last.GpuMs = 0.0;
+        GLRecorder::Instance().Install();
+
+        GLint bits = 0;
+        glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+        this->timestampsSupported = bits > 0;
+        glGenQueries(2 * FrameLatency, this->queries);
+        for (GLuint i = 0; i < FrameLatency; i++)
+            this->pending[i] = false;
+
+        this->createFont();
+        this->program = createProgram();
+        glGenVertexArrays(1, &this->VAO);
+        glGenBuffers(1, &this->VBO);
+        glBindVertexArray(this->VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+        // Position in pixels, font texture coordinates, colour
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(4 * sizeof(GLfloat)));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    ~RenderStats() { this->Release(); }
+
+    // Deletes the queries, the font and the overlay's buffers; the overlay can't be drawn afterwards. Call it while
+    // the context is still current when the stats outlive it.
+    void Release()
+    {
+        if (this->queries[0] != 0)
+            glDeleteQueries(2 * FrameLatency, this->queries);
+        for (GLuint i = 0; i < 2 * FrameLatency; i++)
+            this->queries[i] = 0;
+        for (GLuint i = 0; i < FrameLatency; i++)
+            this->pending[i] = false;
+        this->timestampsSupported = false;
+        if (this->font != 0)
+            glDeleteTextures(1, &this->font);
+        if (this->VBO != 0)
+            glDeleteBuffers(1, &this->VBO);
+        if (this->VAO != 0)
+            glDeleteVertexArrays(1, &this->VAO);
+        if (this->program != 0)
+            glDeleteProgram(this->program);
+        this->font = this->VBO = this->VAO = this->program = 0;
+    }
+
+    // Call first thing in the frame
+    void BeginFrame()
+    {
+        this->collect();
+        GLuint slot = this->frame % FrameLatency;
+        if (this->timestampsSupported && !this->pending[slot])
+            glQueryCounter(this->queries[2 * slot], GL_TIMESTAMP);
+        this->frameStart = std::chrono::steady_clock::now();
+    }
+
+    // Call at the end of the frame, after the last draw and before swapping the buffers. Closes the frame's counters
+    // and draws the overlay when it's shown.
+    void EndFrame()
+    {
+        GLuint slot = this->frame % FrameLatency;
+        if (this->timestampsSupported && !this->pending[slot])
+        {
+            glQueryCounter(this->queries[2 * slot + 1], GL_TIMESTAMP);
+            this->pending[slot] = true;
+        }
+        GLRecorder& recorder = GLRecorder::Instance();
+        recorder.EndFrame();
+        this->last.Calls = recorder.LastFrame;
+        this->last.CpuMs = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - this->frameStart).count();
+        this->cpuMs.Add(this->last.CpuMs);
+        this->frame++;
+
+        if (this->ShowOverlay)
+        {
+            this->drawOverlay();
+            recorder.Current = GLRecorder::FrameStats();
+        }
+    }
+
+    // Numbers of the last finished frame
+    const Frame& LastFrame() const
+    {
+        return this->last;
+    }
+
+    GLdouble AverageCpuMs() const
+    {
+        return this->cpuMs.Value();
+    }
+
+    GLdouble AverageGpuMs() const
+    {
+        return this->gpuMs.Value();
+    }
+
+    // The last frame's numbers by name, for reports like the benchmark's
+    std::vector<std::pair<std::string, GLdouble> > Counters() const
+    {
+        const GLRecorder::FrameStats& s = this->last.Calls;
+        std::vector<std::pair<std::string, GLdouble> > counters;
+        counters.push_back(std::make_pair(std::string("draw_calls"), (GLdouble)s.DrawCalls));
+        counters.push_back(std::make_pair(std::string("triangles"), (GLdouble)s.Triangles));
+        counters.push_back(std::make_pair(std::string("instances"), (GLdouble)s.Instances));
+        counters.push_back(std::make_pair(std::string("program_binds"), (GLdouble)s.ProgramBinds));
+        counters.push_back(std::make_pair(std::string("texture_binds"), (GLdouble)s.TextureBinds));
+        counters.push_back(std::make_pair(std::string("vertex_array_binds"), (GLdouble)s.VertexArrayBinds));
+        counters.push_back(std::make_pair(std::string("redundant_binds"), (GLdouble)s.RedundantBinds));
+        counters.push_back(std::make_pair(std::string("uniform_uploads"), (GLdouble)s.UniformUploads));
+        counters.push_back(std::make_pair(std::string("uniform_bytes"), (GLdouble)s.UniformBytes));
+        counters.push_back(std::make_pair(std::string("buffer_bytes"), (GLdouble)s.BufferBytes));
+        counters.push_back(std::make_pair(std::string("texture_uploads"), (GLdouble)s.TextureUploads));
+        counters.push_back(std::make_pair(std::string("cpu_ms"), this->last.CpuMs));
+        counters.push_back(std::make_pair(std::string("gpu_ms"), this->last.GpuMs));
+        return counters;
+    }
+
+    // One of the numbers of Counters() by name, 0 if there's none by that name
+    GLdouble Counter(const std::string& name) const
+    {
+        std::vector<std::pair<std::string, GLdouble> > counters = this->Counters();
+        for (GLuint i = 0; i < counters.size(); i++)
+        {
+            if (counters[i].first == name)
+                return counters[i].second;
+        }
+        return 0.0;
+    }
+
+    // The overlay's text
+    std::string Text() const
+    {
+        const GLRecorder::FrameStats& s = this->last.Calls;
+        std::ostringstream text;
+        text << std::fixed << std::setprecision(2)
+             << "CPU " << this->AverageCpuMs() << " MS  GPU ";
+        if (this->timestampsSupported)
+            text << this->AverageGpuMs() << " MS";
+        else
+            text << "N/A";
+        text << "\n"
+             << "DRAWS " << s.DrawCalls << "  TRIS " << s.Triangles << "  INSTANCES " << s.Instances << "\n"
+             << "BINDS  PROGRAM " << s.ProgramBinds << "  TEXTURE " << s.TextureBinds << "  VAO " << s.VertexArrayBinds
+             << "  (" << s.RedundantBinds << " REDUNDANT)\n"
+             << "UNIFORMS " << s.UniformUploads << " (" << s.UniformBytes << " B)  BUFFERS " << s.BufferBytes
+             << " B  TEXTURES " << s.TextureUploads;
+        return text.str();
+    }
+
+private:
+    static const GLuint GlyphWidth = 3, GlyphHeight = 5;
+
+    GLuint width, height;
+    GLuint frame;
+    bool timestampsSupported;
+    GLuint queries[2 * FrameLatency];       // Start and end timestamp of each slot
+    bool pending[FrameLatency];
+    std::chrono::steady_clock::time_point frameStart;
+    Frame last;
+    // Running average over the last AverageFrames samples
+    struct Average
+    {
+        std::vector<GLdouble> Samples;
+        GLuint Next;
+        GLdouble Sum;
+        Average() : Next(0), Sum(0.0) { }
+
+        void Add(GLdouble sample)
+        {
+            if (this->Samples.size() < AverageFrames)
+                this->Samples.push_back(sample);
+            else
+            {
+                this->Sum -= this->Samples[this->Next];
+                this->Samples[this->Next] = sample;
+            }
+            this->Sum += sample;
+            this->Next = (this->Next + 1) % AverageFrames;
+        }
+
+        GLdouble Value() const
+        {
+            return this->Samples.empty() ? 0.0 : this->Sum / this->Samples.size();
+        }
+    };
+
+    Average cpuMs, gpuMs;
+    GLuint font, program, VAO, VBO;
+    std::string glyphs;                     // Characters in the font texture, in order
+    std::vector<GLfloat> vertices;
+
+    void collect()
+    {
+        for (GLuint i = 0; i < FrameLatency; i++)
+        {
+            if (!this->pending[i])
+                continue;
+            GLint available = 0;
+            glGetQueryObjectiv(this->queries[2 * i + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(this->queries[2 * i], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(this->queries[2 * i + 1], GL_QUERY_RESULT, &end);
+            this->last.GpuMs = (end - start) / 1000000.0;
+            this->gpuMs.Add(this->last.GpuMs);
+            this->pending[i] = false;
+        }
+    }
+
+    // 3x5 pixel font, rows from the top; lower case is drawn as upper case
+    void createFont()
+    {
+        static const struct { char Character; const char* Rows; } glyphTable[] = {
+            { ' ', "000000000000000" }, { '#', "111111111111111" },
+            { '0', "111101101101111" }, { '1', "010110010010111" }, { '2', "111001111100111" }, { '3', "111001111001111" },
+            { '4', "101101111001001" }, { '5', "111100111001111" }, { '6', "111100111101111" }, { '7', "111001001001001" },
+            { '8', "111101111101111" }, { '9', "111101111001111" },
+            { 'A', "010101111101101" }, { 'B', "110101110101110" }, { 'C', "011100100100011" }, { 'D', "110101101101110" },
+            { 'E', "111100110100111" }, { 'F', "111100110100100" }, { 'G', "011100101101011" }, { 'H', "101101111101101" },
+            { 'I', "111010010010111" }, { 'J', "001001001101010" }, { 'K', "101101110101101" }, { 'L', "100100100100111" },
+            { 'M', "101111111101101" }, { 'N', "110101101101101" }, { 'O', "010101101101010" }, { 'P', "110101110100100" },
+            { 'Q', "010101101110011" }, { 'R', "110101110101101" }, { 'S', "011100010001110" }, { 'T', "111010010010010" },
+            { 'U', "101101101101111" }, { 'V', "101101101101010" }, { 'W', "101101111111101" }, { 'X', "101101010101101" },
+            { 'Y', "101101010010010" }, { 'Z', "111001010100111" },
+            { '.', "000000000000010" }, { ',', "000000000010100" }, { ':', "000010000010000" }, { '/', "001001010100100" },
+            { '-', "000000111000000" }, { '+', "000010111010000" }, { '=', "000111000111000" }, { '%', "101001010100101" },
+            { '(', "001010010010001" }, { ')', "100010010010100" }, { '_', "000000000000111" }
+        };
+        const GLuint count = sizeof(glyphTable) / sizeof(glyphTable[0]);
+        std::vector<GLubyte> pixels(count * GlyphWidth * GlyphHeight);
+        for (GLuint g = 0; g < count; g++)
+        {
+            this->glyphs += glyphTable[g].Character;
+            for (GLuint y = 0; y < GlyphHeight; y++)
+                for (GLuint x = 0; x < GlyphWidth; x++)
+                    pixels[y * count * GlyphWidth + g * GlyphWidth + x] = glyphTable[g].Rows[y * GlyphWidth + x] == '1' ? 255 : 0;
+        }
+
+        GLint alignment = 4;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glGenTextures(1, &this->font);
+        glBindTexture(GL_TEXTURE_2D, this->font);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, count * GlyphWidth, GlyphHeight, 0, GL_RED, GL_UNSIGNED_BYTE, &pixels[0]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    }
+
+    // Two triangles of the given glyph, in pixels from the top-left corner
+    void addQuad(GLfloat x, GLfloat y, GLfloat w, GLfloat h, GLuint glyph, const GLfloat* color)
+    {
+        GLfloat u0 = (GLfloat)glyph / this->glyphs.size(), u1 = (GLfloat)(glyph + 1) / this->glyphs.size();
+        const GLfloat corners[6][4] = {
+            { x, y, u0, 0.0f }, { x, y + h, u0, 1.0f }, { x + w, y + h, u1, 1.0f },
+            { x, y, u0, 0.0f }, { x + w, y + h, u1, 1.0f }, { x + w, y, u1, 0.0f }
+        };
+        for (GLuint i = 0; i < 6; i++)
+        {
+            this->vertices.insert(this->vertices.end(), corners[i], corners[i] + 4);
+            this->vertices.insert(this->vertices.end(), color, color + 4);
+        }
+    }
+
+    void drawOverlay()
+    {
+        static const GLfloat textColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        static const GLfloat backgroundColor[] = { 0.0f, 0.0f, 0.0f, 0.6f };
+        GLfloat pixel = (GLfloat)this->Scale;
+        GLfloat advance = (GlyphWidth + 1) * pixel, lineHeight = (GlyphHeight + 2) * pixel, margin = 4.0f * pixel;
+
+        // Background first, then every character, all into one vertex buffer
+        std::string text = this->Text();
+        GLuint columns = 0, lines = 1, column = 0;
+        for (GLuint i = 0; i < text.size(); i++)
+        {
+            column = text[i] == '\n' ? 0 : column + 1;
+            lines += text[i] == '\n' ? 1 : 0;
+            columns = std::max(columns, column);
+        }
+        this->vertices.clear();
+        this->addQuad(margin - pixel * 2.0f, margin - pixel * 2.0f, columns * advance + pixel * 3.0f,
+                      lines * lineHeight + pixel * 2.0f, (GLuint)this->glyphs.find('#'), backgroundColor);
+        GLfloat x = margin, y = margin;
+        for (GLuint i = 0; i < text.size(); i++)
+        {
+            if (text[i] == '\n')
+            {
+                x = margin;
+                y += lineHeight;
+                continue;
+            }
+            size_t glyph = this->glyphs.find((char)std::toupper((unsigned char)text[i]));
+            if (glyph != std::string::npos && text[i] != ' ')
+                this->addQuad(x, y, GlyphWidth * pixel, GlyphHeight * pixel, (GLuint)glyph, textColor);
+            x += advance;
+        }
+
+        // Save the state the overlay touches
+        GLint program, vertexArray, arrayBuffer, activeTexture, texture, framebuffer, blendSrc, blendDst;
+        GLint viewport[4], polygonMode[2];
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+        glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &arrayBuffer);
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+        glActiveTexture(GL_TEXTURE0);
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrc);
+        glGetIntegerv(GL_BLEND_DST_RGB, &blendDst);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glGetIntegerv(GL_POLYGON_MODE, polygonMode);
+        GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST), blend = glIsEnabled(GL_BLEND);
+        GLboolean cullFace = glIsEnabled(GL_CULL_FACE), stencilTest = glIsEnabled(GL_STENCIL_TEST);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glViewport(0, 0, this->width, this->height);
+        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_STENCIL_TEST);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        glUseProgram(this->program);
+        glUniform2f(glGetUniformLocation(this->program, "screenSize"), (GLfloat)this->width, (GLfloat)this->height);
+        glUniform1i(glGetUniformLocation(this->program, "font"), 0);
+        glBindTexture(GL_TEXTURE_2D, this->font);
+        glBindVertexArray(this->VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+        glBufferData(GL_ARRAY_BUFFER, this->vertices.size() * sizeof(GLfloat), &this->vertices[0], GL_STREAM_DRAW);
+        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(this->vertices.size() / 8));
+
+        // Restore
+        glBindBuffer(GL_ARRAY_BUFFER, arrayBuffer);
+        glBindVertexArray(vertexArray);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glActiveTexture(activeTexture);
+        glUseProgram(program);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        glPolygonMode(GL_FRONT_AND_BACK, polygonMode[0]);
+        glBlendFunc(blendSrc, blendDst);
+        if (depthTest)
+            glEnable(GL_DEPTH_TEST);
+        if (cullFace)
+            glEnable(GL_CULL_FACE);
+        if (stencilTest)
+            glEnable(GL_STENCIL_TEST);
+        if (!blend)
+            glDisable(GL_BLEND);
+    }
+
+    static GLuint createProgram()
+    {
+        const GLchar* vertexSource =
+            "#version 330 core\n"
+            "layout (location = 0) in vec2 position;\n"
+            "layout (location = 1) in vec2 texCoords;\n"
+            "layout (location = 2) in vec4 color;\n"
+            "out vec2 TexCoords;\n"
+            "out vec4 Color;\n"
+            "uniform vec2 screenSize;\n"
+            "void main()\n"
+            "{\n"
+            "    // Pixels from the top-left corner to normalized device coordinates\n"
+            "    gl_Position = vec4(position / screenSize * vec2(2.0, -2.0) + vec2(-1.0, 1.0), 0.0, 1.0);\n"
+            "    TexCoords = texCoords;\n"
+            "    Color = color;\n"
+            "}\n";
+        const GLchar* fragmentSource =
+            "#version 330 core\n"
+            "in vec2 TexCoords;\n"
+            "in vec4 Color;\n"
+            "out vec4 color;\n"
+            "uniform sampler2D font;\n"
+            "void main()\n"
+            "{\n"
+            "    color = vec4(Color.rgb, Color.a * texture(font, TexCoords).r);\n"
+            "}\n";
+        GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vertexSource, NULL);
+        glCompileShader(vertex);
+        GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fragmentSource, NULL);
+        glCompileShader(fragment);
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glLinkProgram(program);
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            GLchar infoLog[512];
+            glGetProgramInfoLog(program, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        }
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return program;
+    }
+};
@@ -8,6 +8,8 @@
 
 #include <GL/glew.h>
 
+#include "CpuProfiler.h"
+
 class Shader
 {
 public:
@@ -15,6 +17,7 @@ public:
     // Constructor generates the shader on the fly
     Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
     {
+        CPU_PROFILE_ZONE("Shader compile");
         // 1. Retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -0,0 +1,136 @@
+#pragma once
+// Std. Includes
+#include <iostream>
+#include <algorithm>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+
+// Keeps a shadow map around between frames and tells the caller when (and where) it has to be redrawn.
+// The whole map is invalidated when the light matrix changes; a moving caster only invalidates the texels its
+// old and new bounds cover in light space, which the caller redraws under a scissor rectangle.
+class ShadowCache
+{
+public:
+    /*  Options  */
+    GLboolean Enabled;          // When false the map is redrawn every frame, as without a cache
+    GLboolean UseDirtyRegions;  // When false any caster change redraws the whole map
+
+    /*  Statistics  */
+    GLuint FullPasses;
+    GLuint PartialPasses;
+    GLuint SkippedPasses;
+
+    /*  Functions  */
+    // Constructor
+    ShadowCache(GLuint width, GLuint height)
+        : Enabled(true), UseDirtyRegions(true), FullPasses(0), PartialPasses(0), SkippedPasses(0),
+          width(width), height(height), valid(false), dirty(false), full(true)
+    {
+    }
+
+    // Call once per frame before the shadow pass. Returns true when the map has to be (partially) redrawn this frame.
+    bool Update(const glm::mat4& lightSpaceMatrix)
+    {
+        if (!this->valid || !this->Enabled || lightSpaceMatrix != this->lightSpaceMatrix)
+            this->InvalidateAll();
+        this->lightSpaceMatrix = lightSpaceMatrix;
+        if (!this->dirty)
+            this->SkippedPasses++;
+        return this->dirty;
+    }
+
+    void InvalidateAll()
+    {
+        this->dirty = true;
+        this->full = true;
+    }
+
+    // Marks the part of the map covered by a caster's local bounding box (placed by 'model') as stale.
+    // Call it with both the old and the new transform of a caster that moved.
+    void InvalidateBox(const glm::vec3& localMin, const glm::vec3& localMax, const glm::mat4& model)
+    {
+        if (!this->UseDirtyRegions || this->full)
+        {
+            this->InvalidateAll();
+            return;
+        }
+
+        glm::mat4 toLight = this->lightSpaceMatrix * model;
+        GLfloat minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+        for (GLuint i = 0; i < 8; i++)
+        {
+            glm::vec3 corner(i & 1 ? localMax.x : localMin.x, i & 2 ? localMax.y : localMin.y, i & 4 ? localMax.z : localMin.z);
+            glm::vec4 p = toLight * glm::vec4(corner, 1.0f);
+            p /= p.w;
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+        if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+            return;     // Entirely outside the shadow map
+        // NDC to texels, padded by a texel so filtering at the edge of the region sees fresh depth
+        GLint x0 = std::max((GLint)((minX * 0.5f + 0.5f) * this->width) - 1, 0);
+        GLint y0 = std::max((GLint)((minY * 0.5f + 0.5f) * this->height) - 1, 0);
+        GLint x1 = std::min((GLint)((maxX * 0.5f + 0.5f) * this->width) + 2, (GLint)this->width);
+        GLint y1 = std::min((GLint)((maxY * 0.5f + 0.5f) * this->height) + 2, (GLint)this->height);
+        if (x1 <= x0 || y1 <= y0)
+            return;
+
+        if (this->dirty)
+        {
+            this->regionX0 = std::min(this->regionX0, x0); this->regionY0 = std::min(this->regionY0, y0);
+            this->regionX1 = std::max(this->regionX1, x1); this->regionY1 = std::max(this->regionY1, y1);
+        }
+        else
+        {
+            this->regionX0 = x0; this->regionY0 = y0;
+            this->regionX1 = x1; this->regionY1 = y1;
+            this->dirty = true;
+        }
+    }
+
+    // Restricts the following clear and draws to the stale part of the map (the framebuffer must already be bound)
+    void BeginPass()
+    {
+        if (this->full)
+            return;
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(this->regionX0, this->regionY0, this->regionX1 - this->regionX0, this->regionY1 - this->regionY0);
+    }
+
+    // Marks the map as up to date again
+    void EndPass()
+    {
+        if (this->full)
+            this->FullPasses++;
+        else
+        {
+            glDisable(GL_SCISSOR_TEST);
+            this->PartialPasses++;
+        }
+        this->valid = true;
+        this->dirty = false;
+        this->full = false;
+    }
+
+    void PrintStats(std::ostream& out = std::cout) const
+    {
+        out << "Shadow passes: " << this->FullPasses << " full, " << this->PartialPasses << " partial, "
+            << this->SkippedPasses << " skipped" << std::endl;
+    }
+
+    void ResetStats()
+    {
+        this->FullPasses = this->PartialPasses = this->SkippedPasses = 0;
+    }
+
+private:
+    GLuint width, height;
+    glm::mat4 lightSpaceMatrix;
+    bool valid;     // The map holds a complete render
+    bool dirty;     // Something has to be redrawn this frame
+    bool full;      // ...and it is the whole map
+    GLint regionX0, regionY0, regionX1, regionY1;
+};
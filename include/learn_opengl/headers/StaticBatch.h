@@ -0,0 +1,217 @@
+#pragma once
+// Std. Includes
+#include <vector>
+#include <map>
+#include <cstring>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+
+// Merges non-moving geometry into one vertex/index buffer per material. Every piece is transformed into world
+// space when it is added, so a pass draws each material with a single glDrawElements and an identity model matrix.
+// Vertices use one of the interleaved layouts of the demos: position, normal, texture coordinates (8 floats) or,
+// without normals, position and texture coordinates (5 floats, texture coordinates on attribute 1).
+// Identical world-space vertices are welded, so a 36 vertex cube list ends up as 24 vertices and 36 indices.
+// Each batch also keeps its positions in a separate, tightly packed buffer for depth-only passes.
+class StaticBatch
+{
+public:
+    struct Batch
+    {
+        GLuint Material;
+        GLuint VAO, VBO, EBO;
+        GLuint DepthVAO, PositionVBO;   // Position-only stream sharing the index buffer
+        GLsizei IndexCount;
+    };
+
+    /*  Batch Data  */
+    std::vector<Batch> Batches;
+    bool HasNormals;
+
+    /*  Functions  */
+    // Constructor
+    StaticBatch(bool hasNormals = true) : HasNormals(hasNormals)
+    {
+    }
+
+    // Adds 'vertexCount' interleaved vertices placed by 'model'. Without indices they're treated as a triangle list.
+    void Add(GLuint material, const GLfloat* vertices, GLuint vertexCount, const glm::mat4& model, const GLuint* indices = NULL, GLuint indexCount = 0)
+    {
+        Staging& staging = this->staging[material];
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+        GLuint vertexFloats = this->stride();
+        std::vector<GLuint> remap(vertexCount);
+        for (GLuint i = 0; i < vertexCount; i++)
+        {
+            const GLfloat* v = vertices + i * vertexFloats;
+            glm::vec4 position = model * glm::vec4(v[0], v[1], v[2], 1.0f);
+            VertexKey key;
+            key.Data[0] = position.x; key.Data[1] = position.y; key.Data[2] = position.z;
+            if (this->HasNormals)
+            {
+                glm::vec3 normal = glm::normalize(normalMatrix * glm::vec3(v[3], v[4], v[5]));
+                key.Data[3] = normal.x; key.Data[4] = normal.y; key.Data[5] = normal.z;
+                key.Data[6] = v[6];     key.Data[7] = v[7];
+            }
+            else
+            {
+                key.Data[3] = v[3]; key.Data[4] = v[4];
+                key.Data[5] = key.Data[6] = key.Data[7] = 0.0f;
+            }
+
+            std::map<VertexKey, GLuint>::iterator it = staging.Welded.find(key);
+            if (it == staging.Welded.end())
+            {
+                it = staging.Welded.insert(std::make_pair(key, (GLuint)(staging.Vertices.size() / vertexFloats))).first;
+                staging.Vertices.insert(staging.Vertices.end(), key.Data, key.Data + vertexFloats);
+            }
+            remap[i] = it->second;
+        }
+        if (indices)
+        {
+            for (GLuint i = 0; i < indexCount; i++)
+                staging.Indices.push_back(remap[indices[i]]);
+        }
+        else
+        {
+            for (GLuint i = 0; i < vertexCount; i++)
+                staging.Indices.push_back(remap[i]);
+        }
+    }
+
+    // Uploads everything added since the last Build. Materials that were built before keep their buffer objects,
+    // so re-baking after something moved only re-specifies the buffer contents.
+    void Build()
+    {
+        for (GLuint i = 0; i < this->Batches.size(); i++)
+            this->Batches[i].IndexCount = 0;
+
+        for (std::map<GLuint, Staging>::iterator it = this->staging.begin(); it != this->staging.end(); ++it)
+        {
+            Batch* batch = this->find(it->first);
+            if (!batch)
+            {
+                Batch created;
+                created.Material = it->first;
+                glGenVertexArrays(1, &created.VAO);
+                glGenBuffers(1, &created.VBO);
+                glGenBuffers(1, &created.EBO);
+                glBindVertexArray(created.VAO);
+                glBindBuffer(GL_ARRAY_BUFFER, created.VBO);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, created.EBO);
+                GLsizei vertexSize = this->stride() * sizeof(GLfloat);
+                glEnableVertexAttribArray(0);
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, vertexSize, (GLvoid*)0);
+                if (this->HasNormals)
+                {
+                    glEnableVertexAttribArray(1);
+                    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, vertexSize, (GLvoid*)(3 * sizeof(GLfloat)));
+                    glEnableVertexAttribArray(2);
+                    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vertexSize, (GLvoid*)(6 * sizeof(GLfloat)));
+                }
+                else
+                {
+                    glEnableVertexAttribArray(1);
+                    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, vertexSize, (GLvoid*)(3 * sizeof(GLfloat)));
+                }
+
+                glGenVertexArrays(1, &created.DepthVAO);
+                glGenBuffers(1, &created.PositionVBO);
+                glBindVertexArray(created.DepthVAO);
+                glBindBuffer(GL_ARRAY_BUFFER, created.PositionVBO);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, created.EBO);
+                glEnableVertexAttribArray(0);
+                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+                glBindVertexArray(0);
+                this->Batches.push_back(created);
+                batch = &this->Batches.back();
+            }
+
+            Staging& staging = it->second;
+            glBindBuffer(GL_ARRAY_BUFFER, batch->VBO);
+            glBufferData(GL_ARRAY_BUFFER, staging.Vertices.size() * sizeof(GLfloat), &staging.Vertices[0], GL_STATIC_DRAW);
+            GLuint vertexFloats = this->stride();
+            std::vector<GLfloat> positions;
+            positions.reserve(staging.Vertices.size() / vertexFloats * 3);
+            for (GLuint i = 0; i < staging.Vertices.size(); i += vertexFloats)
+                positions.insert(positions.end(), &staging.Vertices[i], &staging.Vertices[i] + 3);
+            glBindBuffer(GL_ARRAY_BUFFER, batch->PositionVBO);
+            glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(GLfloat), &positions[0], GL_STATIC_DRAW);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            // The element buffer binding is VAO state, so bind the VAO before touching it
+            glBindVertexArray(batch->VAO);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, staging.Indices.size() * sizeof(GLuint), &staging.Indices[0], GL_STATIC_DRAW);
+            glBindVertexArray(0);
+            batch->IndexCount = (GLsizei)staging.Indices.size();
+        }
+        this->staging.clear();
+    }
+
+    // Draws the merged geometry of one material
+    void Draw(GLuint material)
+    {
+        Batch* batch = this->find(material);
+        if (batch)
+            this->draw(*batch);
+    }
+
+    // Draws every material, for passes that don't care about materials (e.g. depth only)
+    void DrawAll()
+    {
+        for (GLuint i = 0; i < this->Batches.size(); i++)
+            this->draw(this->Batches[i]);
+    }
+
+    // Draws every material from the position-only streams, for depth-only passes
+    void DrawAllDepth()
+    {
+        for (GLuint i = 0; i < this->Batches.size(); i++)
+            this->draw(this->Batches[i], true);
+    }
+
+private:
+    struct VertexKey
+    {
+        GLfloat Data[8];
+
+        bool operator<(const VertexKey& other) const
+        {
+            return std::memcmp(this->Data, other.Data, sizeof(this->Data)) < 0;
+        }
+    };
+
+    struct Staging
+    {
+        std::vector<GLfloat> Vertices;
+        std::vector<GLuint> Indices;
+        std::map<VertexKey, GLuint> Welded;
+    };
+
+    std::map<GLuint, Staging> staging;
+
+    GLuint stride() const
+    {
+        return this->HasNormals ? 8 : 5;
+    }
+
+    Batch* find(GLuint material)
+    {
+        for (GLuint i = 0; i < this->Batches.size(); i++)
+        {
+            if (this->Batches[i].Material == material)
+                return &this->Batches[i];
+        }
+        return NULL;
+    }
+
+    void draw(const Batch& batch, bool positionsOnly = false)
+    {
+        if (batch.IndexCount == 0)
+            return;
+        glBindVertexArray(positionsOnly ? batch.DepthVAO : batch.VAO);
+        glDrawElements(GL_TRIANGLES, batch.IndexCount, GL_UNSIGNED_INT, 0);
+        glBindVertexArray(0);
+    }
+};
@@ -0,0 +1,141 @@
+#pragma once
+// Std. Includes
+#include <vector>
+
+// GL Includes
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "CpuProfiler.h"
+
+
+// Stores a parent/child hierarchy of local TRS transforms in structure-of-arrays layout.
+// Nodes are kept in breadth-first order (a parent is always stored before its children) so
+// world matrices can be refreshed in a single linear pass. Only nodes whose local transform
+// changed, or whose parent's world matrix changed in the same pass, are recomputed.
+class TransformHierarchy
+{
+public:
+    /*  Hierarchy Data  */
+    std::vector<GLint> Parent;              // -1 for root nodes
+    std::vector<glm::vec3> LocalPosition;
+    std::vector<glm::quat> LocalRotation;
+    std::vector<glm::vec3> LocalScale;
+    std::vector<glm::mat4> World;
+
+    /*  Functions  */
+    // Constructor
+    TransformHierarchy() : firstDirty(0), pass(0)
+    {
+    }
+
+    // Adds a node below 'parent' (or as a root when parent is -1) and returns its index.
+    // The parent must already exist, which keeps the parent-before-child ordering intact.
+    GLuint AddNode(GLint parent, glm::vec3 position = glm::vec3(0.0f), glm::quat rotation = glm::quat(), glm::vec3 scale = glm::vec3(1.0f))
+    {
+        GLuint index = (GLuint)this->Parent.size();
+        this->Parent.push_back(parent < (GLint)index ? parent : -1);
+        this->LocalPosition.push_back(position);
+        this->LocalRotation.push_back(rotation);
+        this->LocalScale.push_back(scale);
+        this->World.push_back(glm::mat4());
+        this->dirty.push_back(1);
+        this->changedPass.push_back(0);
+        if (index < this->firstDirty)
+            this->firstDirty = index;
+        return index;
+    }
+
+    void SetLocalPosition(GLuint node, glm::vec3 position)
+    {
+        this->LocalPosition[node] = position;
+        this->markDirty(node);
+    }
+
+    void SetLocalRotation(GLuint node, glm::quat rotation)
+    {
+        this->LocalRotation[node] = rotation;
+        this->markDirty(node);
+    }
+
+    void SetLocalScale(GLuint node, glm::vec3 scale)
+    {
+        this->LocalScale[node] = scale;
+        this->markDirty(node);
+    }
+
+    void SetLocal(GLuint node, glm::vec3 position, glm::quat rotation, glm::vec3 scale)
+    {
+        this->LocalPosition[node] = position;
+        this->LocalRotation[node] = rotation;
+        this->LocalScale[node] = scale;
+        this->markDirty(node);
+    }
+
+    GLuint Size() const
+    {
+        return (GLuint)this->Parent.size();
+    }
+
+    const glm::mat4& GetWorldMatrix(GLuint node) const
+    {
+        return this->World[node];
+    }
+
+    // Recomputes the world matrices of all dirty subtrees and returns how many matrices were rebuilt.
+    // Nothing before the first dirty node is visited; when nothing moved the call returns immediately.
+    GLuint UpdateWorldMatrices()
+    {
+        CPU_PROFILE_ZONE("Update world matrices");
+        GLuint count = this->Size();
+        if (this->firstDirty >= count)
+            return 0;
+
+        // A new pass id lets children see that their parent changed without a separate clearing pass
+        this->pass++;
+        GLuint rebuilt = 0;
+        for (GLuint i = this->firstDirty; i < count; i++)
+        {
+            GLint parent = this->Parent[i];
+            bool parentChanged = parent >= 0 && this->changedPass[parent] == this->pass;
+            if (!this->dirty[i] && !parentChanged)
+                continue;
+
+            glm::mat4 local = composeLocal(this->LocalPosition[i], this->LocalRotation[i], this->LocalScale[i]);
+            this->World[i] = parent >= 0 ? this->World[parent] * local : local;
+            this->dirty[i] = 0;
+            this->changedPass[i] = this->pass;
+            rebuilt++;
+        }
+        this->firstDirty = count;
+        return rebuilt;
+    }
+
+private:
+    /*  Bookkeeping  */
+    std::vector<GLubyte> dirty;
+    std::vector<GLuint> changedPass;
+    GLuint firstDirty;
+    GLuint pass;
+
+    /*  Functions    */
+    void markDirty(GLuint node)
+    {
+        this->dirty[node] = 1;
+        if (node < this->firstDirty)
+            this->firstDirty = node;
+    }
+
+    // Builds translate * rotate * scale directly instead of chaining three 4x4 multiplications
+    static glm::mat4 composeLocal(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale)
+    {
+        glm::mat3 r = glm::mat3_cast(rotation);
+        glm::mat4 local;
+        local[0] = glm::vec4(r[0] * scale.x, 0.0f);
+        local[1] = glm::vec4(r[1] * scale.y, 0.0f);
+        local[2] = glm::vec4(r[2] * scale.z, 0.0f);
+        local[3] = glm::vec4(position, 1.0f);
+        return local;
+    }
+};
@@ -7,6 +7,14 @@
 // GLFW
 #include <GLFW/glfw3.h>
 
+// Other includes
+// The render statistics come first so the GL 1.1 calls made by the other headers are counted as well
+#define LEARN_OPENGL_GL_RECORDER
+#include <learn_opengl/headers/RenderStats.h>
+#include <learn_opengl/headers/OverdrawView.h>
+#include <learn_opengl/headers/CpuProfiler.h>
+#include <learn_opengl/headers/Benchmark.h>
+
 
 // Function prototypes
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
@@ -14,6 +22,12 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 // Window dimensions
 const GLuint WIDTH = 800, HEIGHT = 600;
 
+// Overdraw heatmap, toggled with F1
+bool toggleOverdrawView = false;
+
+// Render statistics overlay, toggled with F6
+bool toggleStatsOverlay = false;
+
 // Shaders
 const GLchar* vertexShaderSource = "#version 330 core\n"
 "layout (location = 0) in vec3 position;\n"
@@ -51,8 +65,11 @@ const GLchar* fragmentShaderSourceBlue = "#version 330 core\n"
 "}\n\0";
 
 // The MAIN function, from here we start the application and run the game loop
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark renders a scripted run in a hidden window and writes the frame timings as JSON
+    Benchmark benchmark(argc, argv, "01.getting_started/01-05.vertex_and_fragment_shaders");
+
     std::cout << "Starting GLFW context, OpenGL 3.3" << std::endl;
     // Init GLFW
     glfwInit();
@@ -62,6 +79,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    benchmark.WindowHints();
 
     // Create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow(
@@ -249,12 +267,31 @@ int main()
     // Uncommenting this call will result in wireframe polygons.
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
+    // Counts the fragments shaded per pixel while enabled
+    OverdrawView overdraw(WIDTH, HEIGHT);
+
+    // Draw calls, binds, uploads and frame times of every frame, shown with F6
+    RenderStats stats(WIDTH, HEIGHT);
+
     // Game loop
     while (!glfwWindowShouldClose(window))
     {
+        benchmark.BeginFrame();
+        stats.BeginFrame();
+
         // Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
         glfwPollEvents();
 
+        // Show the overdraw heatmap instead of the frame; its statistics are printed when it's switched off
+        if (toggleOverdrawView)
+        {
+            if (overdraw.Enabled)
+                overdraw.PrintStats();
+            overdraw.Enabled = !overdraw.Enabled;
+            toggleOverdrawView = false;
+        }
+        overdraw.Begin();
+
         // Render
         // Clear the colorbuffer
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -283,13 +320,26 @@ int main()
 
         glBindVertexArray(0);
 
+        overdraw.End();
+
+        if (toggleStatsOverlay)
+        {
+            stats.ShowOverlay = !stats.ShowOverlay;
+            toggleStatsOverlay = false;
+        }
+        stats.EndFrame();
+
+        CPU_PROFILE_FRAME();
+
         // Swap the screen buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame(window, stats.Counters());
     }
     // Properly de-allocate all resources once they've outlived their purpose
     glDeleteVertexArrays(4, VAO_array);
     glDeleteBuffers(4, VBO_array);
     glDeleteBuffers(4, EBO_array);
+    stats.Release();
     // Terminate GLFW, clearing any resources allocated by GLFW.
     glfwTerminate();
     return 0;
@@ -300,4 +350,15 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        toggleOverdrawView = true;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        toggleStatsOverlay = true;
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        // Print the last frame's CPU zones and write everything recorded so far as a Chrome trace
+        CpuProfiler::Instance().PrintFrameSummary();
+        if (CpuProfiler::Instance().WriteChromeTrace("cpu_trace.json"))
+            std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+    }
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <algorithm>
 
@@ -14,13 +18,25 @@
 #include <SOIL.h>
 
 // Other includes
+// The render statistics come first so the GL 1.1 calls made by the other headers are counted as well
+#define LEARN_OPENGL_GL_RECORDER
+#include <learn_opengl/headers/RenderStats.h>
 #include <learn_opengl/headers/Shader.h>
+#include <learn_opengl/headers/OverdrawView.h>
+#include <learn_opengl/headers/CpuProfiler.h>
+#include <learn_opengl/headers/Benchmark.h>
 
 
 std::string current_working_directory()
 {
+#ifdef _WIN32
     char working_directory[MAX_PATH + 1];
     GetCurrentDirectoryA(sizeof(working_directory), working_directory);
+#else
+    char working_directory[4096];
+    if (!getcwd(working_directory, sizeof(working_directory)))
+        working_directory[0] = '\0';
+#endif
     return working_directory;
 }
 
@@ -30,9 +46,18 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 // Window dimensions
 const GLuint WIDTH = 800, HEIGHT = 600;
 
+// Overdraw heatmap, toggled with F1
+bool toggleOverdrawView = false;
+
+// Render statistics overlay, toggled with F6
+bool toggleStatsOverlay = false;
+
 // The MAIN function, from here we start the application and run the game loop
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark renders a scripted run in a hidden window and writes the frame timings as JSON
+    Benchmark benchmark(argc, argv, "01.getting_started/06.textures");
+
     // Init GLFW
     glfwInit();
     // Set all the required options for GLFW
@@ -40,6 +65,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    benchmark.WindowHints();
 
     // Create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Big Bang", nullptr, nullptr);
@@ -150,12 +176,31 @@ int main()
     SOIL_free_image_data(image);
     glBindTexture(GL_TEXTURE_2D, 0);
 
+    // Counts the fragments shaded per pixel while enabled
+    OverdrawView overdraw(WIDTH, HEIGHT);
+
+    // Draw calls, binds, uploads and frame times of every frame, shown with F6
+    RenderStats stats(WIDTH, HEIGHT);
+
     // Game loop
     while (!glfwWindowShouldClose(window))
     {
+        benchmark.BeginFrame();
+        stats.BeginFrame();
+
         // Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
         glfwPollEvents();
 
+        // Show the overdraw heatmap instead of the frame; its statistics are printed when it's switched off
+        if (toggleOverdrawView)
+        {
+            if (overdraw.Enabled)
+                overdraw.PrintStats();
+            overdraw.Enabled = !overdraw.Enabled;
+            toggleOverdrawView = false;
+        }
+        overdraw.Begin();
+
         // Render
         // Clear the colorbuffer
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -177,14 +222,27 @@ int main()
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
 
+        overdraw.End();
+
+        if (toggleStatsOverlay)
+        {
+            stats.ShowOverlay = !stats.ShowOverlay;
+            toggleStatsOverlay = false;
+        }
+        stats.EndFrame();
+
+        CPU_PROFILE_FRAME();
+
         // Swap the screen buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame(window, stats.Counters());
     }
 
     // Properly de-allocate all resources once they've outlived their purpose
     glDeleteVertexArrays(1, VAO_array);
     glDeleteBuffers(1, VBO_array);
     glDeleteBuffers(1, EBO_array);
+    stats.Release();
     // Terminate GLFW, clearing any resources allocated by GLFW.
     glfwTerminate();
     return 0;
@@ -195,4 +253,15 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        toggleOverdrawView = true;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        toggleStatsOverlay = true;
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        // Print the last frame's CPU zones and write everything recorded so far as a Chrome trace
+        CpuProfiler::Instance().PrintFrameSummary();
+        if (CpuProfiler::Instance().WriteChromeTrace("cpu_trace.json"))
+            std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+    }
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <algorithm>
 
@@ -19,13 +23,27 @@
 #include <glm/gtc/type_ptr.hpp>
 
 // Other includes
+// The render statistics come first so the GL 1.1 calls made by the other headers are counted as well
+#define LEARN_OPENGL_GL_RECORDER
+#include <learn_opengl/headers/RenderStats.h>
 #include <learn_opengl/headers/Shader.h>
+#include <learn_opengl/headers/MatrixKernels.h>
+#include <learn_opengl/headers/OverdrawView.h>
+#include <learn_opengl/headers/CpuProfiler.h>
+#include <learn_opengl/headers/Benchmark.h>
+#include <learn_opengl/headers/InputJournal.h>
 
 
 std::string current_working_directory()
 {
+#ifdef _WIN32
     char working_directory[MAX_PATH + 1];
     GetCurrentDirectoryA(sizeof(working_directory), working_directory);
+#else
+    char working_directory[4096];
+    if (!getcwd(working_directory, sizeof(working_directory)))
+        working_directory[0] = '\0';
+#endif
     return working_directory;
 }
 
@@ -38,6 +56,12 @@ void do_movement();
 // Window dimensions
 const GLuint WIDTH = 800, HEIGHT = 600;
 
+// Overdraw heatmap, toggled with F1
+bool toggleOverdrawView = false;
+
+// Render statistics overlay, toggled with F6
+bool toggleStatsOverlay = false;
+
 // Camera
 glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
 glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -54,8 +78,13 @@ GLfloat deltaTime = 0.0f;	// Time between current frame and last frame
 GLfloat lastFrame = 0.0f;  	// Time of last frame
 
 // The MAIN function, from here we start the application and run the game loop
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark renders a scripted run in a hidden window and writes the frame timings as JSON
+    Benchmark benchmark(argc, argv, "01.getting_started/07-09.transformations_and_spaces");
+    // --record=file.bin journals the input, --replay=file.bin plays it back for an exactly repeatable run
+    InputJournal journal(argc, argv);
+
     // Init GLFW
     glfwInit();
     // Set all the required options for GLFW
@@ -63,6 +92,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    benchmark.WindowHints();
 
     // Create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Fading Clown Face", nullptr, nullptr);
@@ -72,6 +102,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    journal.Attach(window);
 
     // GLFW Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -213,19 +244,42 @@ int main()
     SOIL_free_image_data(image);
     glBindTexture(GL_TEXTURE_2D, 0);
 
+    // Per-cube transforms, composed into model matrices in one batch every frame
+    TransformBatch cubeTransforms;
+    glm::mat4 cubeModels[9];
+
+    // Counts the fragments shaded per pixel while enabled
+    OverdrawView overdraw(WIDTH, HEIGHT);
+
+    // Draw calls, binds, uploads and frame times of every frame, shown with F6
+    RenderStats stats(WIDTH, HEIGHT);
 
     // Game loop
     while (!glfwWindowShouldClose(window))
     {
+        benchmark.BeginFrame();
+        stats.BeginFrame();
+
         // Calculate deltatime of current frame
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        journal.BeginFrame(deltaTime);
 
         // Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
         glfwPollEvents();
         do_movement();
 
+        // Show the overdraw heatmap instead of the frame; its statistics are printed when it's switched off
+        if (toggleOverdrawView)
+        {
+            if (overdraw.Enabled)
+                overdraw.PrintStats();
+            overdraw.Enabled = !overdraw.Enabled;
+            toggleOverdrawView = false;
+        }
+        overdraw.Begin();
+
         // Render
         // Clear the colorbuffer
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -257,6 +311,15 @@ int main()
         glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
+        // Calculate the model matrix for each object in one batch
+        cubeTransforms.Clear();
+        for (GLuint i = 0; i < 9; i++)
+        {
+            GLfloat angle = (GLfloat)glfwGetTime() * 0.3f * i;
+            cubeTransforms.Add(cubePositions[i], glm::angleAxis(angle, glm::normalize(glm::vec3(1.0f, 0.3f, 0.5f))), glm::vec3(1.0f));
+        }
+        MatrixKernels::ComposeModelMatrices(cubeTransforms, cubeModels);
+
         glBindVertexArray(VAO);
         for (GLuint i = 0; i < 9; i++)
         {
@@ -284,23 +347,32 @@ int main()
             else
                 glUniform4f(manipulatorColorLoc, 0.0f, 0.0f, manipulationValue, 1.0f);
 
-            // Calculate the model matrix for each object and pass it to shader before drawing
-            glm::mat4 model;
-            model = glm::translate(model, cubePositions[i]);
-            GLfloat angle = (GLfloat)glfwGetTime() * 0.3f * i;
-            model = glm::rotate(model, angle, glm::vec3(1.0f, 0.3f, 0.5f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            // Pass the object's model matrix to the shader before drawing
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(cubeModels[i]));
 
             glDrawArrays(GL_TRIANGLES, 0, 36);
         }
         glBindVertexArray(0);
 
+        overdraw.End();
+
+        if (toggleStatsOverlay)
+        {
+            stats.ShowOverlay = !stats.ShowOverlay;
+            toggleStatsOverlay = false;
+        }
+        stats.EndFrame();
+
+        CPU_PROFILE_FRAME();
+
         // Swap the screen buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame(window, stats.Counters());
     }
     // Properly de-allocate all resources once they've outlived their purpose
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
+    stats.Release();
     // Terminate GLFW, clearing any resources allocated by GLFW.
     glfwTerminate();
     return 0;
@@ -311,6 +383,17 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 {
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        toggleOverdrawView = true;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        toggleStatsOverlay = true;
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        // Print the last frame's CPU zones and write everything recorded so far as a Chrome trace
+        CpuProfiler::Instance().PrintFrameSummary();
+        if (CpuProfiler::Instance().WriteChromeTrace("cpu_trace.json"))
+            std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+    }
     if (key >= 0 && key < 1024)
     {
         if (action == GLFW_PRESS)
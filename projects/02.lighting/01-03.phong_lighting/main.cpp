@@ -1,5 +1,9 @@
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <algorithm>
 #include <cmath>
@@ -20,14 +24,27 @@
 #include <glm/gtc/type_ptr.hpp>
 
 // Other includes
+// The render statistics come first so the GL 1.1 calls made by the other headers are counted as well
+#define LEARN_OPENGL_GL_RECORDER
+#include <learn_opengl/headers/RenderStats.h>
 #include <learn_opengl/headers/Shader.h>
 #include <learn_opengl/headers/Camera.h>
+#include <learn_opengl/headers/OverdrawView.h>
+#include <learn_opengl/headers/CpuProfiler.h>
+#include <learn_opengl/headers/Benchmark.h>
+#include <learn_opengl/headers/InputJournal.h>
 
 
 std::string current_working_directory()
 {
+#ifdef _WIN32
     char working_directory[MAX_PATH + 1];
     GetCurrentDirectoryA(sizeof(working_directory), working_directory);
+#else
+    char working_directory[4096];
+    if (!getcwd(working_directory, sizeof(working_directory)))
+        working_directory[0] = '\0';
+#endif
     return working_directory;
 }
 
@@ -40,6 +57,12 @@ void do_movement();
 // Window dimensions
 const GLuint WIDTH = 800, HEIGHT = 600;
 
+// Overdraw heatmap, toggled with F1
+bool toggleOverdrawView = false;
+
+// Render statistics overlay, toggled with F6
+bool toggleStatsOverlay = false;
+
 // Camera
 Camera  camera(glm::vec3(0.0f, 0.0f, 6.0f));
 GLfloat lastX = WIDTH / 2.0;
@@ -55,8 +78,14 @@ GLfloat deltaTime = 0.0f;	// Time between current frame and last frame
 GLfloat lastFrame = 0.0f;  	// Time of last frame
 
 // The MAIN function, from here we start the application and run the game loop
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark renders a scripted run in a hidden window and writes the frame timings as JSON
+    Benchmark benchmark(argc, argv, "02.lighting/01-03.phong_lighting");
+    // --record=file.bin journals the input, --replay=file.bin plays it back for an exactly repeatable run
+    InputJournal journal(argc, argv);
+    benchmark.ScriptedCamera = !journal.Replaying();
+
     // Init GLFW
     glfwInit();
     // Set all the required options for GLFW
@@ -64,6 +93,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    benchmark.WindowHints();
 
     // Create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Phong Lighting", nullptr, nullptr);
@@ -73,6 +103,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    journal.Attach(window);
 
     // GLFW Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -185,18 +216,38 @@ int main()
     glBindVertexArray(0);
 
 
+    // Counts the fragments shaded per pixel while enabled
+    OverdrawView overdraw(WIDTH, HEIGHT);
+
+    // Draw calls, binds, uploads and frame times of every frame, shown with F6
+    RenderStats stats(WIDTH, HEIGHT);
+
     // Game loop
     while (!glfwWindowShouldClose(window))
     {
+        benchmark.BeginFrame(camera);
+        stats.BeginFrame();
+
         // Calculate deltatime of current frame
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        journal.BeginFrame(deltaTime);
 
         // Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
         glfwPollEvents();
         do_movement();
 
+        // Show the overdraw heatmap instead of the frame; its statistics are printed when it's switched off
+        if (toggleOverdrawView)
+        {
+            if (overdraw.Enabled)
+                overdraw.PrintStats();
+            overdraw.Enabled = !overdraw.Enabled;
+            toggleOverdrawView = false;
+        }
+        overdraw.Begin();
+
         // Clear the colorbuffer
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -315,10 +366,24 @@ int main()
         glDrawArrays(GL_TRIANGLES, 0, 36);
         glBindVertexArray(0);
 
+        overdraw.End();
+
+        if (toggleStatsOverlay)
+        {
+            stats.ShowOverlay = !stats.ShowOverlay;
+            toggleStatsOverlay = false;
+        }
+        stats.EndFrame();
+
+        CPU_PROFILE_FRAME();
+
         // Swap the screen buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame(window, stats.Counters());
     }
 
+    // Delete the GL objects of the stats overlay while the context still exists
+    stats.Release();
     // Terminate GLFW, clearing any resources allocated by GLFW.
     glfwTerminate();
     return 0;
@@ -348,6 +413,17 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     //cout << key << endl;
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        toggleOverdrawView = true;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        toggleStatsOverlay = true;
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        // Print the last frame's CPU zones and write everything recorded so far as a Chrome trace
+        CpuProfiler::Instance().PrintFrameSummary();
+        if (CpuProfiler::Instance().WriteChromeTrace("cpu_trace.json"))
+            std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+    }
     if (key >= 0 && key < 1024)
     {
         if (action == GLFW_PRESS)
@@ -0,0 +1,10 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+
+// Light volume (sphere, cone or the full-screen triangle) to clip space
+uniform mat4 volume;
+
+void main()
+{
+    gl_Position = volume * vec4(position, 1.0f);
+}
@@ -0,0 +1,30 @@
+#version 330 core
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+
+layout (location = 0) out vec4 gAlbedoSpec;
+layout (location = 1) out vec2 gNormal;
+layout (location = 2) out float gDepth;
+
+uniform mat4 view;
+uniform sampler2D material_diffuse;
+uniform sampler2D material_specular;
+
+// Octahedral normal encoding: project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half over
+vec2 EncodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.xy;
+}
+
+void main()
+{
+    // Only what the light passes need: the lighting itself happens per light volume
+    vec3 specular = texture(material_specular, TexCoords).rgb;
+    gAlbedoSpec = vec4(texture(material_diffuse, TexCoords).rgb, dot(specular, vec3(1.0 / 3.0)));
+    gNormal = EncodeNormal(normalize(Normal));
+    gDepth = -(view * vec4(FragPos, 1.0)).z;
+}
@@ -7,18 +7,6 @@ struct DirLight {
     vec3 specular;
 };  
 
-struct PointLight {
-    vec3 position;
-
-    float constant;
-    float linear;
-    float quadratic;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
 struct SpotLight {
     vec3 position;
     vec3 direction;
@@ -34,7 +22,8 @@ struct SpotLight {
     vec3 specular;       
 };
 
-#define NR_POINT_LIGHTS 4  
+// Most point lights one draw can take, see LightManager
+#define MAX_LIGHTS_PER_DRAW 16
 
 in vec3 FragPos;  
 in vec3 Normal;  
@@ -47,11 +36,15 @@ uniform sampler2D material_diffuse;
 uniform sampler2D material_specular;
 uniform float material_shininess;
 uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
+// All point lights (4 texels each: position + radius, ambient + constant, diffuse + linear, specular + quadratic)
+// and the ones that reach the object being drawn
+uniform samplerBuffer lightData;
+uniform int pointLightCount;
+uniform int pointLightIndices[MAX_LIGHTS_PER_DRAW];
 uniform SpotLight spotLight;
 
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir);
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
 
 void main()
@@ -69,8 +62,8 @@ void main()
     // Phase 1: Directional lighting
     vec3 result = CalcDirLight(dirLight, norm, viewDir);
     // Phase 2: Point lights
-    for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);    
+    for(int i = 0; i < pointLightCount; i++)
+        result += CalcPointLight(pointLightIndices[i], norm, FragPos, viewDir);
     // Phase 3: Spot light
     result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
     
@@ -95,10 +88,14 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     return (ambient + diffuse + specular);
 }
 
-// Calculates the color when using a point light.
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+// Calculates the color when using a point light, read from the light buffer.
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
-    vec3 lightDir = normalize(light.position - fragPos);
+    vec4 positionRadius = texelFetch(lightData, 4 * index);
+    vec4 ambientConstant = texelFetch(lightData, 4 * index + 1);
+    vec4 diffuseLinear = texelFetch(lightData, 4 * index + 2);
+    vec4 specularQuadratic = texelFetch(lightData, 4 * index + 3);
+    vec3 lightDir = normalize(positionRadius.xyz - fragPos);
 
     // Diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
@@ -108,13 +105,13 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material_shininess);
 
     // Attenuation
-    float distance    = length(light.position - fragPos);
-    float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+    float distance    = length(positionRadius.xyz - fragPos);
+    float attenuation = 1.0f / (ambientConstant.w + diffuseLinear.w * distance + specularQuadratic.w * (distance * distance));
 
     // Combine results
-    vec3 ambient  = light.ambient  * vec3(texture(material_diffuse, TexCoords));
-    vec3 diffuse  = light.diffuse  * diff * vec3(texture(material_diffuse, TexCoords));
-    vec3 specular = light.specular * spec * vec3(texture(material_specular, TexCoords));
+    vec3 ambient  = ambientConstant.rgb   * vec3(texture(material_diffuse, TexCoords));
+    vec3 diffuse  = diffuseLinear.rgb     * diff * vec3(texture(material_diffuse, TexCoords));
+    vec3 specular = specularQuadratic.rgb * spec * vec3(texture(material_specular, TexCoords));
     ambient  *= attenuation;
     diffuse  *= attenuation;
     specular *= attenuation;
@@ -0,0 +1,156 @@
+#version 330 core
+struct DirLight {
+    vec3 direction;
+  
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};  
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+  
+    float constant;
+    float linear;
+    float quadratic;
+  
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;       
+};
+
+in vec3 FragPos;  
+in vec3 Normal;  
+in vec2 TexCoords;
+
+out vec4 color;
+
+uniform vec3 viewPos;
+uniform sampler2D material_diffuse;
+uniform sampler2D material_specular;
+uniform float material_shininess;
+uniform DirLight dirLight;
+uniform SpotLight spotLight;
+uniform mat4 view;
+
+// Clustered point lights, filled in by ClusteredLighting
+uniform samplerBuffer lightData;     // 4 texels per light: position + radius, ambient + constant, diffuse + linear, specular + quadratic
+uniform usamplerBuffer clusterGrid;  // Per cluster: offset into lightIndices, light count
+uniform usamplerBuffer lightIndices;
+uniform ivec3 clusterCount;          // Tiles across, tiles down, depth slices
+uniform vec2 tileSize;               // In pixels
+uniform vec2 sliceScaleBias;         // slice = log(view depth) * x + y
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+
+void main()
+{
+    // Properties
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    
+    // == ======================================
+    // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
+    // For each phase, a calculate function is defined that calculates the corresponding color
+    // per lamp. In the main() function we take all the calculated colors and sum them up for
+    // this fragment's final color.
+    // == ======================================
+    // Phase 1: Directional lighting
+    vec3 result = CalcDirLight(dirLight, norm, viewDir);
+    // Phase 2: Point lights, only those of the cluster this fragment lies in
+    float depth = -(view * vec4(FragPos, 1.0)).z;
+    int slice = clamp(int(log(depth) * sliceScaleBias.x + sliceScaleBias.y), 0, clusterCount.z - 1);
+    ivec2 tile = min(ivec2(gl_FragCoord.xy / tileSize), clusterCount.xy - 1);
+    uvec2 cluster = texelFetch(clusterGrid, (slice * clusterCount.y + tile.y) * clusterCount.x + tile.x).xy;
+    for(uint i = 0u; i < cluster.y; i++)
+        result += CalcPointLight(int(texelFetch(lightIndices, int(cluster.x + i)).x), norm, FragPos, viewDir);
+    // Phase 3: Spot light
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);    
+    
+    color = vec4(result, 1.0);
+}
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
+{
+    vec3 lightDir = normalize(-light.direction);
+
+    // Diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // Specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material_shininess);
+
+    // Combine results
+    vec3 ambient  = light.ambient  * vec3(texture(material_diffuse, TexCoords));
+    vec3 diffuse  = light.diffuse  * diff * vec3(texture(material_diffuse, TexCoords));
+    vec3 specular = light.specular * spec * vec3(texture(material_specular, TexCoords));
+    return (ambient + diffuse + specular);
+}
+
+// Calculates the color when using a point light, read from the light buffer.
+vec3 CalcPointLight(int index, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec4 positionRadius = texelFetch(lightData, 4 * index);
+    vec4 ambientConstant = texelFetch(lightData, 4 * index + 1);
+    vec4 diffuseLinear = texelFetch(lightData, 4 * index + 2);
+    vec4 specularQuadratic = texelFetch(lightData, 4 * index + 3);
+    vec3 lightDir = normalize(positionRadius.xyz - fragPos);
+
+    // Diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // Specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material_shininess);
+
+    // Attenuation
+    float distance    = length(positionRadius.xyz - fragPos);
+    float attenuation = 1.0f / (ambientConstant.w + diffuseLinear.w * distance + specularQuadratic.w * (distance * distance));
+
+    // Combine results
+    vec3 ambient  = ambientConstant.rgb   * vec3(texture(material_diffuse, TexCoords));
+    vec3 diffuse  = diffuseLinear.rgb     * diff * vec3(texture(material_diffuse, TexCoords));
+    vec3 specular = specularQuadratic.rgb * spec * vec3(texture(material_specular, TexCoords));
+    ambient  *= attenuation;
+    diffuse  *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+}
+
+// Calculates the color when using a spot light.
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+
+    // Diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+
+    // Specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material_shininess);
+
+    // Attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    // Spotlight intensity
+    float theta = dot(lightDir, normalize(-light.direction)); 
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+
+    // Combine results
+    vec3 ambient = light.ambient * vec3(texture(material_diffuse, TexCoords));
+    vec3 diffuse = light.diffuse * diff * vec3(texture(material_diffuse, TexCoords));
+    vec3 specular = light.specular * spec * vec3(texture(material_specular, TexCoords));
+
+    ambient *= attenuation * intensity;
+    diffuse *= attenuation * intensity;
+    specular *= attenuation * intensity;
+    return (ambient + diffuse + specular);
+}
\ No newline at end of file
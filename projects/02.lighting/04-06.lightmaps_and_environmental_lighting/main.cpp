@@ -1,8 +1,13 @@
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 
 // GLEW
 #define GLEW_STATIC
@@ -20,27 +25,59 @@
 #include <glm/gtc/type_ptr.hpp>
 
 // Other includes
+// The render statistics come first so the GL 1.1 calls made by the other headers are counted as well
+#define LEARN_OPENGL_GL_RECORDER
+#include <learn_opengl/headers/RenderStats.h>
 #include <learn_opengl/headers/Shader.h>
 #include <learn_opengl/headers/Camera.h>
+#include <learn_opengl/headers/StaticBatch.h>
+#include <learn_opengl/headers/DepthPrePass.h>
+#include <learn_opengl/headers/OverdrawView.h>
+#include <learn_opengl/headers/CpuProfiler.h>
+#include <learn_opengl/headers/Benchmark.h>
+#include <learn_opengl/headers/InputJournal.h>
+#include <learn_opengl/headers/ClusteredLighting.h>
+#include <learn_opengl/headers/DeferredShading.h>
+#include <learn_opengl/headers/LightManager.h>
 
 
 std::string current_working_directory()
 {
+#ifdef _WIN32
     char working_directory[MAX_PATH + 1];
     GetCurrentDirectoryA(sizeof(working_directory), working_directory);
+#else
+    char working_directory[4096];
+    if (!getcwd(working_directory, sizeof(working_directory)))
+        working_directory[0] = '\0';
+#endif
     return working_directory;
 }
 
+// The camera's flashlight: a point light limited to a cone, with the cosines of the cone's inner and outer angle
+struct SpotLight
+{
+    PointLight Light;
+    GLfloat CutOff;
+    GLfloat OuterCutOff;
+};
+
 // Function prototypes
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mode);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void do_movement();
-void configure_environment_lighting(Shader lightingShader);
+void configure_environment_lighting(Shader lightingShader, std::vector<PointLight>& lamps, SpotLight& flashlight);
 
 // Window dimensions
 const GLuint WIDTH = 800, HEIGHT = 600;
 
+// Overdraw heatmap, toggled with F1
+bool toggleOverdrawView = false;
+
+// Render statistics overlay, toggled with F6
+bool toggleStatsOverlay = false;
+
 // Camera
 Camera  camera(glm::vec3(0.0f, 0.0f, 3.0f));
 GLfloat lastX = WIDTH / 2.0;
@@ -62,9 +99,38 @@ glm::vec3 pointLightPositions[] = {
     glm::vec3(0.0f, 0.0f, -3.0f)
 };
 
+// Draw the fixed containers and lamps from pre-transformed batches instead of one draw per cube
+bool useStaticBatching = true;
+bool toggleStaticBatching = false;      // Set by B: report the draw calls and switch
+
+// Lay down the containers' depth first so the lighting shader (six lights) runs once per covered pixel
+bool toggleDepthPrePass = false;
+
+// Shade with hundreds of small point lights, each fragment only looping over the lights of its cluster (key C);
+// = and - double and halve the number of lights
+bool useClusteredLighting = false;
+bool toggleClusteredLighting = false;
+GLuint swarmLightCount = 512;
+
+// Draw the containers into a G-buffer and shade the same lights as light volumes instead (key G); V switches the
+// volumes between stencil marking and a plain depth test
+bool useDeferredShading = false;
+bool toggleDeferredShading = false;
+bool toggleStencilVolumes = false;
+
+// Add the small lights to the forward path too (key L), where each draw only gets the lights reaching its bounds
+bool useLightSwarm = false;
+bool toggleLightSwarm = false;
+
 // The MAIN function, from here we start the application and run the game loop
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark renders a scripted run in a hidden window and writes the frame timings as JSON
+    Benchmark benchmark(argc, argv, "02.lighting/04-06.lightmaps_and_environmental_lighting");
+    // --record=file.bin journals the input, --replay=file.bin plays it back for an exactly repeatable run
+    InputJournal journal(argc, argv);
+    benchmark.ScriptedCamera = !journal.Replaying();
+
     // Init GLFW
     glfwInit();
     // Set all the required options for GLFW
@@ -72,6 +138,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    benchmark.WindowHints();
 
     // Create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Lighting", nullptr, nullptr);
@@ -81,6 +148,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    journal.Attach(window);
 
     // GLFW Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -110,6 +178,15 @@ int main()
     // Build and compile our shader program
     Shader lightingShader(lighting_vs_path.c_str(), lighting_frag_path.c_str());
     Shader lampShader(lamp_vs_path.c_str(), lamp_frag_path.c_str());
+    std::string depth_frag_path = cwd + "/Shaders/depth.frag";
+    Shader depthShader(lamp_vs_path.c_str(), depth_frag_path.c_str());
+    std::string lighting_clustered_frag_path = cwd + "/Shaders/lighting_clustered.frag";
+    Shader clusteredShader(lighting_vs_path.c_str(), lighting_clustered_frag_path.c_str());
+    std::string gbuffer_frag_path = cwd + "/Shaders/gbuffer.frag";
+    std::string deferred_light_vs_path = cwd + "/Shaders/deferred_light.vs";
+    std::string deferred_light_frag_path = cwd + "/Shaders/deferred_light.frag";
+    Shader gBufferShader(lighting_vs_path.c_str(), gbuffer_frag_path.c_str());
+    Shader deferredLightShader(deferred_light_vs_path.c_str(), deferred_light_frag_path.c_str());
 
     GLfloat vertices[] = {
         // Positions          // Normals           // Texture Coords
@@ -235,41 +312,229 @@ int main()
     lightingShader.Use();
     glUniform1i(glGetUniformLocation(lightingShader.Program, "material_diffuse"), 0);
     glUniform1i(glGetUniformLocation(lightingShader.Program, "material_specular"), 1);
+    clusteredShader.Use();
+    glUniform1i(glGetUniformLocation(clusteredShader.Program, "material_diffuse"), 0);
+    glUniform1i(glGetUniformLocation(clusteredShader.Program, "material_specular"), 1);
+    gBufferShader.Use();
+    glUniform1i(glGetUniformLocation(gBufferShader.Program, "material_diffuse"), 0);
+    glUniform1i(glGetUniformLocation(gBufferShader.Program, "material_specular"), 1);
+
+    // None of the containers or lamps move, so bake them into world space once
+    StaticBatch containerBatch, lampBatch;
+    for (GLuint i = 0; i < 10; i++)
+    {
+        glm::mat4 model;
+        model = glm::translate(model, cubePositions[i]);
+        GLfloat angle = 20.0f * i;
+        model = glm::rotate(model, angle, glm::vec3(1.0f, 0.3f, 0.5f));
+        containerBatch.Add(diffuseMap, vertices, 36, model);
+    }
+    containerBatch.Build();
+    for (GLuint i = 0; i < 4; i++)
+    {
+        glm::mat4 model;
+        model = glm::translate(model, pointLightPositions[i]);
+        model = glm::scale(model, glm::vec3(0.2f));
+        lampBatch.Add(0, vertices, 36, model);
+    }
+    lampBatch.Build();
+
+    DepthPrePass prePass(WIDTH, HEIGHT);
+
+    // Counts the fragments shaded per pixel while enabled
+    OverdrawView overdraw(WIDTH, HEIGHT);
+
+    // Draw calls, binds, uploads and frame times of every frame, shown with F6
+    RenderStats stats(WIDTH, HEIGHT);
+
+    // The four lamps plus a swarm of small coloured lights circling the containers, for the clustered (assigned on
+    // the worker threads) and deferred paths; the swarm is seeded so every run (and benchmark) sees the same lights
+    JobSystem jobs;
+    ClusteredLighting clustered(&jobs);
+    std::vector<PointLight> lamps, lights;
+    SpotLight flashlight;
+    std::vector<glm::vec4> swarm;   // Orbit centre and phase
+    std::vector<glm::vec3> swarmColors;
+    srand(42);
+    for (GLuint i = 0; i < 4096; i++)
+    {
+        GLfloat x = -6.0f + 12.0f * rand() / RAND_MAX, y = -4.0f + 10.0f * rand() / RAND_MAX;
+        GLfloat z = -16.0f + 18.0f * rand() / RAND_MAX, phase = 6.2832f * rand() / RAND_MAX;
+        swarm.push_back(glm::vec4(x, y, z, phase));
+        swarmColors.push_back(glm::vec3(0.2f + 0.4f * rand() / RAND_MAX, 0.2f + 0.4f * rand() / RAND_MAX, 0.2f + 0.4f * rand() / RAND_MAX));
+    }
+    DeferredShading deferred(WIDTH, HEIGHT);
 
+    // Picks the lights that reach each container for the forward shader
+    LightManager lightManager;
+
+    // Bounds of every container (a rotated unit cube stays within its bounding sphere) and of the whole batch
+    std::vector<glm::vec3> containerMin, containerMax;
+    glm::vec3 batchMin(1e30f), batchMax(-1e30f);
+    for (GLuint i = 0; i < 10; i++)
+    {
+        containerMin.push_back(cubePositions[i] - glm::vec3(0.8661f));
+        containerMax.push_back(cubePositions[i] + glm::vec3(0.8661f));
+        batchMin = glm::min(batchMin, containerMin[i]);
+        batchMax = glm::max(batchMax, containerMax[i]);
+    }
 
     // Game loop
     while (!glfwWindowShouldClose(window))
     {
+        benchmark.BeginFrame(camera);
+        stats.BeginFrame();
+
         // Calculate deltatime of current frame
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        journal.BeginFrame(deltaTime);
 
         // Check if any events have been activiated (key pressed, mouse moved etc.) and call corresponding response functions
         glfwPollEvents();
         do_movement();
 
 
-        // Use cooresponding shader when setting uniforms/drawing objects
-        lightingShader.Use();
-        GLint viewPosLoc = glGetUniformLocation(lightingShader.Program, "viewPos");
-        glUniform3f(viewPosLoc, camera.Position.x, camera.Position.y, camera.Position.z);
-        // Set material properties
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "material_shininess"), 32.0f);
-
-        configure_environment_lighting(lightingShader);
+        // Show the overdraw heatmap instead of the frame; its statistics are printed when it's switched off
+        if (toggleOverdrawView)
+        {
+            if (overdraw.Enabled)
+                overdraw.PrintStats();
+            overdraw.Enabled = !overdraw.Enabled;
+            toggleOverdrawView = false;
+        }
+        overdraw.Begin();
 
         // Create camera transformations
         glm::mat4 view;
         view = camera.GetViewMatrix();
         glm::mat4 projection = glm::perspective(camera.Zoom, (GLfloat)WIDTH / (GLfloat)HEIGHT, 0.1f, 100.0f);
+
+        // Draw 10 containers with the same VAO and VBO information; only their world space coordinates differ.
+        // The forward shader gets the point lights of each draw's bounds, so the batch gets those of the whole scene.
+        bool perDrawLights = !useClusteredLighting && !useDeferredShading;
+        auto drawContainers = [&](GLint modelLoc, bool depthOnly)
+        {
+            glm::mat4 model;
+            if (useStaticBatching)
+            {
+                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+                if (perDrawLights && !depthOnly)
+                    lightManager.SetDrawLights(lightingShader.Program, batchMin, batchMax);
+                if (depthOnly)
+                    containerBatch.DrawAllDepth();
+                else
+                    containerBatch.Draw(diffuseMap);
+            }
+            else
+            {
+                glBindVertexArray(containerVAO);
+                for (GLuint i = 0; i < 10; i++)
+                {
+                    model = glm::mat4();
+                    model = glm::translate(model, cubePositions[i]);
+                    GLfloat angle = 20.0f * i;
+                    model = glm::rotate(model, angle, glm::vec3(1.0f, 0.3f, 0.5f));
+                    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+                    if (perDrawLights && !depthOnly)
+                        lightManager.SetDrawLights(lightingShader.Program, containerMin[i], containerMax[i]);
+
+                    glDrawArrays(GL_TRIANGLES, 0, 36);
+                }
+                glBindVertexArray(0);
+            }
+        };
+
+        if (toggleClusteredLighting)
+        {
+            // Report the last assignment when switching back
+            if (useClusteredLighting)
+                clustered.PrintStats();
+            useClusteredLighting = !useClusteredLighting;
+            useDeferredShading = false;
+            toggleClusteredLighting = false;
+        }
+        if (toggleDeferredShading)
+        {
+            if (useDeferredShading)
+                deferred.PrintStats();
+            useDeferredShading = !useDeferredShading;
+            useClusteredLighting = false;
+            toggleDeferredShading = false;
+        }
+        if (toggleStencilVolumes)
+        {
+            deferred.UseStencilVolumes = !deferred.UseStencilVolumes;
+            deferred.PrintStats();
+            toggleStencilVolumes = false;
+        }
+        if (toggleLightSwarm)
+        {
+            // Report the lights per draw so far, then switch
+            lightManager.PrintStats();
+            lightManager.ResetStats();
+            useLightSwarm = !useLightSwarm;
+            toggleLightSwarm = false;
+        }
+
+        // Use cooresponding shader when setting uniforms/drawing objects
+        Shader& litShader = useDeferredShading ? deferredLightShader : useClusteredLighting ? clusteredShader : lightingShader;
+        litShader.Use();
+        GLint viewPosLoc = glGetUniformLocation(litShader.Program, "viewPos");
+        glUniform3f(viewPosLoc, camera.Position.x, camera.Position.y, camera.Position.z);
+        // Set material properties
+        glUniform1f(glGetUniformLocation(litShader.Program, "material_shininess"), 32.0f);
+
+        configure_environment_lighting(litShader, lamps, flashlight);
+
+        // The lamps of the current mode, plus the swarm
+        lights = lamps;
+        if (useClusteredLighting || useDeferredShading || useLightSwarm)
+        {
+            for (GLuint i = 0; i < swarmLightCount; i++)
+            {
+                GLfloat angle = swarm[i].w + 0.5f * currentFrame;
+                glm::vec3 position = glm::vec3(swarm[i]) + glm::vec3(std::cos(angle), 0.3f * std::sin(2.0f * angle), std::sin(angle));
+                lights.push_back(PointLight(position, swarmColors[i], 1.0f, 0.7f, 16.0f));
+            }
+        }
+        if (useClusteredLighting)
+        {
+            clustered.Lights = lights;
+            clustered.Update(view, projection, 0.1f, 100.0f);
+        }
+        else if (!useDeferredShading)
+        {
+            lightManager.Lights = lights;
+            lightManager.Update();
+        }
+
+        // Optional depth pre-pass with a shader that does nothing per fragment (after the clear above)
+        if (!useDeferredShading && prePass.BeginDepthPass())
+        {
+            depthShader.Use();
+            glUniformMatrix4fv(glGetUniformLocation(depthShader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(depthShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            drawContainers(glGetUniformLocation(depthShader.Program, "model"), true);
+            prePass.EndDepthPass();
+        }
+
+        // The G-buffer pass stands in for the lit pass below when shading deferred
+        Shader& sceneShader = useDeferredShading ? gBufferShader : litShader;
+        sceneShader.Use();
         // Get the uniform locations
-        GLint modelLoc = glGetUniformLocation(lightingShader.Program, "model");
-        GLint viewLoc = glGetUniformLocation(lightingShader.Program, "view");
-        GLint projLoc = glGetUniformLocation(lightingShader.Program, "projection");
+        GLint modelLoc = glGetUniformLocation(sceneShader.Program, "model");
+        GLint viewLoc = glGetUniformLocation(sceneShader.Program, "view");
+        GLint projLoc = glGetUniformLocation(sceneShader.Program, "projection");
         // Pass the matrices to the shader
         glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+        // The light buffer (or the cluster lists, units 2 to 4) comes after the material maps
+        if (useClusteredLighting)
+            clustered.Bind(clusteredShader.Program, 2, WIDTH, HEIGHT);
+        else if (perDrawLights)
+            lightManager.Bind(lightingShader.Program, 2);
 
         // Bind diffuse map
         glActiveTexture(GL_TEXTURE0);
@@ -278,20 +543,32 @@ int main()
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, specularMap);
 
-        // Draw 10 containers with the same VAO and VBO information; only their world space coordinates differ
-        glm::mat4 model;
-        glBindVertexArray(containerVAO);
-        for (GLuint i = 0; i < 10; i++)
+        if (useDeferredShading)
         {
-            model = glm::mat4();
-            model = glm::translate(model, cubePositions[i]);
-            GLfloat angle = 20.0f * i;
-            model = glm::rotate(model, angle, glm::vec3(1.0f, 0.3f, 0.5f));
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            deferred.BeginGeometryPass();
+            drawContainers(modelLoc, false);
+            deferred.EndGeometryPass();
+
+            deferred.BeginLighting(deferredLightShader.Program, view, projection);
+            deferred.DrawDirectionalLight();
+            deferred.DrawPointLights(lights);
+            deferred.DrawSpotLight(flashlight.Light, camera.Front, flashlight.OuterCutOff);
+            deferred.EndLighting();
+        }
+        else
+        {
+            prePass.BeginColourPass();
+            drawContainers(modelLoc, false);
+            prePass.EndColourPass();
+        }
 
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+        if (toggleDepthPrePass)
+        {
+            // Report the overdraw measured so far, then switch
+            prePass.PrintStats();
+            prePass.Enabled = !prePass.Enabled;
+            toggleDepthPrePass = false;
         }
-        glBindVertexArray(0);
 
 
         // Also draw the lamp object, again binding the appropriate shader
@@ -305,22 +582,56 @@ int main()
         glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
         // We now draw as many light bulbs as we have point lights.
-        glBindVertexArray(lightVAO);
-        for (GLuint i = 0; i < 4; i++)
+        glm::mat4 model;
+        if (useStaticBatching)
         {
-            model = glm::mat4();
-            model = glm::translate(model, pointLightPositions[i]);
-            model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller cube
             glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            lampBatch.DrawAll();
+        }
+        else
+        {
+            glBindVertexArray(lightVAO);
+            for (GLuint i = 0; i < 4; i++)
+            {
+                model = glm::mat4();
+                model = glm::translate(model, pointLightPositions[i]);
+                model = glm::scale(model, glm::vec3(0.2f)); // Make it a smaller cube
+                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+                glDrawArrays(GL_TRIANGLES, 0, 36);
+            }
+            glBindVertexArray(0);
         }
-        glBindVertexArray(0);
 
+        overdraw.End();
+
+        if (toggleStatsOverlay)
+        {
+            stats.ShowOverlay = !stats.ShowOverlay;
+            toggleStatsOverlay = false;
+        }
+
+        // Report the last frame's draw calls before switching, so the batched and unbatched frames can be compared
+        if (toggleStaticBatching)
+        {
+            std::cout << "Draw calls per frame: " << stats.Counter("draw_calls") << (useStaticBatching ? " (batched)" : " (unbatched)") << std::endl;
+            useStaticBatching = !useStaticBatching;
+            toggleStaticBatching = false;
+        }
+        stats.EndFrame();
+
+        CPU_PROFILE_FRAME();
 
         // Swap the screen buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame(window, stats.Counters());
     }
 
+    // Delete the GL objects of the stats overlay, clustered lighting, deferred renderer and light manager while the
+    // context still exists
+    stats.Release();
+    clustered.Release();
+    deferred.Release();
+    lightManager.Release();
     // Terminate GLFW, clearing any resources allocated by GLFW.
     glfwTerminate();
     return 0;
@@ -343,6 +654,42 @@ void do_movement()
         camera.ProcessKeyboard(DOWN, deltaTime);
     if (keys[GLFW_KEY_SPACE])
         camera.ProcessKeyboard(UP, deltaTime);
+    if (keys[GLFW_KEY_B])
+    {
+        toggleStaticBatching = true;
+        keys[GLFW_KEY_B] = false;
+    }
+    if (keys[GLFW_KEY_P])
+    {
+        toggleDepthPrePass = true;
+        keys[GLFW_KEY_P] = false;
+    }
+    if (keys[GLFW_KEY_C])
+    {
+        toggleClusteredLighting = true;
+        keys[GLFW_KEY_C] = false;
+    }
+    if (keys[GLFW_KEY_G])
+    {
+        toggleDeferredShading = true;
+        keys[GLFW_KEY_G] = false;
+    }
+    if (keys[GLFW_KEY_V])
+    {
+        toggleStencilVolumes = true;
+        keys[GLFW_KEY_V] = false;
+    }
+    if (keys[GLFW_KEY_L])
+    {
+        toggleLightSwarm = true;
+        keys[GLFW_KEY_L] = false;
+    }
+    if (keys[GLFW_KEY_EQUAL] || keys[GLFW_KEY_MINUS])
+    {
+        swarmLightCount = keys[GLFW_KEY_EQUAL] ? std::min(swarmLightCount * 2, 4096u) : std::max(swarmLightCount / 2, 64u);
+        std::cout << swarmLightCount << " small lights" << std::endl;
+        keys[GLFW_KEY_EQUAL] = keys[GLFW_KEY_MINUS] = false;
+    }
 }
 
 // Is called whenever a key is pressed/released via GLFW
@@ -351,6 +698,17 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     //cout << key << endl;
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        toggleOverdrawView = true;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        toggleStatsOverlay = true;
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        // Print the last frame's CPU zones and write everything recorded so far as a Chrome trace
+        CpuProfiler::Instance().PrintFrameSummary();
+        if (CpuProfiler::Instance().WriteChromeTrace("cpu_trace.json"))
+            std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+    }
     if (key >= 0 && key < 1024)
     {
         if (action == GLFW_PRESS)
@@ -395,8 +753,11 @@ enum environmentLightingMode {
 
 environmentLightingMode lighting_mode = DEFAULT;
 
-void configure_environment_lighting(Shader lightingShader)
+// Sets the directional light and flashlight uniforms of the current mode, fills 'lamps' with its four point lights and
+// 'flashlight' with the values of the flashlight uniforms
+void configure_environment_lighting(Shader lightingShader, std::vector<PointLight>& lamps, SpotLight& flashlight)
 {
+    lamps.resize(4);
     if (keys[GLFW_KEY_1])
         lighting_mode = DEFAULT;
     if (keys[GLFW_KEY_2])
@@ -417,49 +778,18 @@ void configure_environment_lighting(Shader lightingShader)
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.ambient"), 0.05f, 0.05f, 0.05f);
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.diffuse"), 0.4f, 0.4f, 0.4f);
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.specular"), 0.5f, 0.5f, 0.5f);
-        // Point light 1
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].position"), pointLightPositions[0].x, pointLightPositions[0].y, pointLightPositions[0].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].ambient"), 0.05f, 0.05f, 0.05f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].diffuse"), 0.8f, 0.8f, 0.8f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].specular"), 1.0f, 1.0f, 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].quadratic"), 0.032);
-        // Point light 2
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].position"), pointLightPositions[1].x, pointLightPositions[1].y, pointLightPositions[1].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].ambient"), 0.05f, 0.05f, 0.05f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].diffuse"), 0.8f, 0.8f, 0.8f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].specular"), 1.0f, 1.0f, 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].quadratic"), 0.032);
-        // Point light 3
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].position"), pointLightPositions[2].x, pointLightPositions[2].y, pointLightPositions[2].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].ambient"), 0.05f, 0.05f, 0.05f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].diffuse"), 0.8f, 0.8f, 0.8f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].specular"), 1.0f, 1.0f, 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].quadratic"), 0.032);
-        // Point light 4
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].position"), pointLightPositions[3].x, pointLightPositions[3].y, pointLightPositions[3].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].ambient"), 0.05f, 0.05f, 0.05f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].diffuse"), 0.8f, 0.8f, 0.8f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].specular"), 1.0f, 1.0f, 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].quadratic"), 0.032);
+        // Point lights
+        for (GLuint i = 0; i < 4; i++)
+        {
+            lamps[i] = PointLight(pointLightPositions[i], glm::vec3(0.8f));
+            lamps[i].Ambient = glm::vec3(0.05f);
+            lamps[i].Specular = glm::vec3(1.0f);
+        }
         // SpotLight
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.position"), camera.Position.x, camera.Position.y, camera.Position.z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.direction"), camera.Front.x, camera.Front.y, camera.Front.z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.ambient"), 0.0f, 0.0f, 0.0f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.diffuse"), 1.0f, 1.0f, 1.0f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.specular"), 1.0f, 1.0f, 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.quadratic"), 0.032);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.cutOff"), glm::cos(glm::radians(12.5f)));
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.outerCutOff"), glm::cos(glm::radians(15.0f)));
+        flashlight.Light = PointLight(camera.Position, glm::vec3(1.0f));
+        flashlight.Light.Ambient = glm::vec3(0.0f);
+        flashlight.CutOff = glm::cos(glm::radians(12.5f));
+        flashlight.OuterCutOff = glm::cos(glm::radians(15.0f));
     }
 
 
@@ -480,49 +810,17 @@ void configure_environment_lighting(Shader lightingShader)
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.ambient"), 1.0f, 0.5f, 0.26f);
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.diffuse"), 0.5f, 0.52f, 0.26f);
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.specular"), 0.5f, 0.5f, 0.5f);
-        // Point light 1
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].position"), pointLightPositions[0].x, pointLightPositions[0].y, pointLightPositions[0].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].ambient"), pointLightColors[0].x * 0.1, pointLightColors[0].y * 0.1, pointLightColors[0].z * 0.1);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].diffuse"), pointLightColors[0].x, pointLightColors[0].y, pointLightColors[0].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].specular"), pointLightColors[0].x, pointLightColors[0].y, pointLightColors[0].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].quadratic"), 0.032);
-        // Point light 2
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].position"), pointLightPositions[1].x, pointLightPositions[1].y, pointLightPositions[1].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].ambient"), pointLightColors[1].x * 0.1, pointLightColors[1].y * 0.1, pointLightColors[1].z * 0.1);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].diffuse"), pointLightColors[1].x, pointLightColors[1].y, pointLightColors[1].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].specular"), pointLightColors[1].x, pointLightColors[1].y, pointLightColors[1].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].quadratic"), 0.032);
-        // Point light 3
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].position"), pointLightPositions[2].x, pointLightPositions[2].y, pointLightPositions[2].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].ambient"), pointLightColors[2].x * 0.1, pointLightColors[2].y * 0.1, pointLightColors[2].z * 0.1);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].diffuse"), pointLightColors[2].x, pointLightColors[2].y, pointLightColors[2].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].specular"), pointLightColors[2].x, pointLightColors[2].y, pointLightColors[2].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].quadratic"), 0.032);
-        // Point light 4
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].position"), pointLightPositions[3].x, pointLightPositions[3].y, pointLightPositions[3].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].ambient"), pointLightColors[3].x * 0.1, pointLightColors[3].y * 0.1, pointLightColors[3].z * 0.1);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].diffuse"), pointLightColors[3].x, pointLightColors[3].y, pointLightColors[3].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].specular"), pointLightColors[3].x, pointLightColors[3].y, pointLightColors[3].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].quadratic"), 0.032);
+        // Point lights
+        for (GLuint i = 0; i < 4; i++)
+        {
+            lamps[i] = PointLight(pointLightPositions[i], pointLightColors[i]);
+            lamps[i].Ambient = pointLightColors[i] * 0.1f;
+        }
         // SpotLight
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.position"), camera.Position.x, camera.Position.y, camera.Position.z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.direction"), camera.Front.x, camera.Front.y, camera.Front.z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.ambient"), 0.0f, 0.0f, 0.0f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.diffuse"), 0.8f, 0.8f, 0.0f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.specular"), 0.8f, 0.8f, 0.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.quadratic"), 0.032);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.cutOff"), glm::cos(glm::radians(12.5f)));
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.outerCutOff"), glm::cos(glm::radians(13.0f)));
+        flashlight.Light = PointLight(camera.Position, glm::vec3(0.8f, 0.8f, 0.0f));
+        flashlight.Light.Ambient = glm::vec3(0.0f);
+        flashlight.CutOff = glm::cos(glm::radians(12.5f));
+        flashlight.OuterCutOff = glm::cos(glm::radians(13.0f));
     }
 
     if (lighting_mode == RADIOACTIVE)
@@ -550,49 +848,18 @@ void configure_environment_lighting(Shader lightingShader)
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.ambient"), 0.01f, 0.05f, 0.026f);
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.diffuse"), 0.5f, 0.52f, 0.26f);
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.specular"), 0.5f, 0.5f, 0.5f);
-        // Point light 1
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].position"), pointLightPositions[0].x, pointLightPositions[0].y, pointLightPositions[0].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].ambient"), pointLightColors[0].x * 10.0, pointLightColors[0].y * 10.0, pointLightColors[0].z * 10.0);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].diffuse"), pointLightColors[0].x, pointLightColors[0].y, pointLightColors[0].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].specular"), pointLightColors[0].x, pointLightColors[0].y, pointLightColors[0].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].quadratic"), 0.032);
-        // Point light 2
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].position"), pointLightPositions[1].x, pointLightPositions[1].y, pointLightPositions[1].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].ambient"), pointLightColors[1].x * 5.0, pointLightColors[1].y * 5.0, pointLightColors[1].z * 5.0);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].diffuse"), pointLightColors[1].x, pointLightColors[1].y, pointLightColors[1].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].specular"), pointLightColors[1].x, pointLightColors[1].y, pointLightColors[1].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].quadratic"), 0.032);
-        // Point light 3
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].position"), pointLightPositions[2].x, pointLightPositions[2].y, pointLightPositions[2].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].ambient"), pointLightColors[2].x * 1.0, pointLightColors[2].y * 1.0, pointLightColors[2].z * 1.0);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].diffuse"), pointLightColors[2].x, pointLightColors[2].y, pointLightColors[2].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].specular"), pointLightColors[2].x, pointLightColors[2].y, pointLightColors[2].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].quadratic"), 0.032);
-        // Point light 4
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].position"), pointLightPositions[3].x, pointLightPositions[3].y, pointLightPositions[3].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].ambient"), pointLightColors[3].x * 1.0, pointLightColors[3].y * 1.0, pointLightColors[3].z * 1.0);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].diffuse"), pointLightColors[3].x, pointLightColors[3].y, pointLightColors[3].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].specular"), pointLightColors[3].x, pointLightColors[3].y, pointLightColors[3].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].quadratic"), 0.032);
+        // Point lights
+        GLfloat ambientScales[] = { 10.0f, 5.0f, 1.0f, 1.0f };
+        for (GLuint i = 0; i < 4; i++)
+        {
+            lamps[i] = PointLight(pointLightPositions[i], pointLightColors[i]);
+            lamps[i].Ambient = pointLightColors[i] * ambientScales[i];
+        }
         // SpotLight
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.position"), camera.Position.x, camera.Position.y, camera.Position.z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.direction"), camera.Front.x, camera.Front.y, camera.Front.z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.ambient"), 0.0f, 0.0f, 0.0f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.diffuse"), 0.8f, 0.8f, 0.0f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.specular"), 0.8f, 0.8f, 0.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.quadratic"), 0.032);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.cutOff"), glm::cos(glm::radians(12.5f)));
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.outerCutOff"), glm::cos(glm::radians(13.0f)));
+        flashlight.Light = PointLight(camera.Position, glm::vec3(0.8f, 0.8f, 0.0f));
+        flashlight.Light.Ambient = glm::vec3(0.0f);
+        flashlight.CutOff = glm::cos(glm::radians(12.5f));
+        flashlight.OuterCutOff = glm::cos(glm::radians(13.0f));
     }
 
     if (lighting_mode == HELL)
@@ -612,48 +879,28 @@ void configure_environment_lighting(Shader lightingShader)
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.ambient"), 0.01f, 0.05f, 0.026f);
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.diffuse"), 0.5f, 0.52f, 0.26f);
         glUniform3f(glGetUniformLocation(lightingShader.Program, "dirLight.specular"), 0.5f, 0.5f, 0.5f);
-        // Point light 1
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].position"), pointLightPositions[0].x, pointLightPositions[0].y, pointLightPositions[0].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].ambient"), pointLightColors[0].x * 1.0, pointLightColors[0].y * 1.0, pointLightColors[0].z * 1.0);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].diffuse"), pointLightColors[0].x, pointLightColors[0].y, pointLightColors[0].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[0].specular"), pointLightColors[0].x, pointLightColors[0].y, pointLightColors[0].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[0].quadratic"), 0.032);
-        // Point light 2
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].position"), pointLightPositions[1].x, pointLightPositions[1].y, pointLightPositions[1].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].ambient"), pointLightColors[1].x * 1.0, pointLightColors[1].y * 1.0, pointLightColors[1].z * 1.0);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].diffuse"), pointLightColors[1].x, pointLightColors[1].y, pointLightColors[1].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[1].specular"), pointLightColors[1].x, pointLightColors[1].y, pointLightColors[1].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[1].quadratic"), 0.032);
-        // Point light 3
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].position"), pointLightPositions[2].x, pointLightPositions[2].y, pointLightPositions[2].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].ambient"), pointLightColors[2].x * 1.0, pointLightColors[2].y * 1.0, pointLightColors[2].z * 1.0);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].diffuse"), pointLightColors[2].x, pointLightColors[2].y, pointLightColors[2].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[2].specular"), pointLightColors[2].x, pointLightColors[2].y, pointLightColors[2].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[2].quadratic"), 0.032);
-        // Point light 4
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].position"), pointLightPositions[3].x, pointLightPositions[3].y, pointLightPositions[3].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].ambient"), pointLightColors[3].x * 1.0, pointLightColors[3].y * 1.0, pointLightColors[3].z * 1.0);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].diffuse"), pointLightColors[3].x, pointLightColors[3].y, pointLightColors[3].z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "pointLights[3].specular"), pointLightColors[3].x, pointLightColors[3].y, pointLightColors[3].z);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "pointLights[3].quadratic"), 0.032);
+        // Point lights
+        for (GLuint i = 0; i < 4; i++)
+        {
+            lamps[i] = PointLight(pointLightPositions[i], pointLightColors[i]);
+            lamps[i].Ambient = pointLightColors[i];
+        }
         // SpotLight
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.position"), camera.Position.x, camera.Position.y, camera.Position.z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.direction"), camera.Front.x, camera.Front.y, camera.Front.z);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.ambient"), 0.0f, 0.0f, 0.0f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.diffuse"), 0.8f, 0.8f, 0.0f);
-        glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.specular"), 0.8f, 0.8f, 0.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.linear"), 0.09);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.quadratic"), 0.032);
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.cutOff"), glm::cos(glm::radians(12.5f)));
-        glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.outerCutOff"), glm::cos(glm::radians(13.0f)));
+        flashlight.Light = PointLight(camera.Position, glm::vec3(0.8f, 0.8f, 0.0f));
+        flashlight.Light.Ambient = glm::vec3(0.0f);
+        flashlight.CutOff = glm::cos(glm::radians(12.5f));
+        flashlight.OuterCutOff = glm::cos(glm::radians(13.0f));
     }
+
+    // The flashlight uniforms, from the values of the current mode
+    glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.position"), camera.Position.x, camera.Position.y, camera.Position.z);
+    glUniform3f(glGetUniformLocation(lightingShader.Program, "spotLight.direction"), camera.Front.x, camera.Front.y, camera.Front.z);
+    glUniform3fv(glGetUniformLocation(lightingShader.Program, "spotLight.ambient"), 1, glm::value_ptr(flashlight.Light.Ambient));
+    glUniform3fv(glGetUniformLocation(lightingShader.Program, "spotLight.diffuse"), 1, glm::value_ptr(flashlight.Light.Diffuse));
+    glUniform3fv(glGetUniformLocation(lightingShader.Program, "spotLight.specular"), 1, glm::value_ptr(flashlight.Light.Specular));
+    glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.constant"), flashlight.Light.Constant);
+    glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.linear"), flashlight.Light.Linear);
+    glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.quadratic"), flashlight.Light.Quadratic);
+    glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.cutOff"), flashlight.CutOff);
+    glUniform1f(glGetUniformLocation(lightingShader.Program, "spotLight.outerCutOff"), flashlight.OuterCutOff);
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <algorithm>
 #include <cmath>
@@ -20,15 +24,28 @@
 #include <glm/gtc/type_ptr.hpp>
 
 // Other includes
+// The render statistics come first so the GL 1.1 calls made by the other headers are counted as well
+#define LEARN_OPENGL_GL_RECORDER
+#include <learn_opengl/headers/RenderStats.h>
 #include <learn_opengl/headers/Shader.h>
 #include <learn_opengl/headers/Camera.h>
 #include <learn_opengl/headers/Mesh.h>
 #include <learn_opengl/headers/Model.h>
+#include <learn_opengl/headers/OverdrawView.h>
+#include <learn_opengl/headers/CpuProfiler.h>
+#include <learn_opengl/headers/Benchmark.h>
+#include <learn_opengl/headers/InputJournal.h>
 
 std::string current_working_directory()
 {
+#ifdef _WIN32
     char working_directory[MAX_PATH + 1];
     GetCurrentDirectoryA(sizeof(working_directory), working_directory);
+#else
+    char working_directory[4096];
+    if (!getcwd(working_directory, sizeof(working_directory)))
+        working_directory[0] = '\0';
+#endif
     return working_directory;
 }
 
@@ -38,10 +55,20 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void Do_movement();
 void configure_environment_lighting(Shader shader);
+bool check_draw_binds();
 
 // Window dimensions
 const GLuint screenWIDTH = 800, screenHEIGHT = 600;
 
+// Overdraw heatmap, toggled with F1
+bool toggleOverdrawView = false;
+
+// Render statistics overlay, toggled with F6
+bool toggleStatsOverlay = false;
+
+// Log of every GL call of the next frame, taken with F5
+bool captureGLFrame = false;
+
 // Camera
 Camera  camera(glm::vec3(0.0f, 0.0f, 3.0f));
 GLfloat lastX = 400;
@@ -66,8 +93,18 @@ glm::vec3 pointLightPositions[] = {
 };
 
 // The MAIN function, from here we start the application and run the game loop
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark renders a scripted run in a hidden window and writes the frame timings as JSON
+    Benchmark benchmark(argc, argv, "03.model_loading/01-03.model_loading_and_lighting");
+    // --record=file.bin journals the input, --replay=file.bin plays it back for an exactly repeatable run
+    InputJournal journal(argc, argv);
+    benchmark.ScriptedCamera = !journal.Replaying();
+    // --check-binds draws the nanosuit once with the GL calls only recorded, without a window or a GPU, and checks its binds
+    for (int i = 1; i < argc; i++)
+        if (strcmp(argv[i], "--check-binds") == 0)
+            return check_draw_binds() ? 0 : 1;
+
     // Init GLFW
     glfwInit();
     // Set all the required options for GLFW
@@ -75,6 +112,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    benchmark.WindowHints();
 
     // Create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow(screenWIDTH, screenHEIGHT, "Model Loading", nullptr, nullptr);
@@ -84,6 +122,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    journal.Attach(window);
 
     // GLFW Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -111,18 +150,47 @@ int main()
     Model ourModel(nanosuit_obj_path);
 
 
+    // Counts the fragments shaded per pixel while enabled
+    OverdrawView overdraw(screenWIDTH, screenHEIGHT);
+
+    // Draw calls, binds, uploads and frame times of every frame, shown with F6
+    RenderStats stats(screenWIDTH, screenHEIGHT);
+    // The recorder behind it also keeps the log of every GL call of a frame, taken with F5
+    GLRecorder& recorder = GLRecorder::Instance();
+
     // Game loop
     while (!glfwWindowShouldClose(window))
     {
+        benchmark.BeginFrame(camera);
+        stats.BeginFrame();
+
         // Set frame time
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        journal.BeginFrame(deltaTime);
 
         // Check and call events
         glfwPollEvents();
         Do_movement();
 
+        if (captureGLFrame)
+        {
+            recorder.Log.clear();
+            recorder.LogCommands = GL_TRUE;
+            captureGLFrame = false;
+        }
+
+        // Show the overdraw heatmap instead of the frame; its statistics are printed when it's switched off
+        if (toggleOverdrawView)
+        {
+            if (overdraw.Enabled)
+                overdraw.PrintStats();
+            overdraw.Enabled = !overdraw.Enabled;
+            toggleOverdrawView = false;
+        }
+        overdraw.Begin();
+
         // Clear the colorbuffer
         glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -144,10 +212,31 @@ int main()
         glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
         ourModel.Draw(shader);
 
+        overdraw.End();
+
+        if (toggleStatsOverlay)
+        {
+            stats.ShowOverlay = !stats.ShowOverlay;
+            toggleStatsOverlay = false;
+        }
+        stats.EndFrame();
+
+        CPU_PROFILE_FRAME();
+
         // Swap the buffers
         glfwSwapBuffers(window);
+        if (recorder.LogCommands)
+        {
+            recorder.PrintStats();
+            if (recorder.WriteLog("gl_commands.txt"))
+                std::cout << "GL calls written to gl_commands.txt" << std::endl;
+            recorder.LogCommands = GL_FALSE;
+        }
+        benchmark.EndFrame(window, stats.Counters());
     }
 
+    // Delete the GL objects of the stats overlay while the context still exists
+    stats.Release();
     glfwTerminate();
     return 0;
 }
@@ -155,8 +244,41 @@ int main()
 #pragma region "User input"
 
 // Moves/alters the camera positions based on user input
+// Loads and draws the nanosuit with the GL recorder in its recording-only mode and checks what Model::Draw issues:
+// a draw call per mesh, and no more than a bind and an unbind per texture of a mesh
+bool check_draw_binds()
+{
+    GLRecorder& recorder = GLRecorder::Instance();
+    recorder.Install(false);
+
+    std::string cwd = current_working_directory();
+    std::replace(cwd.begin(), cwd.end(), '\\', '/');
+    std::string vs_path = cwd + "/Shaders/model_loading.vs";
+    std::string frag_path = cwd + "/Shaders/model_loading.frag";
+    std::string obj_path = cwd + "/Resources/nanosuit/nanosuit.obj";
+    Shader shader(vs_path.c_str(), frag_path.c_str());
+    Model nanosuit(obj_path.c_str());
+
+    GLuint textures = 0;
+    for (GLuint i = 0; i < nanosuit.meshes.size(); i++)
+        textures += nanosuit.meshes[i].textures.size();
+
+    recorder.EndFrame();    // Loading counts as a frame of its own
+    nanosuit.Draw(shader);
+    recorder.EndFrame();
+    recorder.Uninstall();
+
+    const GLRecorder::FrameStats& s = recorder.LastFrame;
+    bool passed = !nanosuit.meshes.empty() && s.DrawCalls == nanosuit.meshes.size() && s.TextureBinds <= 2 * textures;
+    std::cout << "Model::Draw of the nanosuit: " << s.DrawCalls << " draws for " << nanosuit.meshes.size() << " meshes, "
+              << s.TextureBinds << " texture binds for " << textures << " textures: " << (passed ? "OK" : "FAILED") << std::endl;
+    return passed;
+}
+
 void Do_movement()
 {
+    CPU_PROFILE_ZONE("Do_movement");
+
     // Camera controls
     if (keys[GLFW_KEY_W])
         camera.ProcessKeyboard(FORWARD, deltaTime);
@@ -178,6 +300,19 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     //cout << key << endl;
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        toggleOverdrawView = true;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        toggleStatsOverlay = true;
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        // Print the last frame's CPU zones and write everything recorded so far as a Chrome trace
+        CpuProfiler::Instance().PrintFrameSummary();
+        if (CpuProfiler::Instance().WriteChromeTrace("cpu_trace.json"))
+            std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+    }
+    if (key == GLFW_KEY_F5 && action == GLFW_PRESS)
+        captureGLFrame = true;
     if (key >= 0 && key < 1024)
     {
         if (action == GLFW_PRESS)
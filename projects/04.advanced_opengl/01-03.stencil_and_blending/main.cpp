@@ -1,5 +1,9 @@
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <algorithm>
 #include <cmath>
@@ -20,16 +24,30 @@
 #include <glm/gtc/type_ptr.hpp>
 
 // Other includes
+// The render statistics come first so the GL 1.1 calls made by the other headers are counted as well
+#define LEARN_OPENGL_GL_RECORDER
+#include <learn_opengl/headers/RenderStats.h>
 #include <learn_opengl/headers/Shader.h>
 #include <learn_opengl/headers/Camera.h>
 #include <learn_opengl/headers/Mesh.h>
 #include <learn_opengl/headers/Model.h>
+#include <learn_opengl/headers/StaticBatch.h>
+#include <learn_opengl/headers/OverdrawView.h>
+#include <learn_opengl/headers/CpuProfiler.h>
+#include <learn_opengl/headers/Benchmark.h>
+#include <learn_opengl/headers/InputJournal.h>
 
 
 std::string current_working_directory()
 {
+#ifdef _WIN32
     char working_directory[MAX_PATH + 1];
     GetCurrentDirectoryA(sizeof(working_directory), working_directory);
+#else
+    char working_directory[4096];
+    if (!getcwd(working_directory, sizeof(working_directory)))
+        working_directory[0] = '\0';
+#endif
     return working_directory;
 }
 
@@ -44,6 +62,12 @@ GLuint loadTexture(const GLchar* path, GLboolean alpha = false);
 // Window dimensions
 const GLuint screenWIDTH = 800, screenHEIGHT = 600;
 
+// Overdraw heatmap, toggled with F1
+bool toggleOverdrawView = false;
+
+// Render statistics overlay, toggled with F6
+bool toggleStatsOverlay = false;
+
 // Camera
 Camera  camera(glm::vec3(0.0f, 0.0f, 3.0f));
 GLfloat lastX = 400;
@@ -56,10 +80,19 @@ bool firstMouse = true;
 GLfloat deltaTime = 0.0f;	// Time between current frame and last frame
 GLfloat lastFrame = 0.0f;  	// Time of last frame
 
+// Draw the floor, containers and their outlines from pre-transformed batches
+bool useStaticBatching = true;
+bool toggleStaticBatching = false;      // Set by B: report the draw calls and switch
 
 // The MAIN function, from here we start the application and run the game loop
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark renders a scripted run in a hidden window and writes the frame timings as JSON
+    Benchmark benchmark(argc, argv, "04.advanced_opengl/01-03.stencil_and_blending");
+    // --record=file.bin journals the input, --replay=file.bin plays it back for an exactly repeatable run
+    InputJournal journal(argc, argv);
+    benchmark.ScriptedCamera = !journal.Replaying();
+
     // Init GLFW
     glfwInit();
     // Set all the required options for GLFW
@@ -67,6 +100,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    benchmark.WindowHints();
 
     // Create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow(screenWIDTH, screenHEIGHT, "Stencil and Blending Implementation", nullptr, nullptr);
@@ -76,6 +110,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    journal.Attach(window);
 
     // GLFW Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -238,28 +273,65 @@ int main()
     windows.push_back(glm::vec3(-0.3f, 0.0f, -2.3f));
     windows.push_back(glm::vec3(0.5f, 0.0f, -0.6f));
 
+    // The floor and containers never move: bake them per texture, plus the scaled outline cubes in a batch of their own
+    StaticBatch sceneBatch(false), outlineBatch(false);
+    GLfloat outlineScale = 1.1;
+    glm::vec3 containerPositions[] = { glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(2.0f, 0.0f, 0.0f) };
+    sceneBatch.Add(floorTexture, planeVertices, 6, glm::mat4());
+    for (GLuint i = 0; i < 2; i++)
+    {
+        glm::mat4 model = glm::translate(glm::mat4(), containerPositions[i]);
+        sceneBatch.Add(cubeTexture, cubeVertices, 36, model);
+        outlineBatch.Add(cubeTexture, cubeVertices, 36, glm::scale(model, glm::vec3(outlineScale)));
+    }
+    sceneBatch.Build();
+    outlineBatch.Build();
+
+    // Counts the fragments shaded per pixel while enabled
+    OverdrawView overdraw(screenWIDTH, screenHEIGHT);
+
+    // Draw calls, binds, uploads and frame times of every frame, shown with F6
+    RenderStats stats(screenWIDTH, screenHEIGHT);
+
     // Game loop
     while (!glfwWindowShouldClose(window))
     {  
+        benchmark.BeginFrame(camera);
+        stats.BeginFrame();
+
         // Set frame time
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        journal.BeginFrame(deltaTime);
 
         // Check and call events
         glfwPollEvents();
         Do_movement();
 
+        // Show the overdraw heatmap instead of the frame; its statistics are printed when it's switched off
+        if (toggleOverdrawView)
+        {
+            if (overdraw.Enabled)
+                overdraw.PrintStats();
+            overdraw.Enabled = !overdraw.Enabled;
+            toggleOverdrawView = false;
+        }
+        overdraw.Begin();
+
         // Clear the colorbuffer
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
         // Sort windows
         std::map<GLfloat, glm::vec3> sorted;
-        for (GLuint i = 0; i < windows.size(); i++)
         {
-            GLfloat distance = glm::length(camera.Position - windows[i]);
-            sorted[distance] = windows[i];
+            CPU_PROFILE_ZONE("Sort windows");
+            for (GLuint i = 0; i < windows.size(); i++)
+            {
+                GLfloat distance = glm::length(camera.Position - windows[i]);
+                sorted[distance] = windows[i];
+            }
         }
 
         // Draw objects
@@ -277,37 +349,56 @@ int main()
         glUniformMatrix4fv(glGetUniformLocation(shaderSingleColor.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(shaderSingleColor.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
+        // The overdraw heatmap counts fragments with the stencil buffer, so the outline masking is left out while it's
+        // shown and the outline pass appears with its full raster cost
+        bool outlineMasking = !overdraw.Enabled;
+
         // Draw floor as normal, we only care about the containers. The floor should NOT fill the stencil buffer so we set its mask to 0x00
         transparencyShader.Use();
-        glStencilMask(0x00);
+        if (outlineMasking)
+            glStencilMask(0x00);
 
         // Floor
         glBindVertexArray(planeVAO);
         glBindTexture(GL_TEXTURE_2D, floorTexture);
         model = glm::mat4();
         glUniformMatrix4fv(glGetUniformLocation(transparencyShader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        if (useStaticBatching)
+            sceneBatch.Draw(floorTexture);
+        else
+            glDrawArrays(GL_TRIANGLES, 0, 6);
         glBindVertexArray(0);
 
-        glEnable(GL_STENCIL_TEST);
-        glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-        glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+        if (outlineMasking)
+        {
+            glEnable(GL_STENCIL_TEST);
+            glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+            glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+        }
 
         // == =============
         // 1st. Render pass, draw objects as normal, filling the stencil buffer
-        glStencilFunc(GL_ALWAYS, 1, 0xFF);
-        glStencilMask(0xFF);
+        if (outlineMasking)
+        {
+            glStencilFunc(GL_ALWAYS, 1, 0xFF);
+            glStencilMask(0xFF);
+        }
 
         glBindVertexArray(cubeVAO);
         glBindTexture(GL_TEXTURE_2D, cubeTexture);
-        model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-        glUniformMatrix4fv(glGetUniformLocation(transparencyShader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        if (useStaticBatching)
+            sceneBatch.Draw(cubeTexture);
+        else
+        {
+            model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
+            glUniformMatrix4fv(glGetUniformLocation(transparencyShader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glDrawArrays(GL_TRIANGLES, 0, 36);
 
-        model = glm::mat4();
-        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        glUniformMatrix4fv(glGetUniformLocation(transparencyShader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+            model = glm::mat4();
+            model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
+            glUniformMatrix4fv(glGetUniformLocation(transparencyShader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
 
         glBindVertexArray(0);
 
@@ -315,32 +406,47 @@ int main()
         // 2nd. Render pass, now draw slightly scaled versions of the objects, this time disabling stencil writing.
         // Because stencil buffer is now filled with several 1s. The parts of the buffer that are 1 are now not drawn, thus only drawing 
         // the objects' size differences, making it look like borders.
-        glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-        glStencilMask(0x00);
+        if (outlineMasking)
+        {
+            glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+            glStencilMask(0x00);
+        }
         glDisable(GL_DEPTH_TEST);
         shaderSingleColor.Use();
-        GLfloat scale = 1.1;
+        GLfloat scale = outlineScale;
 
         glBindVertexArray(cubeVAO);
         glBindTexture(GL_TEXTURE_2D, cubeTexture);
 
-        model = glm::mat4();
-        model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-        model = glm::scale(model, glm::vec3(scale, scale, scale));
-        glUniformMatrix4fv(glGetUniformLocation(shaderSingleColor.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+        if (useStaticBatching)
+        {
+            model = glm::mat4();
+            glUniformMatrix4fv(glGetUniformLocation(shaderSingleColor.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            outlineBatch.DrawAll();
+        }
+        else
+        {
+            model = glm::mat4();
+            model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
+            model = glm::scale(model, glm::vec3(scale, scale, scale));
+            glUniformMatrix4fv(glGetUniformLocation(shaderSingleColor.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glDrawArrays(GL_TRIANGLES, 0, 36);
 
-        model = glm::mat4();
-        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(scale, scale, scale));
-        glUniformMatrix4fv(glGetUniformLocation(shaderSingleColor.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 36);
+            model = glm::mat4();
+            model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(scale, scale, scale));
+            glUniformMatrix4fv(glGetUniformLocation(shaderSingleColor.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
 
         // Disable stencil testing and enable depth testing so the transparent windows can be drawn as expected.
         glBindVertexArray(0);
-        glStencilMask(0xFF);
         glEnable(GL_DEPTH_TEST);
-        glDisable(GL_STENCIL_TEST);
+        if (outlineMasking)
+        {
+            glStencilMask(0xFF);
+            glDisable(GL_STENCIL_TEST);
+        }
 
         /*
         // Render windows (from nearest to furthest)
@@ -371,10 +477,32 @@ int main()
         }
         glBindVertexArray(0);
 
+        overdraw.End();
+
+        if (toggleStatsOverlay)
+        {
+            stats.ShowOverlay = !stats.ShowOverlay;
+            toggleStatsOverlay = false;
+        }
+
+        // Report the last frame's draw calls before switching, so the batched and unbatched frames can be compared
+        if (toggleStaticBatching)
+        {
+            std::cout << "Draw calls per frame: " << stats.Counter("draw_calls") << (useStaticBatching ? " (batched)" : " (unbatched)") << std::endl;
+            useStaticBatching = !useStaticBatching;
+            toggleStaticBatching = false;
+        }
+        stats.EndFrame();
+
+        CPU_PROFILE_FRAME();
+
         // Swap the buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame(window, stats.Counters());
     }
 
+    // Delete the GL objects of the stats overlay while the context still exists
+    stats.Release();
     glfwTerminate();
     return 0;
 }
@@ -412,6 +540,8 @@ GLuint loadTexture(const GLchar* path, GLboolean alpha)
 // Moves/alters the camera positions based on user input
 void Do_movement()
 {
+    CPU_PROFILE_ZONE("Do_movement");
+
     // Camera controls
     if (keys[GLFW_KEY_W])
         camera.ProcessKeyboard(FORWARD, deltaTime);
@@ -425,6 +555,11 @@ void Do_movement()
         camera.ProcessKeyboard(DOWN, deltaTime);
     if (keys[GLFW_KEY_SPACE])
         camera.ProcessKeyboard(UP, deltaTime);
+    if (keys[GLFW_KEY_B])
+    {
+        toggleStaticBatching = true;
+        keys[GLFW_KEY_B] = false;
+    }
 }
 
 
@@ -434,6 +569,17 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     //cout << key << endl;
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        toggleOverdrawView = true;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        toggleStatsOverlay = true;
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        // Print the last frame's CPU zones and write everything recorded so far as a Chrome trace
+        CpuProfiler::Instance().PrintFrameSummary();
+        if (CpuProfiler::Instance().WriteChromeTrace("cpu_trace.json"))
+            std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+    }
     if (key >= 0 && key < 1024)
     {
         if (action == GLFW_PRESS)
@@ -1,5 +1,9 @@
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <algorithm>
 #include <cmath>
@@ -22,16 +26,31 @@ using namespace std;
 #include <glm/gtc/type_ptr.hpp>
 
 // Other includes
+// The render statistics come first so the GL 1.1 calls made by the other headers are counted as well
+#define LEARN_OPENGL_GL_RECORDER
+#include <learn_opengl/headers/RenderStats.h>
 #include <learn_opengl/headers/Shader.h>
 #include <learn_opengl/headers/Camera.h>
 #include <learn_opengl/headers/Mesh.h>
 #include <learn_opengl/headers/Model.h>
+#include <learn_opengl/headers/OverdrawView.h>
+#include <learn_opengl/headers/CpuProfiler.h>
+#include <learn_opengl/headers/Benchmark.h>
+#include <learn_opengl/headers/InputJournal.h>
+#include <learn_opengl/headers/RenderGraph.h>
+#include <learn_opengl/headers/PostProcessChain.h>
 
 
 std::string current_working_directory()
 {
+#ifdef _WIN32
     char working_directory[MAX_PATH + 1];
     GetCurrentDirectoryA(sizeof(working_directory), working_directory);
+#else
+    char working_directory[4096];
+    if (!getcwd(working_directory, sizeof(working_directory)))
+        working_directory[0] = '\0';
+#endif
     return working_directory;
 }
 
@@ -51,16 +70,39 @@ enum filteringMode {
     KERNEL_BLUR,
     KERNEL_EDGE_DETECTION,
     KERNEL_EMBOSS,
-    KERNEL_TOP_SOBEL
+    KERNEL_TOP_SOBEL,
+    GAUSSIAN_BLUR,
+    BOX_BLUR
 };
 
-filteringMode filtering_mode = DEFAULT;
+void configure_filtering_mode(PostProcessChain& chain);
 
-void configure_filtering_mode();
+// Number keys pick one effect, T and G add a tonemap and gamma correction. With stacking on (Q) each pick is added to
+// the chain instead of replacing it; F switches between fusing the chain into as few passes as possible and one pass
+// per effect, F8 benchmarks both. 9 and 0 pick a Gaussian and a box blur of blurRadius texels, - and = halve and
+// double it. C runs the kernel passes as compute shaders, where the context has them.
+bool stackEffects = false;
+GLuint blurRadius = 4;
+bool toggleFusion = false;
+bool toggleCompute = false;
+bool benchmarkChain = false;
 
 // Window dimensions
 const GLuint screenWidth = 800, screenHeight = 600;
 
+// Overdraw heatmap, toggled with F1
+bool toggleOverdrawView = false;
+
+// Render statistics overlay, toggled with F6
+bool toggleStatsOverlay = false;
+
+// Render graph passes and texture pool, printed with F7
+bool printRenderGraph = false;
+
+// Scene rendered at full or half resolution, toggled with R
+GLfloat renderScale = 1.0f;
+bool toggleRenderScale = false;
+
 // Camera
 Camera  camera(glm::vec3(0.0f, 0.0f, 3.0f));
 bool    keys[1024];
@@ -73,8 +115,14 @@ GLfloat lastFrame = 0.0f;   // Time of last frame
 
 
 // The MAIN function, from here we start the application and run the game loop
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark renders a scripted run in a hidden window and writes the frame timings as JSON
+    Benchmark benchmark(argc, argv, "04.advanced_opengl/05.framebuffers_and_post_processing");
+    // --record=file.bin journals the input, --replay=file.bin plays it back for an exactly repeatable run
+    InputJournal journal(argc, argv);
+    benchmark.ScriptedCamera = !journal.Replaying();
+
     // Init GLFW
     glfwInit();
     // Set all the required options for GLFW
@@ -82,6 +130,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    benchmark.WindowHints();
 
     // Create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow(screenWidth, screenHeight, "FrameBuffer Implementation", nullptr, nullptr);
@@ -91,6 +140,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    journal.Attach(window);
 
     // GLFW Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -115,30 +165,8 @@ int main()
     std::string advanced_shader_frag_path = cwd + "/Shaders/advanced.frag";
     Shader shader(advanced_shader_vs_path.c_str(), advanced_shader_frag_path.c_str());
 
-    std::string no_filter_shader_vs_path = cwd + "/Shaders/no_filter.vs";
-    std::string no_filter_shader_frag_path = cwd + "/Shaders/no_filter.frag";
-    Shader no_filter_shader(no_filter_shader_vs_path.c_str(), no_filter_shader_frag_path.c_str());
-
-    std::string invert_shader_frag_path = cwd + "/Shaders/invert.frag";
-    Shader invert_filter_shader(no_filter_shader_vs_path.c_str(), invert_shader_frag_path.c_str());
-
-    std::string grayscale_shader_frag_path = cwd + "/Shaders/grayscale.frag";
-    Shader grayscale_filter_shader(no_filter_shader_vs_path.c_str(), grayscale_shader_frag_path.c_str());
-
-    std::string kernel_sharpen_shader_frag_path = cwd + "/Shaders/kernel_sharpen.frag";
-    Shader kernel_sharpen_filter_shader(no_filter_shader_vs_path.c_str(), kernel_sharpen_shader_frag_path.c_str());
-
-    std::string kernel_blur_shader_frag_path = cwd + "/Shaders/kernel_blur.frag";
-    Shader kernel_blur_filter_shader(no_filter_shader_vs_path.c_str(), kernel_blur_shader_frag_path.c_str());
-
-    std::string kernel_edge_detection_shader_frag_path = cwd + "/Shaders/kernel_edge_detection.frag";
-    Shader kernel_edge_detection_filter_shader(no_filter_shader_vs_path.c_str(), kernel_edge_detection_shader_frag_path.c_str());
-
-    std::string kernel_emboss_shader_frag_path = cwd + "/Shaders/kernel_emboss.frag";
-    Shader kernel_emboss_filter_shader(no_filter_shader_vs_path.c_str(), kernel_emboss_shader_frag_path.c_str());
-
-    std::string kernel_top_sobel_shader_frag_path = cwd + "/Shaders/kernel_top_sobel.frag";
-    Shader kernel_top_sobel_filter_shader(no_filter_shader_vs_path.c_str(), kernel_top_sobel_shader_frag_path.c_str());
+    // Post-processing effects, generated as one shader per pass
+    PostProcessChain chain;
 
 
     #pragma region "object_initialization"
@@ -200,17 +228,6 @@ int main()
         5.0f, -0.5f, -5.0f, 2.0f, 2.0f
     };
 
-    GLfloat quadVertices[] = {   // Vertex attributes for a quad that fills the entire screen in Normalized Device Coordinates.
-        // Positions   // TexCoords
-        -1.0f, 1.0f, 0.0f, 1.0f,
-        -1.0f, -1.0f, 0.0f, 0.0f,
-        1.0f, -1.0f, 1.0f, 0.0f,
-
-        -1.0f, 1.0f, 0.0f, 1.0f,
-        1.0f, -1.0f, 1.0f, 0.0f,
-        1.0f, 1.0f, 1.0f, 1.0f
-    };
-
     // Setup cube VAO
     GLuint cubeVAO, cubeVBO;
     glGenVertexArrays(1, &cubeVAO);
@@ -237,20 +254,6 @@ int main()
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
     glBindVertexArray(0);
 
-    // Setup screen VAO
-    GLuint quadVAO, quadVBO;
-    glGenVertexArrays(1, &quadVAO);
-    glGenBuffers(1, &quadVBO);
-    glBindVertexArray(quadVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), (GLvoid*)(2 * sizeof(GLfloat)));
-    glBindVertexArray(0);
-
-
     // Load textures
     std::string container_path = cwd + "/Resources/container.jpg";
     const GLchar* container_path_char = container_path.c_str();
@@ -262,159 +265,209 @@ int main()
 
     #pragma endregion
 
-    // Framebuffers
-    GLuint framebuffer;
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-
-    // Create a color attachment texture
-    //
-    // Generate texture ID and load texture data 
-    GLuint textureColorbuffer;
-    glGenTextures(1, &textureColorbuffer);
-    glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, screenWidth, screenHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0);
-
-    // Create a renderbuffer object for depth and stencil attachment (we won't be sampling these)
-    GLuint rbo;
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, screenWidth, screenHeight); // Use a single renderbuffer object for both a depth AND stencil buffer.
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo); // Now actually attach it
-
-    // Now that we actually created the framebuffer and added all attachments we want to check if it is actually complete now
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // The scene's colour and depth targets are transient textures of the render graph; it creates them on first use,
+    // reuses them every frame and deletes them once a frame no longer asks for them (e.g. after a resolution change)
+    RenderGraph graph;
 
     // Draw as wireframe
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
+    // Counts the fragments shaded per pixel while enabled
+    OverdrawView overdraw(screenWidth, screenHeight);
+
+    // Draw calls, binds, uploads and frame times of every frame, shown with F6
+    RenderStats stats(screenWidth, screenHeight);
+
     // Game loop
     while (!glfwWindowShouldClose(window))
     {  
+        benchmark.BeginFrame(camera);
+        stats.BeginFrame();
+
         // Set frame time
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        journal.BeginFrame(deltaTime);
 
         // Check and call events
         glfwPollEvents();
         Do_Movement();
 
+        // Show the overdraw heatmap instead of the frame; its statistics are printed when it's switched off
+        if (toggleOverdrawView)
+        {
+            if (overdraw.Enabled)
+                overdraw.PrintStats();
+            overdraw.Enabled = !overdraw.Enabled;
+            toggleOverdrawView = false;
+        }
+        if (toggleRenderScale)
+        {
+            renderScale = renderScale == 1.0f ? 0.5f : 1.0f;
+            toggleRenderScale = false;
+        }
+        GLsizei sceneWidth = (GLsizei)(screenWidth * renderScale), sceneHeight = (GLsizei)(screenHeight * renderScale);
+
+        RenderGraph::Resource backbuffer = graph.ImportBackbuffer(screenWidth, screenHeight);
+        RenderGraph::Resource sceneColor;
+
         /////////////////////////////////////////////////////
-        // Bind to framebuffer and draw to color texture 
-        // as we normally would.
+        // Draw to the scene's color texture as we normally 
+        // would.
         // //////////////////////////////////////////////////
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-        
-        // Clear all attached buffers
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // We're not using stencil buffer so why bother with clearing?
-
-        glEnable(GL_DEPTH_TEST);
-        // Set uniforms
-        shader.Use();
-        glm::mat4 model;
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 projection = glm::perspective(camera.Zoom, (float)screenWidth / (float)screenHeight, 0.1f, 100.0f);
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
-        // Floor
-        glBindVertexArray(floorVAO);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
-        model = glm::mat4();
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
-
-        // Cubes
-        glBindVertexArray(cubeVAO);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
-        model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        model = glm::mat4();
-        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
+        graph.AddPass("scene", [&](RenderGraph::Builder& builder)
+        {
+            sceneColor = builder.Create("scene color", RenderGraph::TextureDesc(sceneWidth, sceneHeight, GL_RGB8));
+            builder.Create("scene depth", RenderGraph::TextureDesc(sceneWidth, sceneHeight, GL_DEPTH24_STENCIL8));
+        }, [&]()
+        {
+            overdraw.Begin();
+
+            // Clear all attached buffers
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // We're not using stencil buffer so why bother with clearing?
+
+            glEnable(GL_DEPTH_TEST);
+            // Set uniforms
+            shader.Use();
+            glm::mat4 model;
+            glm::mat4 view = camera.GetViewMatrix();
+            glm::mat4 projection = glm::perspective(camera.Zoom, (float)screenWidth / (float)screenHeight, 0.1f, 100.0f);
+            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+
+            // Floor
+            glBindVertexArray(floorVAO);
+            glBindTexture(GL_TEXTURE_2D, floorTexture);
+            model = glm::mat4();
+            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            glBindVertexArray(0);
+
+            // Cubes
+            glBindVertexArray(cubeVAO);
+            glBindTexture(GL_TEXTURE_2D, cubeTexture);
+            model = glm::translate(model, glm::vec3(-1.0f, 0.0f, -1.0f));
+            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            model = glm::mat4();
+            model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
+            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+            glBindVertexArray(0);
+
+            overdraw.End();
+        });
 
         /////////////////////////////////////////////////////
-        // Bind to default framebuffer again and draw the 
-        // quad plane with attched screen texture.
+        // Post-process the scene's color texture into the 
+        // default framebuffer.
         // //////////////////////////////////////////////////
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        // Clear all relevant buffers
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f); // Set clear color to white (not really necessery actually, since we won't be able to see behind the quad anyways)
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST); // We don't care about depth information when rendering a single quad
-
-        // Configure the filtering mode and use the corresponding shader
-        configure_filtering_mode();
-        if (filtering_mode == DEFAULT)
-            no_filter_shader.Use();
-        else if (filtering_mode == INVERT)
-            invert_filter_shader.Use();
-        else if (filtering_mode == GRAYSCALE)
-            grayscale_filter_shader.Use();
-        else if (filtering_mode == KERNEL_SHARPEN)
-            kernel_sharpen_filter_shader.Use();
-        else if (filtering_mode == KERNEL_BLUR)
-            kernel_blur_filter_shader.Use();
-        else if (filtering_mode == KERNEL_EDGE_DETECTION)
-            kernel_edge_detection_filter_shader.Use();
-        else if (filtering_mode == KERNEL_EMBOSS)
-            kernel_emboss_filter_shader.Use();
-        else if (filtering_mode == KERNEL_TOP_SOBEL)
-            kernel_top_sobel_filter_shader.Use();
-        else
-            no_filter_shader.Use();
-
-        glBindVertexArray(quadVAO);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);	// Use the color attachment texture as the texture of the quad plane
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+        configure_filtering_mode(chain);
+        if (toggleFusion)
+        {
+            chain.Fuse = !chain.Fuse;
+            cout << "Post-process chain " << (chain.Fuse ? "fused" : "unfused") << ": " << chain.Passes() << " passes" << endl;
+            toggleFusion = false;
+        }
+        if (toggleCompute)
+        {
+            chain.Compute = chain.ComputeSupported() && !chain.Compute;
+            cout << "Post-process kernels as " << (chain.Compute ? "compute shaders" : "fragment shaders")
+                 << (chain.ComputeSupported() ? "" : " (compute shaders need OpenGL 4.3)") << endl;
+            toggleCompute = false;
+        }
+        if (benchmarkChain)
+        {
+            // Times the chain on this frame's scene, fused and one pass per effect
+            graph.AddPass("post-process benchmark", [&](RenderGraph::Builder& builder)
+            {
+                builder.Read(sceneColor);
+                builder.SideEffect();
+            }, [&]()
+            {
+                chain.Benchmark(graph.Texture(sceneColor), sceneWidth, sceneHeight);
+            });
+            benchmarkChain = false;
+        }
+        chain.AddPasses(graph, sceneColor, backbuffer);
+
+        graph.Execute();
+        if (printRenderGraph)
+        {
+            graph.PrintStats();
+            printRenderGraph = false;
+        }
+
+        if (toggleStatsOverlay)
+        {
+            stats.ShowOverlay = !stats.ShowOverlay;
+            toggleStatsOverlay = false;
+        }
+        stats.EndFrame();
+
+        CPU_PROFILE_FRAME();
 
         // Swap the buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame(window, stats.Counters());
     }
 
-    // Clean up
-    glDeleteFramebuffers(1, &framebuffer);
-
+    // Delete the GL objects of the render graph, post-processing chain and stats overlay while the context still exists
+    graph.Release();
+    chain.Release();
+    stats.Release();
     glfwTerminate();
     return 0;
 }
 
 
-void configure_filtering_mode()
+void configure_filtering_mode(PostProcessChain& chain)
 {
-    if (keys[GLFW_KEY_1])
-        filtering_mode = DEFAULT;
-    else if (keys[GLFW_KEY_2])
-        filtering_mode = INVERT;
-    else if (keys[GLFW_KEY_3])
-        filtering_mode = GRAYSCALE;
-    else if (keys[GLFW_KEY_4])
-        filtering_mode = KERNEL_SHARPEN;
-    else if (keys[GLFW_KEY_5])
-        filtering_mode = KERNEL_BLUR;
-    else if (keys[GLFW_KEY_6])
-        filtering_mode = KERNEL_EDGE_DETECTION;
-    else if (keys[GLFW_KEY_7])
-        filtering_mode = KERNEL_EMBOSS;
-    else if (keys[GLFW_KEY_8])
-        filtering_mode = KERNEL_TOP_SOBEL;
+    for (int key = GLFW_KEY_0; key <= GLFW_KEY_9; key++)
+    {
+        if (!keys[key])
+            continue;
+        if (!stackEffects)
+            chain.Clear();
+        filteringMode mode = key == GLFW_KEY_0 ? BOX_BLUR : (filteringMode)(key - GLFW_KEY_1);
+        if (mode == INVERT)
+            chain.Invert();
+        else if (mode == GRAYSCALE)
+            chain.Grayscale();
+        else if (mode == KERNEL_SHARPEN)
+            chain.Sharpen();
+        else if (mode == KERNEL_BLUR)
+            chain.Blur();
+        else if (mode == KERNEL_EDGE_DETECTION)
+            chain.EdgeDetection();
+        else if (mode == KERNEL_EMBOSS)
+            chain.Emboss();
+        else if (mode == KERNEL_TOP_SOBEL)
+            chain.Sobel();
+        else if (mode == GAUSSIAN_BLUR)
+            chain.Gaussian(blurRadius);
+        else if (mode == BOX_BLUR)
+            chain.Box(blurRadius);
+        keys[key] = false;
+    }
+    if (keys[GLFW_KEY_T])
+    {
+        chain.Tonemap();
+        keys[GLFW_KEY_T] = false;
+    }
+    if (keys[GLFW_KEY_G])
+    {
+        chain.Gamma();
+        keys[GLFW_KEY_G] = false;
+    }
+    if (keys[GLFW_KEY_MINUS] || keys[GLFW_KEY_EQUAL])
+    {
+        blurRadius = keys[GLFW_KEY_MINUS] ? std::max(1u, blurRadius / 2) : std::min(64u, blurRadius * 2);
+        std::cout << "Blur radius " << blurRadius << " texels" << std::endl;
+        keys[GLFW_KEY_MINUS] = keys[GLFW_KEY_EQUAL] = false;
+    }
 }
 
 
@@ -452,6 +505,8 @@ GLuint loadTexture(const GLchar* path, GLboolean alpha)
 // Moves/alters the camera positions based on user input
 void Do_Movement()
 {
+    CPU_PROFILE_ZONE("Do_Movement");
+
     // Camera controls
     if (keys[GLFW_KEY_W])
         camera.ProcessKeyboard(FORWARD, deltaTime);
@@ -474,6 +529,32 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     //cout << key << endl;
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        toggleOverdrawView = true;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        toggleStatsOverlay = true;
+    if (key == GLFW_KEY_F7 && action == GLFW_PRESS)
+        printRenderGraph = true;
+    if (key == GLFW_KEY_R && action == GLFW_PRESS)
+        toggleRenderScale = true;
+    if (key == GLFW_KEY_F8 && action == GLFW_PRESS)
+        benchmarkChain = true;
+    if (key == GLFW_KEY_F && action == GLFW_PRESS)
+        toggleFusion = true;
+    if (key == GLFW_KEY_C && action == GLFW_PRESS)
+        toggleCompute = true;
+    if (key == GLFW_KEY_Q && action == GLFW_PRESS)
+    {
+        stackEffects = !stackEffects;
+        std::cout << "Stacking post-processing effects " << (stackEffects ? "on" : "off") << std::endl;
+    }
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        // Print the last frame's CPU zones and write everything recorded so far as a Chrome trace
+        CpuProfiler::Instance().PrintFrameSummary();
+        if (CpuProfiler::Instance().WriteChromeTrace("cpu_trace.json"))
+            std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+    }
     if (key >= 0 && key < 1024)
     {
         if (action == GLFW_PRESS)
@@ -0,0 +1,14 @@
+#version 330 core
+layout (location = 0) in vec3 position;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// Must match model_loading.vs exactly, so the colour pass can test its depths with GL_EQUAL
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection * view *  model * vec4(position, 1.0f);
+}
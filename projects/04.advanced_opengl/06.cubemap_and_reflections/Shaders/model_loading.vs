@@ -11,6 +11,9 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// The depth pre-pass and this pass must produce bit-identical depths
+invariant gl_Position;
+
 void main()
 {
     gl_Position = projection * view *  model * vec4(position, 1.0f);
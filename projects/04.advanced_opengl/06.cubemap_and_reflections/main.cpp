@@ -1,5 +1,9 @@
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <algorithm>
 #include <cmath>
@@ -20,16 +24,35 @@
 #include <glm/gtc/type_ptr.hpp>
 
 // Other includes
+// The render statistics come first so the GL 1.1 calls made by the other headers are counted as well
+#define LEARN_OPENGL_GL_RECORDER
+#include <learn_opengl/headers/RenderStats.h>
 #include <learn_opengl/headers/Shader.h>
 #include <learn_opengl/headers/Camera.h>
 #include <learn_opengl/headers/Mesh.h>
 #include <learn_opengl/headers/Model.h>
+#include <learn_opengl/headers/MatrixKernels.h>
+#include <learn_opengl/headers/JobSystem.h>
+#include <learn_opengl/headers/Frustum.h>
+#include <learn_opengl/headers/LodSelector.h>
+#include <learn_opengl/headers/DepthPrePass.h>
+#include <learn_opengl/headers/OverdrawView.h>
+#include <learn_opengl/headers/CpuProfiler.h>
+#include <learn_opengl/headers/Benchmark.h>
+#include <learn_opengl/headers/InputJournal.h>
+#include <learn_opengl/headers/GpuProfiler.h>
 
 
 std::string current_working_directory()
 {
+#ifdef _WIN32
     char working_directory[MAX_PATH + 1];
     GetCurrentDirectoryA(sizeof(working_directory), working_directory);
+#else
+    char working_directory[4096];
+    if (!getcwd(working_directory, sizeof(working_directory)))
+        working_directory[0] = '\0';
+#endif
     return working_directory;
 }
 
@@ -44,6 +67,18 @@ GLuint loadCubemap(vector<const GLchar*> faces);
 // Window dimensions
 const GLuint screenWIDTH = 800, screenHEIGHT = 600;
 
+// Overdraw heatmap, toggled with F1
+bool toggle_overdraw_view = false;
+
+// Render statistics overlay, toggled with F6
+bool toggle_stats_overlay = false;
+
+// Batched matrix kernels against the scalar glm path, benchmarked with 8 between frames
+bool run_matrix_benchmark = false;
+
+// Job system utilisation report and scaling test, run with 9 between frames
+bool run_job_benchmark = false;
+
 // Camera
 Camera  camera(glm::vec3(0.0f, 8.0f, 16.0f));
 GLfloat lastX = 400;
@@ -52,11 +87,16 @@ bool    keys[1024];
 
 bool firstMouse = true;
 bool load_skybox_texture_1 = true;
+bool use_rock_lods = true;
+bool toggle_depth_pre_pass = false;
 
 // Deltatime
 GLfloat deltaTime = 0.0f;	// Time between current frame and last frame
 GLfloat lastFrame = 0.0f;  	// Time of last frame
 
+// Spreads per-frame CPU work (culling) across the cores while this thread submits GL
+JobSystem jobs;
+
 // Positions of the point lights
 glm::vec3 pointLightPositions[] = {
     glm::vec3(0.7f, 0.2f, 2.0f),
@@ -66,8 +106,14 @@ glm::vec3 pointLightPositions[] = {
 };
 
 // The MAIN function, from here we start the application and run the game loop
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark renders a scripted run in a hidden window and writes the frame timings as JSON
+    Benchmark benchmark(argc, argv, "04.advanced_opengl/06.cubemap_and_reflections");
+    // --record=file.bin journals the input, --replay=file.bin plays it back for an exactly repeatable run
+    InputJournal journal(argc, argv);
+    benchmark.ScriptedCamera = !journal.Replaying();
+
     // Init GLFW
     glfwInit();
     // Set all the required options for GLFW
@@ -75,6 +121,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    benchmark.WindowHints();
 
     // Create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow(screenWIDTH, screenHEIGHT, "Skybox Implementation", nullptr, nullptr);
@@ -84,6 +131,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    journal.Attach(window);
 
     // GLFW Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -110,6 +158,10 @@ int main()
     std::string model_loading_frag_path = cwd + "/Shaders/model_loading.frag";
     Shader shader(model_loading_vs_path.c_str(), model_loading_frag_path.c_str());
 
+    std::string depth_vs_path = cwd + "/Shaders/depth.vs";
+    std::string depth_frag_path = cwd + "/Shaders/depth.frag";
+    Shader depthShader(depth_vs_path.c_str(), depth_frag_path.c_str());
+
     std::string skybox_vs_path = cwd + "/Shaders/skybox.vs";
     std::string skybox_frag_path = cwd + "/Shaders/skybox.frag";
     Shader skyboxShader(skybox_vs_path.c_str(), skybox_frag_path.c_str());
@@ -216,18 +268,23 @@ int main()
 
     std::string rock_obj_path = cwd + "/Resources/rock/rock.obj";
     Model rock(rock_obj_path.c_str());
+    // Simplified versions of the rock at 1/2, 1/4 and 1/8 of the triangles
+    rock.GenerateLods(4, 0.5f);
+    // Position-only streams for the depth pre-pass
+    nanosuit.SetupDepthStreams();
+    rock.SetupDepthStreams();
 
     // Generate a large list of semi-random model transformation matrices
     // These will be used to displace Rock models in a semi-circle around the Nanosuit model
     GLuint amount = 500;
     glm::mat4* modelMatrices;
     modelMatrices = new glm::mat4[amount];
+    TransformBatch rockTransforms;
     srand(glfwGetTime()); // initialize random seed	
     GLfloat radius = 50.0;
     GLfloat offset = 2.5f;
     for (GLuint i = 0; i < amount; i++)
     {
-        glm::mat4 model;
         // 1. Translation: displace along circle with 'radius' in range [-offset, offset]
         GLfloat angle = (GLfloat)i / (GLfloat)amount * 360.0f;
         GLfloat displacement = (rand() % (GLint)(2 * offset * 100)) / 100.0f - offset;
@@ -236,42 +293,140 @@ int main()
         GLfloat y = displacement * 0.4f; // Keep height of asteroid field smaller compared to width of x and z
         displacement = (rand() % (GLint)(2 * offset * 100)) / 100.0f - offset;
         GLfloat z = cos(angle) * radius + displacement;
-        model = glm::translate(model, glm::vec3(x, y, z));
 
         // 2. Scale: Scale between 0.05 and 0.25f
         GLfloat scale = (rand() % 20) / 100.0f + 0.05;
-        model = glm::scale(model, glm::vec3(scale));
 
         // 3. Rotation: add random rotation around a (semi)randomly picked rotation axis vector
         GLfloat rotAngle = (rand() % 360);
-        model = glm::rotate(model, rotAngle, glm::vec3(0.4f, 0.6f, 0.8f));
 
-        // 4. Now add to list of matrices
-        modelMatrices[i] = model;
+        // 4. Now add to the batch (the scale is uniform so its order relative to the rotation doesn't matter)
+        rockTransforms.Add(glm::vec3(x, y, z), glm::angleAxis(rotAngle, glm::normalize(glm::vec3(0.4f, 0.6f, 0.8f))), glm::vec3(scale));
     }
+    // Build all model matrices at once with the SIMD kernel
+    MatrixKernels::ComposeModelMatrices(rockTransforms, modelMatrices);
 
+    // Bounding sphere radius of the rock mesh (in model space) used for frustum culling and LOD selection
+    GLfloat rockRadius = rock.boundingRadius;
+    std::vector<GLubyte> rockVisible(amount, 1);
+
+    // Switch to the next coarser rock once it covers fewer than 96, 48 or 24 pixels on screen
+    std::vector<GLfloat> lodThresholds;
+    lodThresholds.push_back(96.0f);
+    lodThresholds.push_back(48.0f);
+    lodThresholds.push_back(24.0f);
+    LodSelector rockLods(amount, lodThresholds);
+    std::vector< std::vector<GLuint> > rocksPerLod(rock.LodCount());
+
+    // The reflective shader samples up to 20 textures per fragment; a depth pre-pass makes it run once per pixel
+    DepthPrePass prePass(screenWIDTH, screenHEIGHT);
+
+    // Counts the fragments shaded per pixel while enabled
+    OverdrawView overdraw(screenWIDTH, screenHEIGHT);
+
+    // Draw calls, binds, uploads and frame times of every frame, shown with F6
+    RenderStats stats(screenWIDTH, screenHEIGHT);
+
+    // GPU time of the pre-pass, the models and the skybox; F2 prints it, F3 writes it out as CSV
+    GpuProfiler gpuProfiler;
 
     // Game loop
     while (!glfwWindowShouldClose(window))
     {
+        benchmark.BeginFrame(camera);
+        stats.BeginFrame();
+
         // Set frame time
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        journal.BeginFrame(deltaTime);
 
         // Check and call events
         glfwPollEvents();
         Do_movement();
+        if (run_matrix_benchmark)
+        {
+            MatrixKernels::Benchmark();
+            run_matrix_benchmark = false;
+        }
+        if (run_job_benchmark)
+        {
+            // Report worker utilisation since the last report and run the CPU-only scaling test
+            jobs.PrintStats();
+            jobs.ResetStats();
+            JobSystem::Benchmark();
+            run_job_benchmark = false;
+        }
+
+        gpuProfiler.BeginFrame();
+
+        // Show the overdraw heatmap instead of the frame; its statistics are printed when it's switched off
+        if (toggle_overdraw_view)
+        {
+            if (overdraw.Enabled)
+                overdraw.PrintStats();
+            overdraw.Enabled = !overdraw.Enabled;
+            toggle_overdraw_view = false;
+        }
+        overdraw.Begin();
 
         // Clear the color and depth buffers
         glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Send perspective globals to the model loading Shader program
-        shader.Use();
         glm::mat4 model;
         glm::mat4 view = camera.GetViewMatrix();
         glm::mat4 projection = glm::perspective(camera.Zoom, (float)screenWIDTH / (float)screenHEIGHT, 0.1f, 100.0f);
+
+        // Cull the Rock models on the job system, the GL calls stay on this thread
+        Frustum frustum(projection * view);
+        // and pick the level of detail of every visible rock from its size on screen
+        jobs.ParallelFor(amount, 64, [&](GLuint begin, GLuint end)
+        {
+            for (GLuint i = begin; i < end; i++)
+            {
+                glm::vec3 center(modelMatrices[i][3]);
+                GLfloat scaledRadius = rockRadius * rockTransforms.sx[i];
+                rockVisible[i] = frustum.IntersectsSphere(center, scaledRadius);
+                if (rockVisible[i])
+                    rockLods.Select(i, LodSelector::ProjectedSize(center, scaledRadius, camera.Position, projection, (GLfloat)screenHEIGHT));
+            }
+        });
+
+        // Group the visible rocks per level so each level's buffers are bound for one run of draws
+        for (GLuint lod = 0; lod < rocksPerLod.size(); lod++)
+            rocksPerLod[lod].clear();
+        for (GLuint i = 0; i < amount; i++)
+        {
+            if (rockVisible[i])
+                rocksPerLod[use_rock_lods ? rockLods.Levels[i] : 0].push_back(i);
+        }
+
+        // Optional depth pre-pass: the same geometry from the position-only streams, without any fragment work
+        if (prePass.BeginDepthPass())
+        {
+            gpuProfiler.BeginPass("depth pre-pass");
+            depthShader.Use();
+            GLint depthModelLoc = glGetUniformLocation(depthShader.Program, "model");
+            glUniformMatrix4fv(depthModelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            glUniformMatrix4fv(glGetUniformLocation(depthShader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            glUniformMatrix4fv(glGetUniformLocation(depthShader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            nanosuit.DrawDepth();
+            for (GLuint lod = 0; lod < rocksPerLod.size(); lod++)
+            {
+                for (GLuint j = 0; j < rocksPerLod[lod].size(); j++)
+                {
+                    glUniformMatrix4fv(depthModelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrices[rocksPerLod[lod][j]]));
+                    rock.DrawLodDepth(lod);
+                }
+            }
+            prePass.EndDepthPass();
+            gpuProfiler.EndPass();
+        }
+
+        // Send perspective globals to the model loading Shader program
+        shader.Use();
         glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
@@ -287,16 +442,49 @@ int main()
         else
             glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture_2);
 
+        gpuProfiler.BeginPass("models");
+        prePass.BeginColourPass();
+
         // Draw the Nanosuit model
         nanosuit.Draw(shader);
 
-        // Draw the Rock models
-        for (GLuint i = 0; i < amount; i++)
+        // Draw the visible Rock models
+        GLint modelLoc = glGetUniformLocation(shader.Program, "model");
+        for (GLuint lod = 0; lod < rocksPerLod.size(); lod++)
         {
-            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(modelMatrices[i]));
-            rock.Draw(shader);
+            for (GLuint j = 0; j < rocksPerLod[lod].size(); j++)
+            {
+                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(modelMatrices[rocksPerLod[lod][j]]));
+                rock.DrawLod(shader, lod);
+            }
         }
 
+        prePass.EndColourPass();
+        gpuProfiler.EndPass();
+        if (toggle_depth_pre_pass)
+        {
+            // Report the overdraw measured so far, then switch
+            prePass.PrintStats();
+            prePass.Enabled = !prePass.Enabled;
+            toggle_depth_pre_pass = false;
+        }
+
+        if (keys[GLFW_KEY_0])
+        {
+            // Toggle the rock levels of detail and report how the visible rocks are spread over them
+            use_rock_lods = !use_rock_lods;
+            GLuint triangles = 0;
+            for (GLuint lod = 0; lod < rocksPerLod.size(); lod++)
+            {
+                std::cout << "LOD " << lod << ": " << rock.TriangleCount(lod) << " triangles, " << rocksPerLod[lod].size() << " rocks" << std::endl;
+                triangles += rock.TriangleCount(lod) * (GLuint)rocksPerLod[lod].size();
+            }
+            std::cout << "Rock triangles this frame: " << triangles << " (" << rock.TriangleCount(0) * (amount - (GLuint)std::count(rockVisible.begin(), rockVisible.end(), 0)) << " without LODs)" << std::endl;
+            std::cout << "Rock LODs " << (use_rock_lods ? "enabled" : "disabled") << std::endl;
+            keys[GLFW_KEY_0] = false;
+        }
+
+        gpuProfiler.BeginPass("skybox");
         glEnable(GL_DEPTH_TEST);
         glDepthFunc(GL_LEQUAL);  // Change depth function so depth test passes when values are equal to depth buffer's content
 
@@ -321,11 +509,40 @@ int main()
 
         // Set depth function back to default
         glDepthFunc(GL_LESS);
+        gpuProfiler.EndPass();
+
+        overdraw.End();
+        gpuProfiler.EndFrame();
+
+        if (keys[GLFW_KEY_F2])
+        {
+            gpuProfiler.PrintStats();
+            keys[GLFW_KEY_F2] = false;
+        }
+        if (keys[GLFW_KEY_F3])
+        {
+            if (gpuProfiler.ExportCSV("gpu_passes.csv") && gpuProfiler.ExportSamplesCSV("gpu_samples.csv"))
+                std::cout << "GPU pass timings written to gpu_passes.csv and gpu_samples.csv" << std::endl;
+            keys[GLFW_KEY_F3] = false;
+        }
+
+        if (toggle_stats_overlay)
+        {
+            stats.ShowOverlay = !stats.ShowOverlay;
+            toggle_stats_overlay = false;
+        }
+        stats.EndFrame();
+
+        CPU_PROFILE_FRAME();
 
         // Swap the buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame(window, stats.Counters());
     }
 
+    // Delete the GL objects of the GPU profiler and stats overlay while the context still exists
+    gpuProfiler.Release();
+    stats.Release();
     glfwTerminate();
     return 0;
 }
@@ -397,6 +614,8 @@ GLuint loadTexture(GLchar* path)
 // Moves/alters the camera positions based on user input
 void Do_movement()
 {
+    CPU_PROFILE_ZONE("Do_movement");
+
     // Camera controls
     if (keys[GLFW_KEY_W])
         camera.ProcessKeyboard(FORWARD, deltaTime);
@@ -410,6 +629,11 @@ void Do_movement()
         camera.ProcessKeyboard(DOWN, deltaTime);
     if (keys[GLFW_KEY_SPACE])
         camera.ProcessKeyboard(UP, deltaTime);
+    if (keys[GLFW_KEY_P])
+    {
+        toggle_depth_pre_pass = true;
+        keys[GLFW_KEY_P] = false;
+    }
 }
 
 // Is called whenever a key is pressed/released via GLFW
@@ -418,6 +642,21 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     //cout << key << endl;
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        toggle_overdraw_view = true;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        toggle_stats_overlay = true;
+    if (key == GLFW_KEY_8 && action == GLFW_PRESS)
+        run_matrix_benchmark = true;
+    if (key == GLFW_KEY_9 && action == GLFW_PRESS)
+        run_job_benchmark = true;
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        // Print the last frame's CPU zones and write everything recorded so far as a Chrome trace
+        CpuProfiler::Instance().PrintFrameSummary();
+        if (CpuProfiler::Instance().WriteChromeTrace("cpu_trace.json"))
+            std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+    }
     if (key >= 0 && key < 1024)
     {
         if (action == GLFW_PRESS)
@@ -0,0 +1,20 @@
+#version 330 core
+in vec2 TexCoords;
+out vec2 Moments;
+
+uniform sampler2D image;
+uniform vec2 direction;     // One texel along the blur axis
+
+// 9-tap Gaussian, one side of the kernel
+const float weights[5] = float[](0.2270270270, 0.1945945946, 0.1216216216, 0.0540540541, 0.0162162162);
+
+void main()
+{
+    vec2 result = texture(image, TexCoords).rg * weights[0];
+    for(int i = 1; i < 5; ++i)
+    {
+        result += texture(image, TexCoords + direction * i).rg * weights[i];
+        result += texture(image, TexCoords - direction * i).rg * weights[i];
+    }
+    Moments = result;
+}
@@ -6,10 +6,12 @@ in VS_OUT {
     vec3 Normal;
     vec2 TexCoords;
     vec4 FragPosLightSpace;
+    float ViewDepth;
 } fs_in;
 
 uniform sampler2D diffuseTexture;
 uniform sampler2D depthMap;
+uniform sampler2DShadow shadowMap;  // The same depth texture, read through a sampler with depth comparison enabled
 
 uniform vec3 lightPos;
 uniform vec3 viewPos;
@@ -17,6 +19,41 @@ uniform vec3 viewPos;
 uniform bool hasShadows;
 uniform bool hasShadowBias;
 uniform bool usePCF;
+uniform int pcfMode;                // 0 = manual 3x3, 1 = hardware 2x2, 2 = rotated Poisson disc
+uniform int poissonTaps;            // 4, 8 or 16
+uniform float poissonRadius;        // In shadow-map texels
+
+// Variance / exponential shadow maps
+uniform int shadowMode;             // 0 = depth map, 1 = VSM, 2 = ESM
+uniform sampler2D momentsMap;       // Blurred moments, filtered bilinearly
+uniform float lightBleedReduction;  // VSM: visibility below this fraction is treated as fully shadowed
+uniform float esmExponent;
+
+const vec2 poissonDisk[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725),
+    vec2(-0.09418410, -0.92938870), vec2(0.34495938, 0.29387760),
+    vec2(-0.91588581, 0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543, 0.27676845), vec2(0.97484398, 0.75648379),
+    vec2(0.44323325, -0.97511554), vec2(0.53742981, -0.47373420),
+    vec2(-0.26496911, -0.41893023), vec2(0.79197514, 0.19090188),
+    vec2(-0.24188840, 0.99706507), vec2(-0.81409955, 0.91437590),
+    vec2(0.19984126, 0.78641367), vec2(0.14383161, -0.14100790)
+);
+
+// Cheap per-pixel noise used to rotate the Poisson disc, trading banding for fine grain
+float InterleavedGradientNoise(vec2 position)
+{
+    return fract(52.9829189 * fract(dot(position, vec2(0.06711056, 0.00583715))));
+}
+
+// Cascaded shadow maps
+#define MAX_CASCADES 4
+uniform bool useCascades;
+uniform bool showCascades;
+uniform sampler2DArray cascadeMaps;
+uniform int cascadeCount;
+uniform float cascadeSplits[MAX_CASCADES];
+uniform mat4 cascadeMatrices[MAX_CASCADES];
 
 float ShadowCalculation(vec4 fragPosLightSpace, vec3 lightDir, vec3 normal)
 {
@@ -41,6 +78,24 @@ float ShadowCalculation(vec4 fragPosLightSpace, vec3 lightDir, vec3 normal)
         bias = 0.05;
         shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;
     }
+    else if (hasShadows && hasShadowBias && usePCF && pcfMode == 1)
+    {
+        // One fetch: the hardware compares the four nearest texels and filters the results bilinearly
+        shadow = 1.0 - texture(shadowMap, vec3(projCoords.xy, currentDepth - bias));
+    }
+    else if (hasShadows && hasShadowBias && usePCF && pcfMode == 2)
+    {
+        // Poisson disc rotated per pixel, each tap itself a hardware 2x2 PCF
+        vec2 texelSize = 1.0 / textureSize(depthMap, 0);
+        float angle = 6.28318531 * InterleavedGradientNoise(gl_FragCoord.xy);
+        mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+        for(int i = 0; i < poissonTaps; ++i)
+        {
+            vec2 offset = rotation * poissonDisk[i] * poissonRadius * texelSize;
+            shadow += 1.0 - texture(shadowMap, vec3(projCoords.xy + offset, currentDepth - bias));
+        }
+        shadow /= float(poissonTaps);
+    }
     else if (hasShadows && hasShadowBias && usePCF)
     {
         vec2 texelSize = 1.0 / textureSize(depthMap, 0);
@@ -65,6 +120,80 @@ float ShadowCalculation(vec4 fragPosLightSpace, vec3 lightDir, vec3 normal)
     return shadow;
 }
 
+// Soft shadow from one bilinear fetch of the pre-blurred moments, however wide the blur was
+float MomentShadowCalculation(vec4 fragPosLightSpace)
+{
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w * 0.5 + 0.5;
+    if (projCoords.z > 1.0 || any(lessThan(projCoords.xy, vec2(0.0))) || any(greaterThan(projCoords.xy, vec2(1.0))))
+        return 0.0;
+    float currentDepth = projCoords.z;
+    vec2 moments = texture(momentsMap, projCoords.xy).rg;
+
+    float visibility;
+    if (shadowMode == 2)
+    {
+        // ESM: the stored exp(c * occluder) times exp(-c * receiver) falls off quickly once the receiver is behind
+        visibility = clamp(exp(-esmExponent * currentDepth) * moments.x, 0.0, 1.0);
+    }
+    else
+    {
+        // VSM: Chebyshev's upper bound on the fraction of the filter region that is farther than the receiver
+        if (currentDepth <= moments.x)
+            return 0.0;
+        float variance = max(moments.y - moments.x * moments.x, 0.00002);
+        float d = currentDepth - moments.x;
+        visibility = variance / (variance + d * d);
+        // Light bleeding shows up as low, non-zero visibility; cut it off and rescale the rest
+        visibility = clamp((visibility - lightBleedReduction) / (1.0 - lightBleedReduction), 0.0, 1.0);
+    }
+    return 1.0 - visibility;
+}
+
+int SelectCascade(float viewDepth)
+{
+    for (int i = 0; i < cascadeCount - 1; ++i)
+    {
+        if (viewDepth < cascadeSplits[i])
+            return i;
+    }
+    return cascadeCount - 1;
+}
+
+float CascadeShadowCalculation(vec3 fragPos, float viewDepth, vec3 lightDir, vec3 normal)
+{
+    if (viewDepth > cascadeSplits[cascadeCount - 1])
+        return 0.0;
+    int cascade = SelectCascade(viewDepth);
+    vec4 fragPosLightSpace = cascadeMatrices[cascade] * vec4(fragPos, 1.0);
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w * 0.5 + 0.5;
+    if (projCoords.z > 1.0)
+        return 0.0;
+    float currentDepth = projCoords.z;
+
+    // The cascades cover far less area per texel than the single map, so a much smaller bias will do
+    float bias = hasShadowBias ? max(0.002 * (1.0 - dot(normal, lightDir)), 0.0005) : 0.0;
+    float shadow = 0.0;
+    if (usePCF)
+    {
+        vec2 texelSize = 1.0 / vec2(textureSize(cascadeMaps, 0).xy);
+        for(int x = -1; x <= 1; ++x)
+        {
+            for(int y = -1; y <= 1; ++y)
+            {
+                float pcfDepth = texture(cascadeMaps, vec3(projCoords.xy + vec2(x, y) * texelSize, cascade)).r;
+                shadow += currentDepth - bias > pcfDepth ? 1.0 : 0.0;
+            }
+        }
+        shadow /= 9.0;
+    }
+    else
+    {
+        float closestDepth = texture(cascadeMaps, vec3(projCoords.xy, cascade)).r;
+        shadow = currentDepth - bias > closestDepth ? 1.0 : 0.0;
+    }
+    return shadow;
+}
+
 void main()
 {
     vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
@@ -90,11 +219,23 @@ void main()
     */
 
     // Calculate shadow
-    float shadow = hasShadows ? ShadowCalculation(fs_in.FragPosLightSpace, lightDir, normal) : 0.0;
+    float shadow = 0.0;
+    if (hasShadows && useCascades)
+        shadow = CascadeShadowCalculation(fs_in.FragPos, fs_in.ViewDepth, lightDir, normal);
+    else if (hasShadows && shadowMode != 0)
+        shadow = MomentShadowCalculation(fs_in.FragPosLightSpace);
+    else if (hasShadows)
+        shadow = ShadowCalculation(fs_in.FragPosLightSpace, lightDir, normal);
     shadow = min(shadow, 0.75); // reduce the shadow strenght to allow diffuse and specular light to show in shadowed areas
 
     // Final lighting calculation
     //vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;
     vec3 lighting = (ambient + (1.0 - shadow) * (diffuse)) * color;
+    if (useCascades && showCascades)
+    {
+        // Tint each cascade to see where the splits fall
+        vec3 tints[MAX_CASCADES] = vec3[](vec3(1.0, 0.6, 0.6), vec3(0.6, 1.0, 0.6), vec3(0.6, 0.6, 1.0), vec3(1.0, 1.0, 0.6));
+        lighting *= tints[SelectCascade(fs_in.ViewDepth)];
+    }
     FragColor = vec4(lighting, 1.0f);
 }
\ No newline at end of file
@@ -8,6 +8,7 @@ out VS_OUT {
     vec3 Normal;
     vec2 TexCoords;
     vec4 FragPosLightSpace;
+    float ViewDepth;
 } vs_out;
 
 uniform mat4 projection;
@@ -23,4 +24,5 @@ void main()
     vs_out.Normal = transpose(inverse(mat3(model))) * normal;
     vs_out.TexCoords = texCoords;
     vs_out.FragPosLightSpace = lightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
+    vs_out.ViewDepth = -(view * vec4(vs_out.FragPos, 1.0)).z;
 }
\ No newline at end of file
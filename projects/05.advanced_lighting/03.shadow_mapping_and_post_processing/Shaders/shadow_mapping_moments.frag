@@ -0,0 +1,23 @@
+#version 330 core
+out vec2 Moments;
+
+uniform bool useESM;
+uniform float esmExponent;
+
+void main()
+{
+    float depth = gl_FragCoord.z;
+    if (useESM)
+    {
+        // Exponential shadow map: exp(c * depth), filtered linearly like any colour
+        Moments = vec2(exp(esmExponent * depth), 0.0);
+    }
+    else
+    {
+        // Variance shadow map: depth and depth squared. The derivative term adds the variance of the depth
+        // across the texel, which keeps slanted receivers from shadowing themselves.
+        float dx = dFdx(depth);
+        float dy = dFdy(depth);
+        Moments = vec2(depth, depth * depth + 0.25 * (dx * dx + dy * dy));
+    }
+}
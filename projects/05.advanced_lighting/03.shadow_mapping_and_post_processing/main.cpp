@@ -1,5 +1,9 @@
 #include <iostream>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #include <string.h>
 #include <algorithm>
 #include <cmath>
@@ -20,16 +24,36 @@
 #include <glm/gtc/type_ptr.hpp>
 
 // Other includes
+// The render statistics come first so the GL 1.1 calls made by the other headers are counted as well
+#define LEARN_OPENGL_GL_RECORDER
+#include <learn_opengl/headers/RenderStats.h>
 #include <learn_opengl/headers/Shader.h>
 #include <learn_opengl/headers/Camera.h>
 #include <learn_opengl/headers/Mesh.h>
 #include <learn_opengl/headers/Model.h>
+#include <learn_opengl/headers/Transform.h>
+#include <learn_opengl/headers/StaticBatch.h>
+#include <learn_opengl/headers/ShadowCache.h>
+#include <learn_opengl/headers/CascadedShadowMap.h>
+#include <learn_opengl/headers/OverdrawView.h>
+#include <learn_opengl/headers/CpuProfiler.h>
+#include <learn_opengl/headers/Benchmark.h>
+#include <learn_opengl/headers/InputJournal.h>
+#include <learn_opengl/headers/GpuProfiler.h>
+#include <learn_opengl/headers/RenderGraph.h>
+#include <learn_opengl/headers/PostProcessChain.h>
 
 
 std::string current_working_directory()
 {
+#ifdef _WIN32
     char working_directory[MAX_PATH + 1];
     GetCurrentDirectoryA(sizeof(working_directory), working_directory);
+#else
+    char working_directory[4096];
+    if (!getcwd(working_directory, sizeof(working_directory)))
+        working_directory[0] = '\0';
+#endif
     return working_directory;
 }
 
@@ -42,18 +66,29 @@ void Do_Movement();
 GLuint loadTexture(const GLchar* path, GLboolean alpha = false);
 
 //GLuint loadTexture(const GLchar* path);
-void RenderScene(Shader &shader);
-void RenderCube();
+void RenderScene(Shader &shader, bool depthOnly = false);
+void RenderCasters(Shader &shader, const Frustum& frustum);
+void RenderCube(bool positionsOnly = false);
 void RenderQuad();
 
 // Window dimensions
 const GLuint SCR_WIDTH = 800, SCR_HEIGHT = 600;
 
+// Overdraw heatmap, toggled with F1
+bool toggleOverdrawView = false;
+
+// Render statistics overlay, toggled with F6
+bool toggleStatsOverlay = false;
+
+// Render graph passes and texture pool, printed with F7
+bool printRenderGraph = false;
+
 // Camera
 Camera  camera(glm::vec3(0.0f, 0.0f, 5.0f));
 GLfloat lastX = 400;
 GLfloat lastY = 300;
 bool    keys[1024];
+bool    keysPressed[1024];
 
 // Deltatime
 GLfloat deltaTime = 0.0f;	// Time between current frame and last frame
@@ -62,13 +97,59 @@ GLfloat lastFrame = 0.0f;  	// Time of last frame
 // Global variables
 GLuint woodTexture;
 GLuint planeVAO;
+GLuint planeDepthVAO;           // Position-only copy of the floor for the depth passes
 bool firstMouse = true;
 
+// Scene transforms (the floor is the root, the cubes hang below it)
+TransformHierarchy sceneTransforms;
+GLuint floorNode;
+GLuint cubeNodes[3];
+
+// The floor and cubes never move on their own, so both passes draw them from one pre-transformed batch
+extern GLfloat cubeVertices[36 * 8];
+StaticBatch sceneBatch;
+GLboolean useStaticBatching = true;
+bool toggleStaticBatching = false;      // Set by B: report the draw calls and switch
+
+// Shadow casters as tracked by the shadow cache: their node and local bounds, and their world matrix when the map was drawn
+const GLuint CASTER_COUNT = 4;
+GLuint casterNodes[CASTER_COUNT];
+glm::vec3 casterMin[CASTER_COUNT];
+glm::vec3 casterMax[CASTER_COUNT];
+glm::mat4 casterWorld[CASTER_COUNT];
+GLboolean animateCaster = false;
+void CasterWorldBounds(GLuint caster, glm::vec3& boundsMin, glm::vec3& boundsMax);
+
+// Cascaded shadow maps
+GLboolean useCascades = false;
+GLboolean showCascades = false;
+
 // Options
 GLboolean hasShadows = false;
 GLboolean hasShadowBias = false;
 GLboolean usePCF = false;
 
+// PCF filters: manual 3x3 compares, one hardware-compared 2x2 fetch, or a rotated Poisson disc of hardware fetches
+enum pcfFilter {
+    PCF_MANUAL_3X3,
+    PCF_HARDWARE_2X2,
+    PCF_POISSON
+};
+const GLchar* pcfFilterNames[] = { "manual 3x3", "hardware 2x2", "Poisson" };
+pcfFilter pcfMode = PCF_MANUAL_3X3;
+GLint poissonTaps = 8;
+
+// Shadow map formats: plain depth (filtered with PCF) or pre-blurred moments for variance / exponential shadow maps
+enum shadowFormat {
+    SHADOW_DEPTH,
+    SHADOW_VSM,
+    SHADOW_ESM
+};
+const GLchar* shadowModeNames[] = { "depth", "VSM", "ESM" };
+shadowFormat shadowMode = SHADOW_DEPTH;
+GLfloat lightBleedReduction = 0.2f;
+GLfloat esmExponent = 80.0f;    // exp(80) is about as far as a 32-bit float goes
+
 enum filteringMode {
     DEFAULT,
     INVERT,
@@ -82,11 +163,17 @@ enum filteringMode {
 
 filteringMode filtering_mode = DEFAULT;
 
-void configure_filtering_mode();
+void configure_filtering_mode(PostProcessChain& chain);
 
 // The MAIN function, from here we start the application and run the game loop
-int main()
+int main(int argc, char* argv[])
 {
+    // --benchmark renders a scripted run in a hidden window and writes the frame timings as JSON
+    Benchmark benchmark(argc, argv, "05.advanced_lighting/03.shadow_mapping_and_post_processing");
+    // --record=file.bin journals the input, --replay=file.bin plays it back for an exactly repeatable run
+    InputJournal journal(argc, argv);
+    benchmark.ScriptedCamera = !journal.Replaying();
+
     // Init GLFW
     glfwInit();
 
@@ -95,6 +182,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+    benchmark.WindowHints();
 
     // Create a GLFWwindow object that we can use for GLFW's functions
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Shadow Mapping", nullptr, nullptr);
@@ -104,6 +192,7 @@ int main()
     glfwSetKeyCallback(window, key_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    journal.Attach(window);
 
     // GLFW Options
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -132,40 +221,28 @@ int main()
     std::string shadow_mapping_depth_frag_path = cwd + "/Shaders/shadow_mapping_depth.frag";
     Shader simpleDepthShader(shadow_mapping_depth_vs_path.c_str(), shadow_mapping_depth_frag_path.c_str());
 
+    std::string shadow_mapping_moments_frag_path = cwd + "/Shaders/shadow_mapping_moments.frag";
+    Shader momentsShader(shadow_mapping_depth_vs_path.c_str(), shadow_mapping_moments_frag_path.c_str());
+
     // Post-Processing shaders
     std::string advanced_shader_vs_path = cwd + "/Shaders/post-processing/advanced.vs";
     std::string advanced_shader_frag_path = cwd + "/Shaders/post-processing/advanced.frag";
     Shader advanced_shader(advanced_shader_vs_path.c_str(), advanced_shader_frag_path.c_str());
 
     std::string no_filter_shader_vs_path = cwd + "/Shaders/post-processing/no_filter.vs";
-    std::string no_filter_shader_frag_path = cwd + "/Shaders/post-processing/no_filter.frag";
-    Shader no_filter_shader(no_filter_shader_vs_path.c_str(), no_filter_shader_frag_path.c_str());
-
-    std::string invert_shader_frag_path = cwd + "/Shaders/post-processing/invert.frag";
-    Shader invert_filter_shader(no_filter_shader_vs_path.c_str(), invert_shader_frag_path.c_str());
+    std::string moments_blur_frag_path = cwd + "/Shaders/moments_blur.frag";
+    Shader momentsBlurShader(no_filter_shader_vs_path.c_str(), moments_blur_frag_path.c_str());
 
-    std::string grayscale_shader_frag_path = cwd + "/Shaders/post-processing/grayscale.frag";
-    Shader grayscale_filter_shader(no_filter_shader_vs_path.c_str(), grayscale_shader_frag_path.c_str());
-
-    std::string kernel_sharpen_shader_frag_path = cwd + "/Shaders/post-processing/kernel_sharpen.frag";
-    Shader kernel_sharpen_filter_shader(no_filter_shader_vs_path.c_str(), kernel_sharpen_shader_frag_path.c_str());
-
-    std::string kernel_blur_shader_frag_path = cwd + "/Shaders/post-processing/kernel_blur.frag";
-    Shader kernel_blur_filter_shader(no_filter_shader_vs_path.c_str(), kernel_blur_shader_frag_path.c_str());
-
-    std::string kernel_edge_detection_shader_frag_path = cwd + "/Shaders/post-processing/kernel_edge_detection.frag";
-    Shader kernel_edge_detection_filter_shader(no_filter_shader_vs_path.c_str(), kernel_edge_detection_shader_frag_path.c_str());
-
-    std::string kernel_emboss_shader_frag_path = cwd + "/Shaders/post-processing/kernel_emboss.frag";
-    Shader kernel_emboss_filter_shader(no_filter_shader_vs_path.c_str(), kernel_emboss_shader_frag_path.c_str());
-
-    std::string kernel_top_sobel_shader_frag_path = cwd + "/Shaders/post-processing/kernel_top_sobel.frag";
-    Shader kernel_top_sobel_filter_shader(no_filter_shader_vs_path.c_str(), kernel_top_sobel_shader_frag_path.c_str());
+    // The post-processing effect, generated by the chain
+    PostProcessChain chain;
 
     // Set texture samples
     shader.Use();
     glUniform1i(glGetUniformLocation(shader.Program, "diffuseTexture"), 0);
     glUniform1i(glGetUniformLocation(shader.Program, "depthMap"), 1);
+    glUniform1i(glGetUniformLocation(shader.Program, "shadowMap"), 3);
+    glUniform1f(glGetUniformLocation(shader.Program, "poissonRadius"), 2.0f);
+    glUniform1i(glGetUniformLocation(shader.Program, "momentsMap"), 4);
 
     GLfloat planeVertices[] = {
         // Positions          // Normals         // Texture Coords
@@ -217,6 +294,36 @@ int main()
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
     glBindVertexArray(0);
 
+    // The depth passes only read positions, so give them a tightly packed stream of just those
+    GLfloat planePositions[6 * 3];
+    for (GLuint i = 0; i < 6; i++)
+        std::copy(planeVertices + i * 8, planeVertices + i * 8 + 3, planePositions + i * 3);
+    GLuint planeDepthVBO;
+    glGenVertexArrays(1, &planeDepthVAO);
+    glGenBuffers(1, &planeDepthVBO);
+    glBindVertexArray(planeDepthVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, planeDepthVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(planePositions), &planePositions, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+    glBindVertexArray(0);
+
+    // Scene transforms; world matrices are only rebuilt when a node is moved
+    floorNode = sceneTransforms.AddNode(-1);
+    cubeNodes[0] = sceneTransforms.AddNode(floorNode, glm::vec3(0.0f, 1.5f, 0.0f));
+    cubeNodes[1] = sceneTransforms.AddNode(floorNode, glm::vec3(2.0f, 0.0f, 1.0f));
+    cubeNodes[2] = sceneTransforms.AddNode(floorNode, glm::vec3(-1.0f, 0.0f, 2.0f),
+        glm::angleAxis(60.0f, glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f))), glm::vec3(0.5f));
+    casterNodes[0] = floorNode;
+    casterMin[0] = glm::vec3(-25.0f, -0.5f, -25.0f);
+    casterMax[0] = glm::vec3(25.0f, -0.5f, 25.0f);
+    for (GLuint i = 0; i < 3; i++)
+    {
+        casterNodes[i + 1] = cubeNodes[i];
+        casterMin[i + 1] = glm::vec3(-0.5f);
+        casterMax[i + 1] = glm::vec3(0.5f);
+    }
+
     // Light source
     glm::vec3 lightPos(-2.0f, 4.0f, -1.0f);
 
@@ -225,48 +332,10 @@ int main()
     const GLchar* floor_path_char = floor_path.c_str();
     woodTexture = loadTexture(floor_path_char);
 
-    // Framebuffers
-    GLuint framebuffer;
-    glGenFramebuffers(1, &framebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-
-    // Create a color attachment texture
-    //
-    // Generate texture ID and load texture data 
-    GLuint textureColorbuffer;
-    glGenTextures(1, &textureColorbuffer);
-    glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0);
-
-    // Create a renderbuffer object for depth and stencil attachment (we won't be sampling these)
-    GLuint rbo;
-    glGenRenderbuffers(1, &rbo);
-    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT); // Use a single renderbuffer object for both a depth AND stencil buffer.
-    glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rbo); // Now actually attach it
-
-    // Now that we actually created the framebuffer and added all attachments we want to check if it is actually complete now
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
-        cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << endl;
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // Draw as wireframe
-    //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-    // Configure depth map FBO
+    // Configure depth map
     const GLuint SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
     //const GLuint SHADOW_WIDTH = 4000, SHADOW_HEIGHT = 4000;
 
-    GLuint depthMapFBO;
-    glGenFramebuffers(1, &depthMapFBO);
     // - Create depth texture
     GLuint depthMap;
     glGenTextures(1, &depthMap);
@@ -283,29 +352,115 @@ int main()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
     GLfloat borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
     glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // A second way to read the depth map: a sampler object with depth comparison and linear filtering, so one
+    // sampler2DShadow fetch returns the filtered result of comparing the four nearest texels (2x2 PCF).
+    // Unit 1 keeps reading raw depths for the manual filter.
+    GLuint compareSampler;
+    glGenSamplers(1, &compareSampler);
+    glSamplerParameteri(compareSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glSamplerParameteri(compareSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glSamplerParameteri(compareSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glSamplerParameteri(compareSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glSamplerParameterfv(compareSampler, GL_TEXTURE_BORDER_COLOR, borderColor);
+    glSamplerParameteri(compareSampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glSamplerParameteri(compareSampler, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindSampler(3, compareSampler);
+
+    // Variance and exponential shadow maps keep moments of the depth in a colour target, which (unlike depth) can be
+    // filtered before it is compared. The raw moments are blurred once per update with a separable Gaussian into
+    // the map the lit pass reads, so a soft shadow costs one bilinear fetch per fragment whatever the blur width.
+    // Both outlive the frame for the shadow cache; the horizontally blurred moments in between are transient.
+    GLuint momentsTextures[2];      // Raw moments, fully blurred
+    glGenTextures(2, momentsTextures);
+    for (GLuint i = 0; i < 2; i++)
+    {
+        glBindTexture(GL_TEXTURE_2D, momentsTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_RG, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    RenderGraph::TextureDesc momentsDesc(SHADOW_WIDTH, SHADOW_HEIGHT, GL_RG32F, GL_LINEAR, GL_CLAMP_TO_EDGE);
+
+    // The frame's passes: shadow map, moments blur, lit scene and post-processing. The graph creates the framebuffers
+    // and the transient targets (scene colour and depth, moments depth and intermediate blur), sharing and freeing
+    // them as the passes in use change.
+    RenderGraph graph;
+
+    // GPU time of the shadow, lit and post-processing passes. The lit pass is recorded under the shadow filter in
+    // use, so switching filters compares their cost.
+    GpuProfiler gpuProfiler;
 
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // The light and the scene are static, so the depth map is only redrawn when one of them changes
+    ShadowCache shadowCache(SHADOW_WIDTH, SHADOW_HEIGHT);
+
+    // Four 512x512 cascades take the same memory as the single 1024x1024 map. Texel snapping keeps a cascade's
+    // matrix unchanged while the camera stands still, so each cascade can be cached just like the single map.
+    CascadedShadowMap cascades(4, 512);
+    std::vector<ShadowCache> cascadeCaches(cascades.CascadeCount, ShadowCache(cascades.Resolution, cascades.Resolution));
+    shader.Use();
+    glUniform1i(glGetUniformLocation(shader.Program, "cascadeMaps"), 2);
 
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
+    // Counts the fragments shaded per pixel while enabled
+    OverdrawView overdraw(SCR_WIDTH, SCR_HEIGHT);
+
+    // Draw calls, binds, uploads and frame times of every frame, shown with F6
+    RenderStats stats(SCR_WIDTH, SCR_HEIGHT);
+
     // Game loop
     while (!glfwWindowShouldClose(window))
     {  
+        benchmark.BeginFrame(camera);
+        stats.BeginFrame();
+
         // Set frame time
         GLfloat currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        journal.BeginFrame(deltaTime);
 
         // Check and call events
         glfwPollEvents();
         Do_Movement();
 
+        gpuProfiler.BeginFrame();
+
         glEnable(GL_DEPTH_TEST);
 
+        // Bob the first cube up and down when requested, to give the shadow cache a moving caster
+        if (animateCaster)
+            sceneTransforms.SetLocalPosition(cubeNodes[0], glm::vec3(0.0f, 1.5f + 0.5f * sin(currentFrame), 0.0f));
+
+        // Refresh world matrices of anything that moved since the last frame and re-bake the batch when they did
+        if (sceneTransforms.UpdateWorldMatrices() > 0)
+        {
+            // The shadow map is stale wherever a caster was and wherever it is now
+            for (GLuint i = 0; i < CASTER_COUNT; i++)
+            {
+                const glm::mat4& world = sceneTransforms.GetWorldMatrix(casterNodes[i]);
+                if (world == casterWorld[i])
+                    continue;
+                shadowCache.InvalidateBox(casterMin[i], casterMax[i], casterWorld[i]);
+                shadowCache.InvalidateBox(casterMin[i], casterMax[i], world);
+                for (GLuint j = 0; j < cascadeCaches.size(); j++)
+                {
+                    cascadeCaches[j].InvalidateBox(casterMin[i], casterMax[i], casterWorld[i]);
+                    cascadeCaches[j].InvalidateBox(casterMin[i], casterMax[i], world);
+                }
+                casterWorld[i] = world;
+            }
+            sceneBatch.Add(woodTexture, planeVertices, 6, sceneTransforms.GetWorldMatrix(floorNode));
+            for (GLuint i = 0; i < 3; i++)
+                sceneBatch.Add(woodTexture, cubeVertices, 36, sceneTransforms.GetWorldMatrix(cubeNodes[i]));
+            sceneBatch.Build();
+        }
+
         // Change light position over time
         //lightPos.x = sin(glfwGetTime()) * 3.0f;
         //lightPos.z = cos(glfwGetTime()) * 2.0f;
@@ -328,128 +483,365 @@ int main()
         //    light-sources point-of-view.
         lightSpaceMatrix = lightProjection * lightView;
 
-        // Use shader that will render the scene from the light-source's point-of-view
-        simpleDepthShader.Use();
+        glm::mat4 projection = glm::perspective(camera.Zoom, (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        glm::mat4 view = camera.GetViewMatrix();
+
+        if (useCascades)
+        {
+            // Fit the cascades to the current view, bounded by the casters' world bounds
+            glm::vec3 sceneMin(1e30f), sceneMax(-1e30f);
+            for (GLuint i = 0; i < CASTER_COUNT; i++)
+            {
+                glm::vec3 boundsMin, boundsMax;
+                CasterWorldBounds(i, boundsMin, boundsMax);
+                sceneMin = glm::min(sceneMin, boundsMin);
+                sceneMax = glm::max(sceneMax, boundsMax);
+            }
+            cascades.Update(view, projection, 0.1f, 100.0f, glm::normalize(-lightPos), sceneMin, sceneMax);
+
+            // Render each stale cascade with only the casters inside its light frustum
+            simpleDepthShader.Use();
+            for (GLuint i = 0; i < cascades.CascadeCount; i++)
+            {
+                if (!cascadeCaches[i].Update(cascades.LightSpaceMatrices[i]))
+                    continue;
+                glUniformMatrix4fv(glGetUniformLocation(simpleDepthShader.Program, "lightSpaceMatrix"), 1, GL_FALSE, glm::value_ptr(cascades.LightSpaceMatrices[i]));
+                gpuProfiler.BeginPass("shadow cascade");
+                cascades.BindCascade(i);
+                cascadeCaches[i].BeginPass();
+                glClear(GL_DEPTH_BUFFER_BIT);
+                RenderCasters(simpleDepthShader, cascades.LightFrustums[i]);
+                cascadeCaches[i].EndPass();
+                gpuProfiler.EndPass();
+            }
+        }
 
-        // Pass our transformation matrix to the shader
-        glUniformMatrix4fv(
-            glGetUniformLocation(simpleDepthShader.Program, "lightSpaceMatrix"),
-            1,
-            GL_FALSE,
-            glm::value_ptr(lightSpaceMatrix));
+        // Only redraw the depth map when the cache says it's stale, and then only the stale part
+        bool updateShadowMap = !useCascades && shadowCache.Update(lightSpaceMatrix);
 
-        // Create a viewport with dimesions equal to the buffer-size we want
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+        // Shadow cache options and statistics
+        if (keys[GLFW_KEY_C] && !keysPressed[GLFW_KEY_C])
+        {
+            shadowCache.PrintStats();
+            shadowCache.ResetStats();
+            shadowCache.Enabled = !shadowCache.Enabled;
+            for (GLuint i = 0; i < cascadeCaches.size(); i++)
+            {
+                cout << "Cascade " << i << " (up to " << cascades.SplitDepths[i] << "): ";
+                cascadeCaches[i].PrintStats();
+                cascadeCaches[i].ResetStats();
+                cascadeCaches[i].Enabled = shadowCache.Enabled;
+            }
+            cout << "Shadow cache " << (shadowCache.Enabled ? "enabled" : "disabled") << endl;
+            keysPressed[GLFW_KEY_C] = true;
+        }
+        if (keys[GLFW_KEY_X] && !keysPressed[GLFW_KEY_X])
+        {
+            shadowCache.UseDirtyRegions = !shadowCache.UseDirtyRegions;
+            for (GLuint i = 0; i < cascadeCaches.size(); i++)
+                cascadeCaches[i].UseDirtyRegions = shadowCache.UseDirtyRegions;
+            cout << "Shadow dirty regions " << (shadowCache.UseDirtyRegions ? "enabled" : "disabled") << endl;
+            keysPressed[GLFW_KEY_X] = true;
+        }
 
-        // Bind a buffer in memory that will be filled with depth values
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        RenderScene(simpleDepthShader);
+        // Shadow map format and the moment filters' controls; each changes what the cached map holds
+        if (keys[GLFW_KEY_G] && !keysPressed[GLFW_KEY_G])
+        {
+            shadowMode = (shadowFormat)((shadowMode + 1) % 3);
+            shadowCache.InvalidateAll();
+            cout << "Shadow map: " << shadowModeNames[shadowMode] << endl;
+            keysPressed[GLFW_KEY_G] = true;
+        }
+        if (keys[GLFW_KEY_U] && !keysPressed[GLFW_KEY_U])
+        {
+            lightBleedReduction = lightBleedReduction >= 0.6f ? 0.0f : lightBleedReduction + 0.2f;
+            cout << "VSM light bleeding reduction: " << lightBleedReduction << endl;
+            keysPressed[GLFW_KEY_U] = true;
+        }
+        if (keys[GLFW_KEY_Y] && !keysPressed[GLFW_KEY_Y])
+        {
+            esmExponent = esmExponent >= 80.0f ? 20.0f : esmExponent + 20.0f;
+            shadowCache.InvalidateAll();
+            cout << "ESM exponent: " << esmExponent << endl;
+            keysPressed[GLFW_KEY_Y] = true;
+        }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        // PCF filter selection and timings
+        if (keys[GLFW_KEY_M] && !keysPressed[GLFW_KEY_M])
+        {
+            pcfMode = (pcfFilter)((pcfMode + 1) % 3);
+            cout << "PCF filter: " << pcfFilterNames[pcfMode] << endl;
+            keysPressed[GLFW_KEY_M] = true;
+        }
+        if (keys[GLFW_KEY_T] && !keysPressed[GLFW_KEY_T])
+        {
+            poissonTaps = poissonTaps == 16 ? 4 : poissonTaps * 2;
+            cout << "Poisson taps: " << poissonTaps << endl;
+            keysPressed[GLFW_KEY_T] = true;
+        }
+        if (keys[GLFW_KEY_H] && !keysPressed[GLFW_KEY_H])
+        {
+            gpuProfiler.PrintStats();
+            keysPressed[GLFW_KEY_H] = true;
+        }
+        if (keys[GLFW_KEY_F3] && !keysPressed[GLFW_KEY_F3])
+        {
+            if (gpuProfiler.ExportCSV("gpu_passes.csv") && gpuProfiler.ExportSamplesCSV("gpu_samples.csv"))
+                cout << "GPU pass timings written to gpu_passes.csv and gpu_samples.csv" << endl;
+            keysPressed[GLFW_KEY_F3] = true;
+        }
 
-        // Clear all attached buffers
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        // Show the overdraw heatmap instead of the frame; its statistics are printed when it's switched off
+        if (toggleOverdrawView)
+        {
+            if (overdraw.Enabled)
+                overdraw.PrintStats();
+            overdraw.Enabled = !overdraw.Enabled;
+            toggleOverdrawView = false;
+        }
 
-        // 2. Render scene as normal 
-        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_DEPTH_TEST);
+        RenderGraph::Resource backbuffer = graph.ImportBackbuffer(SCR_WIDTH, SCR_HEIGHT);
+        RenderGraph::Resource shadowMap = graph.ImportTexture("shadow map", depthMap,
+            RenderGraph::TextureDesc(SHADOW_WIDTH, SHADOW_HEIGHT, GL_DEPTH_COMPONENT, GL_NEAREST, GL_CLAMP_TO_BORDER));
+        RenderGraph::Resource rawMoments = graph.ImportTexture("raw moments", momentsTextures[0], momentsDesc);
+        RenderGraph::Resource blurredMoments = graph.ImportTexture("blurred moments", momentsTextures[1], momentsDesc);
+        RenderGraph::Resource horizontalMoments, sceneColor;
 
-        shader.Use();
-        glm::mat4 projection = glm::perspective(camera.Zoom, (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        // Set light uniforms
-        glUniform3fv(glGetUniformLocation(shader.Program, "lightPos"), 1, &lightPos[0]);
-        glUniform3fv(glGetUniformLocation(shader.Program, "viewPos"), 1, &camera.Position[0]);
-        glUniformMatrix4fv(glGetUniformLocation(shader.Program, "lightSpaceMatrix"),
-            1,
-            GL_FALSE,
-            glm::value_ptr(lightSpaceMatrix));
-        glUniform1i(glGetUniformLocation(shader.Program, "hasShadows"), hasShadows);
-        glUniform1i(glGetUniformLocation(shader.Program, "hasShadowBias"), hasShadowBias);
-        glUniform1i(glGetUniformLocation(shader.Program, "usePCF"), usePCF);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, depthMap);
-        RenderScene(shader);
+        if (updateShadowMap)
+        {
+            graph.AddPass(shadowMode == SHADOW_DEPTH ? "shadow depth" : "shadow moments", [&](RenderGraph::Builder& builder)
+            {
+                // Depth into the shadow map, or moments with a depth buffer of their own
+                if (shadowMode == SHADOW_DEPTH)
+                    builder.Write(shadowMap);
+                else
+                {
+                    builder.Write(rawMoments);
+                    builder.Create("moments depth", RenderGraph::TextureDesc(SHADOW_WIDTH, SHADOW_HEIGHT, GL_DEPTH_COMPONENT24, GL_NEAREST));
+                }
+            }, [&]()
+            {
+                // Use shader that will render the scene from the light-source's point-of-view
+                Shader& depthShader = shadowMode == SHADOW_DEPTH ? simpleDepthShader : momentsShader;
+                depthShader.Use();
+
+                // Pass our transformation matrix to the shader
+                glUniformMatrix4fv(
+                    glGetUniformLocation(depthShader.Program, "lightSpaceMatrix"),
+                    1,
+                    GL_FALSE,
+                    glm::value_ptr(lightSpaceMatrix));
+
+                gpuProfiler.BeginPass(shadowMode == SHADOW_DEPTH ? "shadow depth" : "shadow moments");
+                shadowCache.BeginPass();
+                if (shadowMode != SHADOW_DEPTH)
+                {
+                    glUniform1i(glGetUniformLocation(depthShader.Program, "useESM"), shadowMode == SHADOW_ESM);
+                    glUniform1f(glGetUniformLocation(depthShader.Program, "esmExponent"), esmExponent);
+                    // Texels nothing is drawn into hold the moments of the far plane
+                    GLfloat farMoments[] = { shadowMode == SHADOW_ESM ? (GLfloat)exp(esmExponent) : 1.0f, 1.0f, 0.0f, 0.0f };
+                    glClearBufferfv(GL_COLOR, 0, farMoments);
+                }
+                glClear(GL_DEPTH_BUFFER_BIT);
+                RenderScene(depthShader, true);
+                shadowCache.EndPass();
+                gpuProfiler.EndPass();
+            });
+
+            if (shadowMode != SHADOW_DEPTH)
+            {
+                // Separable Gaussian: raw -> horizontal -> vertical. The whole map is blurred from the raw moments,
+                // so a partial update never blurs already blurred texels a second time.
+                auto blurMoments = [&](RenderGraph::Resource source, bool horizontal)
+                {
+                    gpuProfiler.BeginPass(horizontal ? "moments blur horizontal" : "moments blur vertical");
+                    glDisable(GL_DEPTH_TEST);
+                    momentsBlurShader.Use();
+                    glActiveTexture(GL_TEXTURE0);
+                    glBindTexture(GL_TEXTURE_2D, graph.Texture(source));
+                    glUniform2f(glGetUniformLocation(momentsBlurShader.Program, "direction"),
+                        horizontal ? 1.0f / SHADOW_WIDTH : 0.0f, horizontal ? 0.0f : 1.0f / SHADOW_HEIGHT);
+                    glBindVertexArray(quadVAO);
+                    glDrawArrays(GL_TRIANGLES, 0, 6);
+                    glBindVertexArray(0);
+                    glEnable(GL_DEPTH_TEST);
+                    gpuProfiler.EndPass();
+                };
+                graph.AddPass("moments blur horizontal", [&](RenderGraph::Builder& builder)
+                {
+                    builder.Read(rawMoments);
+                    horizontalMoments = builder.Create("horizontally blurred moments", momentsDesc);
+                }, [=]() { blurMoments(rawMoments, true); });
+                graph.AddPass("moments blur vertical", [&](RenderGraph::Builder& builder)
+                {
+                    builder.Read(horizontalMoments);
+                    builder.Write(blurredMoments);
+                }, [=]() { blurMoments(horizontalMoments, false); });
+            }
+        }
+
+        // Name the lit pass after the shadow filter it runs
+        std::string litPass = "lit, ";
+        if (!hasShadows)
+            litPass += "no shadows";
+        else if (useCascades)
+            litPass += "cascades";
+        else if (shadowMode != SHADOW_DEPTH)
+            litPass += shadowModeNames[shadowMode];
+        else if (hasShadowBias && usePCF)
+            litPass += pcfMode == PCF_POISSON ? "Poisson " + std::to_string(poissonTaps) + " taps" : pcfFilterNames[pcfMode];
+        else
+            litPass += "unfiltered";
+
+        // 2. Render scene as normal 
+        graph.AddPass("lit", [&](RenderGraph::Builder& builder)
+        {
+            builder.Read(shadowMap);
+            builder.Read(blurredMoments);
+            sceneColor = builder.Create("scene color", RenderGraph::TextureDesc(SCR_WIDTH, SCR_HEIGHT, GL_RGB8));
+            builder.Create("scene depth", RenderGraph::TextureDesc(SCR_WIDTH, SCR_HEIGHT, GL_DEPTH24_STENCIL8));
+        }, [&]()
+        {
+            overdraw.Begin();
+
+            // Clear all attached buffers
+            glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            glEnable(GL_DEPTH_TEST);
+
+            shader.Use();
+            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+            // Set light uniforms
+            glUniform3fv(glGetUniformLocation(shader.Program, "lightPos"), 1, &lightPos[0]);
+            glUniform3fv(glGetUniformLocation(shader.Program, "viewPos"), 1, &camera.Position[0]);
+            glUniformMatrix4fv(glGetUniformLocation(shader.Program, "lightSpaceMatrix"),
+                1,
+                GL_FALSE,
+                glm::value_ptr(lightSpaceMatrix));
+            glUniform1i(glGetUniformLocation(shader.Program, "hasShadows"), hasShadows);
+            glUniform1i(glGetUniformLocation(shader.Program, "hasShadowBias"), hasShadowBias);
+            glUniform1i(glGetUniformLocation(shader.Program, "usePCF"), usePCF);
+            glUniform1i(glGetUniformLocation(shader.Program, "useCascades"), useCascades);
+            glUniform1i(glGetUniformLocation(shader.Program, "showCascades"), showCascades);
+            cascades.SetUniforms(shader.Program);
+
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, woodTexture);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, depthMap);
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, cascades.DepthMaps);
+            glActiveTexture(GL_TEXTURE3);
+            glBindTexture(GL_TEXTURE_2D, depthMap);
+            glActiveTexture(GL_TEXTURE4);
+            glBindTexture(GL_TEXTURE_2D, momentsTextures[1]);
+            glUniform1i(glGetUniformLocation(shader.Program, "pcfMode"), pcfMode);
+            glUniform1i(glGetUniformLocation(shader.Program, "shadowMode"), shadowMode);
+            glUniform1f(glGetUniformLocation(shader.Program, "lightBleedReduction"), lightBleedReduction);
+            glUniform1f(glGetUniformLocation(shader.Program, "esmExponent"), esmExponent);
+            glUniform1i(glGetUniformLocation(shader.Program, "poissonTaps"), poissonTaps);
+
+            gpuProfiler.BeginPass(litPass);
+            RenderScene(shader);
+            gpuProfiler.EndPass();
+
+            overdraw.End();
+        });
 
         /////////////////////////////////////////////////////
-        // Bind to default framebuffer again and draw the 
-        // quad plane with attched screen texture.
+        // Post-process the scene's color texture into the
+        // default framebuffer.
         // //////////////////////////////////////////////////
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        // Clear all relevant buffers
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f); // Set clear color to white (not really necessery actually, since we won't be able to see behind the quad anyways)
-        glClear(GL_COLOR_BUFFER_BIT);
-        glDisable(GL_DEPTH_TEST); // We don't care about depth information when rendering a single quad
-
-        // Configure the filtering mode and use the corresponding shader
-        configure_filtering_mode();
-        if (filtering_mode == DEFAULT)
-            no_filter_shader.Use();
-        else if (filtering_mode == INVERT)
-            invert_filter_shader.Use();
-        else if (filtering_mode == GRAYSCALE)
-            grayscale_filter_shader.Use();
-        else if (filtering_mode == KERNEL_SHARPEN)
-            kernel_sharpen_filter_shader.Use();
-        else if (filtering_mode == KERNEL_BLUR)
-            kernel_blur_filter_shader.Use();
-        else if (filtering_mode == KERNEL_EDGE_DETECTION)
-            kernel_edge_detection_filter_shader.Use();
-        else if (filtering_mode == KERNEL_EMBOSS)
-            kernel_emboss_filter_shader.Use();
-        else if (filtering_mode == KERNEL_TOP_SOBEL)
-            kernel_top_sobel_filter_shader.Use();
-        else
-            no_filter_shader.Use();
+        configure_filtering_mode(chain);
+        // The chain adds a pass per stage; the profiler times them together between these two
+        graph.AddPass("post-process timer start", [&](RenderGraph::Builder& builder)
+        {
+            builder.Read(sceneColor);
+            builder.SideEffect();
+        }, [&]()
+        {
+            gpuProfiler.BeginPass("post-process");
+        });
+        chain.AddPasses(graph, sceneColor, backbuffer);
+        graph.AddPass("post-process timer end", [&](RenderGraph::Builder& builder)
+        {
+            builder.Read(backbuffer);
+            builder.SideEffect();
+        }, [&]()
+        {
+            gpuProfiler.EndPass();
+        });
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindVertexArray(quadVAO);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);	// Use the color attachment texture as the texture of the quad plane
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        glBindVertexArray(0);
+        graph.Execute();
+        if (printRenderGraph)
+        {
+            graph.PrintStats();
+            printRenderGraph = false;
+        }
+        gpuProfiler.EndFrame();
+
+        if (toggleStatsOverlay)
+        {
+            stats.ShowOverlay = !stats.ShowOverlay;
+            toggleStatsOverlay = false;
+        }
+
+        // Report the last frame's draw calls before switching, so the batched and unbatched frames can be compared
+        if (toggleStaticBatching)
+        {
+            cout << "Draw calls per frame: " << stats.Counter("draw_calls") << (useStaticBatching ? " (batched)" : " (unbatched)") << endl;
+            useStaticBatching = !useStaticBatching;
+            toggleStaticBatching = false;
+        }
+        stats.EndFrame();
+
+        CPU_PROFILE_FRAME();
 
         // Swap the buffers
         glfwSwapBuffers(window);
+        benchmark.EndFrame(window, stats.Counters());
     }
 
+    // Delete the GL objects of the render graph, post-processing chain, GPU profiler and stats overlay while the
+    // context still exists
+    graph.Release();
+    chain.Release();
+    gpuProfiler.Release();
+    stats.Release();
     glfwTerminate();
     return 0;
 }
 
 
-void RenderScene(Shader &shader)
+// Depth-only rendering reads the position-only vertex streams, a third of the full vertex size
+void RenderScene(Shader &shader, bool depthOnly)
 {
+    GLint modelLoc = glGetUniformLocation(shader.Program, "model");
+
+    if (useStaticBatching)
+    {
+        // The batch is already in world space; floor and cubes share the wood texture so this is a single draw
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(glm::mat4()));
+        if (depthOnly)
+            sceneBatch.DrawAllDepth();
+        else
+            sceneBatch.DrawAll();
+        return;
+    }
+
     // Floor
-    glm::mat4 model;
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    glBindVertexArray(planeVAO);
+    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(sceneTransforms.GetWorldMatrix(floorNode)));
+    glBindVertexArray(depthOnly ? planeDepthVAO : planeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 6);
     glBindVertexArray(0);
 
     // Cubes
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(0.0f, 1.5f, 0.0));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
-
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(2.0f, 0.0f, 1.0));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
-
-    model = glm::mat4();
-    model = glm::translate(model, glm::vec3(-1.0f, 0.0f, 2.0));
-    model = glm::rotate(model, 60.0f, glm::normalize(glm::vec3(1.0, 0.0, 1.0)));
-    model = glm::scale(model, glm::vec3(0.5));
-    glUniformMatrix4fv(glGetUniformLocation(shader.Program, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    RenderCube();
+    for (GLuint i = 0; i < 3; i++)
+    {
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(sceneTransforms.GetWorldMatrix(cubeNodes[i])));
+        RenderCube(depthOnly);
+    }
 }
 
 
@@ -485,64 +877,105 @@ void RenderQuad()
 }
 
 
+// World-space box around a caster's local bounds
+void CasterWorldBounds(GLuint caster, glm::vec3& boundsMin, glm::vec3& boundsMax)
+{
+    const glm::mat4& world = sceneTransforms.GetWorldMatrix(casterNodes[caster]);
+    boundsMin = glm::vec3(1e30f);
+    boundsMax = glm::vec3(-1e30f);
+    for (GLuint i = 0; i < 8; i++)
+    {
+        glm::vec3 corner(i & 1 ? casterMax[caster].x : casterMin[caster].x,
+                         i & 2 ? casterMax[caster].y : casterMin[caster].y,
+                         i & 4 ? casterMax[caster].z : casterMin[caster].z);
+        glm::vec3 p(world * glm::vec4(corner, 1.0f));
+        boundsMin = glm::min(boundsMin, p);
+        boundsMax = glm::max(boundsMax, p);
+    }
+}
+
+// Draws the casters whose world bounds overlap the given light frustum, one draw each, from the position-only streams
+void RenderCasters(Shader &shader, const Frustum& frustum)
+{
+    GLint modelLoc = glGetUniformLocation(shader.Program, "model");
+    for (GLuint i = 0; i < CASTER_COUNT; i++)
+    {
+        glm::vec3 boundsMin, boundsMax;
+        CasterWorldBounds(i, boundsMin, boundsMax);
+        if (!frustum.IntersectsBox(boundsMin, boundsMax))
+            continue;
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(sceneTransforms.GetWorldMatrix(casterNodes[i])));
+        if (casterNodes[i] == floorNode)
+        {
+            glBindVertexArray(planeDepthVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            glBindVertexArray(0);
+        }
+        else
+            RenderCube(true);
+    }
+}
+
+
 // RenderCube() Renders a 1x1 3D cube in NDC.
+GLfloat cubeVertices[36 * 8] = {
+        // Back face
+        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, // Bottom-left
+        0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f, // top-right
+        0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, // bottom-right         
+        0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f,  // top-right
+        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f,  // bottom-left
+        -0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f,// top-left
+        // Front face
+        -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, // bottom-left
+        0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,  // bottom-right
+        0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,  // top-right
+        0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, // top-right
+        -0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f,  // top-left
+        -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,  // bottom-left
+        // Left face
+        -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-right
+        -0.5f, 0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f, // top-left
+        -0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f,  // bottom-left
+        -0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, // bottom-left
+        -0.5f, -0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f,  // bottom-right
+        -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-right
+        // Right face
+        0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-left
+        0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, // bottom-right
+        0.5f, 0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, // top-right         
+        0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,  // bottom-right
+        0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,  // top-left
+        0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, // bottom-left     
+        // Bottom face
+        -0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, // top-right
+        0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f, // top-left
+        0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f,// bottom-left
+        0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, // bottom-left
+        -0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, // bottom-right
+        -0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, // top-right
+        // Top face
+        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,// top-left
+        0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, // bottom-right
+        0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, // top-right     
+        0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, // bottom-right
+        -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,// top-left
+        -0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f // bottom-left        
+};
 GLuint cubeVAO = 0;
 GLuint cubeVBO = 0;
-void RenderCube()
+GLuint cubeDepthVAO = 0;
+GLuint cubeDepthVBO = 0;
+void RenderCube(bool positionsOnly)
 {
     // Initialize (if necessary)
     if (cubeVAO == 0)
     {
-        GLfloat vertices[] = {
-            // Back face
-            -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, // Bottom-left
-            0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f, // top-right
-            0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, // bottom-right         
-            0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f,  // top-right
-            -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f,  // bottom-left
-            -0.5f, 0.5f, -0.5f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f,// top-left
-            // Front face
-            -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, // bottom-left
-            0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f,  // bottom-right
-            0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,  // top-right
-            0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, // top-right
-            -0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f,  // top-left
-            -0.5f, -0.5f, 0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,  // bottom-left
-            // Left face
-            -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-right
-            -0.5f, 0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f, // top-left
-            -0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f,  // bottom-left
-            -0.5f, -0.5f, -0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, // bottom-left
-            -0.5f, -0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f,  // bottom-right
-            -0.5f, 0.5f, 0.5f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-right
-            // Right face
-            0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, // top-left
-            0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, // bottom-right
-            0.5f, 0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, // top-right         
-            0.5f, -0.5f, -0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f,  // bottom-right
-            0.5f, 0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f,  // top-left
-            0.5f, -0.5f, 0.5f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, // bottom-left     
-            // Bottom face
-            -0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, // top-right
-            0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 1.0f, // top-left
-            0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f,// bottom-left
-            0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 1.0f, 0.0f, // bottom-left
-            -0.5f, -0.5f, 0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, // bottom-right
-            -0.5f, -0.5f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, // top-right
-            // Top face
-            -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,// top-left
-            0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, // bottom-right
-            0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, // top-right     
-            0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, // bottom-right
-            -0.5f, 0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,// top-left
-            -0.5f, 0.5f, 0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f // bottom-left        
-        };
-
         glGenVertexArrays(1, &cubeVAO);
         glGenBuffers(1, &cubeVBO);
         // Fill buffer
         glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
         // Link vertex attributes
         glBindVertexArray(cubeVAO);
         glEnableVertexAttribArray(0);
@@ -553,9 +986,23 @@ void RenderCube()
         glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
         glBindVertexArray(0);
+
+        // Positions only, for depth passes
+        GLfloat cubePositions[36 * 3];
+        for (GLuint i = 0; i < 36; i++)
+            std::copy(cubeVertices + i * 8, cubeVertices + i * 8 + 3, cubePositions + i * 3);
+        glGenVertexArrays(1, &cubeDepthVAO);
+        glGenBuffers(1, &cubeDepthVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, cubeDepthVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(cubePositions), cubePositions, GL_STATIC_DRAW);
+        glBindVertexArray(cubeDepthVAO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
     }
     // Render Cube
-    glBindVertexArray(cubeVAO);
+    glBindVertexArray(positionsOnly ? cubeDepthVAO : cubeVAO);
     glDrawArrays(GL_TRIANGLES, 0, 36);
     glBindVertexArray(0);
 }
@@ -588,31 +1035,41 @@ GLuint loadTexture(const GLchar* path, GLboolean alpha)
 }
 
 
-void configure_filtering_mode()
+// Each key replaces the chain with its effect, 8 clears it
+void configure_filtering_mode(PostProcessChain& chain)
 {
-    if (keys[GLFW_KEY_8])
-        filtering_mode = DEFAULT;
-    else if (keys[GLFW_KEY_I])
-        filtering_mode = INVERT;
-    else if (keys[GLFW_KEY_K])
-        filtering_mode = GRAYSCALE;
-    else if (keys[GLFW_KEY_L])
-        filtering_mode = KERNEL_SHARPEN;
-    else if (keys[GLFW_KEY_O])
-        filtering_mode = KERNEL_BLUR;
-    else if (keys[GLFW_KEY_9])
-        filtering_mode = KERNEL_EDGE_DETECTION;
-    else if (keys[GLFW_KEY_0])
-        filtering_mode = KERNEL_EMBOSS;
-    else if (keys[GLFW_KEY_P])
-        filtering_mode = KERNEL_TOP_SOBEL;
+    const int filterKeys[] = { GLFW_KEY_8, GLFW_KEY_I, GLFW_KEY_K, GLFW_KEY_L, GLFW_KEY_O, GLFW_KEY_9, GLFW_KEY_0, GLFW_KEY_P };
+    for (GLuint i = 0; i < sizeof(filterKeys) / sizeof(filterKeys[0]); i++)
+    {
+        if (!keys[filterKeys[i]])
+            continue;
+        filtering_mode = (filteringMode)i;
+        keys[filterKeys[i]] = false;
+
+        chain.Clear();
+        if (filtering_mode == INVERT)
+            chain.Invert();
+        else if (filtering_mode == GRAYSCALE)
+            chain.Grayscale();
+        else if (filtering_mode == KERNEL_SHARPEN)
+            chain.Sharpen();
+        else if (filtering_mode == KERNEL_BLUR)
+            chain.Blur();
+        else if (filtering_mode == KERNEL_EDGE_DETECTION)
+            chain.EdgeDetection();
+        else if (filtering_mode == KERNEL_EMBOSS)
+            chain.Emboss();
+        else if (filtering_mode == KERNEL_TOP_SOBEL)
+            chain.TopSobel();
+    }
 }
 
-bool keysPressed[1024];
 // Moves/alters the camera positions based on user input
 
 void Do_Movement()
 {
+    CPU_PROFILE_ZONE("Do_Movement");
+
     // Camera controls
     if (keys[GLFW_KEY_W])
         camera.ProcessKeyboard(FORWARD, deltaTime);
@@ -644,6 +1101,31 @@ void Do_Movement()
         usePCF = !usePCF;
         keysPressed[GLFW_KEY_3] = true;
     }
+
+    if (keys[GLFW_KEY_V] && !keysPressed[GLFW_KEY_V])
+    {
+        useCascades = !useCascades;
+        cout << "Cascaded shadow maps " << (useCascades ? "enabled" : "disabled") << endl;
+        keysPressed[GLFW_KEY_V] = true;
+    }
+
+    if (keys[GLFW_KEY_Z] && !keysPressed[GLFW_KEY_Z])
+    {
+        showCascades = !showCascades;
+        keysPressed[GLFW_KEY_Z] = true;
+    }
+
+    if (keys[GLFW_KEY_N] && !keysPressed[GLFW_KEY_N])
+    {
+        animateCaster = !animateCaster;
+        keysPressed[GLFW_KEY_N] = true;
+    }
+
+    if (keys[GLFW_KEY_B] && !keysPressed[GLFW_KEY_B])
+    {
+        toggleStaticBatching = true;
+        keysPressed[GLFW_KEY_B] = true;
+    }
 }
 
 
@@ -653,6 +1135,19 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     //cout << key << endl;
     if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
         glfwSetWindowShouldClose(window, GL_TRUE);
+    if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
+        toggleOverdrawView = true;
+    if (key == GLFW_KEY_F6 && action == GLFW_PRESS)
+        toggleStatsOverlay = true;
+    if (key == GLFW_KEY_F7 && action == GLFW_PRESS)
+        printRenderGraph = true;
+    if (key == GLFW_KEY_F4 && action == GLFW_PRESS)
+    {
+        // Print the last frame's CPU zones and write everything recorded so far as a Chrome trace
+        CpuProfiler::Instance().PrintFrameSummary();
+        if (CpuProfiler::Instance().WriteChromeTrace("cpu_trace.json"))
+            std::cout << "CPU trace written to cpu_trace.json" << std::endl;
+    }
 
     if (key >= 0 && key < 1024)
     {